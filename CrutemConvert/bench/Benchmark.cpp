@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <math.h>
+#include <sstream>
+#include <stdio.h>
+
+#include "Benchmark.h"
+
+
+EMBenchmark	::	EMBenchmark()
+	:
+	fSamples(BENCH_DEFAULT_SAMPLES)
+{
+}
+
+
+EMBenchmark	::	~EMBenchmark()
+{
+}
+
+
+void
+EMBenchmark	::	Add	(const std::string& name, const LBenchFunc& function,
+					int32 samples)
+{
+	_Case benchCase = { name, function, samples };
+	fCases.push_back(benchCase);
+}
+
+
+void
+EMBenchmark	::	SetFilter	(const std::string& filter)
+{
+	fFilter = filter;
+}
+
+
+void
+EMBenchmark	::	SetSamples	(int32 samples)
+{
+	fSamples = std::max(samples, (int32)1);
+}
+
+
+int32
+EMBenchmark	::	Run()
+{
+	fResults.clear();
+	printf("%-32s %12s %8s %12s %12s %12s\n", "CASE", "ITERATIONS",
+		"SAMPLES", "MEDIAN", "P99", "MAX");
+
+	for (const auto& benchCase : fCases) {
+		if (benchCase.name.find(fFilter) == std::string::npos)
+			continue;
+
+		int32 samples = benchCase.samples > 0
+			? std::min(benchCase.samples, fSamples) : fSamples;
+		int64 iterations = _Calibrate(benchCase.function);
+
+		std::vector<double> times(samples);
+		for (int32 i = 0; i < samples; ++i)
+			times[i] = _Time(benchCase.function, iterations) / iterations;
+
+		std::sort(times.begin(), times.end());
+
+		EMBenchResult result;
+		result.name = benchCase.name;
+		result.iterations = iterations;
+		result.samples = samples;
+		result.median = samples % 2 == 1 ? times[samples / 2]
+			: (times[samples / 2 - 1] + times[samples / 2]) / 2;
+		result.p99 = times[(int32)ceil(0.99 * samples) - 1];
+		result.max = times[samples - 1];
+		fResults.push_back(result);
+
+		printf("%-32s %12lli %8li %12s %12s %12s\n", result.name.c_str(),
+			result.iterations, result.samples,
+			FormatTime(result.median).c_str(),
+			samples >= BENCH_P99_MIN_SAMPLES
+				? FormatTime(result.p99).c_str() : "-",
+			FormatTime(result.max).c_str());
+		fflush(stdout);
+	}
+
+	return fResults.size();
+}
+
+
+const std::vector<EMBenchResult>&
+EMBenchmark	::	Results() const
+{
+	return fResults;
+}
+
+
+bool
+EMBenchmark	::	Save	(const std::string& path) const
+{
+	FILE* file = fopen(path.c_str(), "w");
+	if (file == NULL)
+		return false;
+
+	fprintf(file, "# crucon-bench baseline: name, median ns, p99 ns, "
+		"max ns, iterations per sample\n");
+	for (const auto& result : fResults) {
+		char p99[32] = "-";
+		if (result.samples >= BENCH_P99_MIN_SAMPLES)
+			snprintf(p99, sizeof(p99), "%.3f", result.p99);
+
+		fprintf(file, "%s\t%.3f\t%s\t%.3f\t%lli\n", result.name.c_str(),
+			result.median, p99, result.max, result.iterations);
+	}
+
+	return fclose(file) == 0;
+}
+
+
+int32
+EMBenchmark	::	Compare	(const std::string& path, double tolerance) const
+{
+	std::ifstream file(path.c_str());
+	if (file.fail())
+		return -1;
+
+	std::map<std::string, double> baseline;
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream fields(line);
+		std::string name;
+		double median;
+		if (std::getline(fields, name, '\t') && fields >> median)
+			baseline[name] = median;
+	}
+
+	printf("\nAgainst \"%s\" (%.0f%% tolerance):\n", path.c_str(),
+		tolerance * 100);
+	printf("%-32s %12s %12s %9s\n", "CASE", "BASELINE", "NOW", "CHANGE");
+
+	int32 regressions = 0;
+	for (const auto& result : fResults) {
+		auto found = baseline.find(result.name);
+		if (found == baseline.end()) {
+			printf("%-32s %12s %12s\n", result.name.c_str(), "-",
+				FormatTime(result.median).c_str());
+			continue;
+		}
+
+		double change = result.median / found->second - 1;
+		bool slower = change > tolerance;
+		if (slower)
+			++regressions;
+
+		printf("%-32s %12s %12s %+8.1f%%%s\n", result.name.c_str(),
+			FormatTime(found->second).c_str(),
+			FormatTime(result.median).c_str(), change * 100,
+			slower ? "  SLOWER" : change < -tolerance ? "  faster" : "");
+	}
+
+	printf("%li regression(s)\n", regressions);
+	return regressions;
+}
+
+
+std::string
+EMBenchmark	::	FormatTime	(double ns)
+{
+	char text[32];
+	if (ns < 1e3)
+		snprintf(text, sizeof(text), "%.2f ns", ns);
+	else if (ns < 1e6)
+		snprintf(text, sizeof(text), "%.2f us", ns / 1e3);
+	else if (ns < 1e9)
+		snprintf(text, sizeof(text), "%.2f ms", ns / 1e6);
+	else
+		snprintf(text, sizeof(text), "%.2f s", ns / 1e9);
+
+	return text;
+}
+
+
+//#pragma mark private
+
+
+double
+EMBenchmark	::	_Time	(const LBenchFunc& function, int64 iterations)
+{	// ns for the lot
+	auto start = std::chrono::steady_clock::now();
+	function(iterations);
+	auto end = std::chrono::steady_clock::now();
+
+	return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+
+int64
+EMBenchmark	::	_Calibrate	(const LBenchFunc& function)
+{	// doubling until a sample is long enough; this is the warm up, too
+	int64 iterations = 1;
+	while (_Time(function, iterations) < BENCH_MIN_SAMPLE_NS
+		&& iterations < (1LL << 40))
+		iterations *= 2;
+
+	return iterations;
+}
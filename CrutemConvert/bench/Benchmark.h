@@ -0,0 +1,116 @@
+#ifndef EM_BENCHMARK_H
+#define EM_BENCHMARK_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "StdTypedefs.h"
+
+/*
+	The timing harness behind crucon-bench.
+
+	A case is a function running what it measures `iterations` times.  Run()
+	finds an iteration count keeping each sample above BENCH_MIN_SAMPLE_NS,
+	so the clock's resolution doesn't show, then times that many samples of
+	it and reports the time per iteration as the median, the 99th
+	percentile (nearest rank) and the slowest sample.  Below
+	BENCH_P99_MIN_SAMPLES samples the nearest rank is the slowest sample,
+	so no 99th percentile is shown.
+
+		EMBenchmark bench;
+		bench.Add("date/DaysFrom", [&](int64 iterations) {
+			for (int64 i = 0; i < iterations; ++i)
+				LKeep(start.DaysFrom(dates[i & 1023]));
+		});
+		bench.Run();
+		bench.Save("baseline.txt");
+
+	Cases doing a whole run of something - an ingest - can take fewer
+	samples, given to Add(), and report only their median and slowest.
+	Run() goes through the cases in the order added, skipping those not
+	containing the filter, and prints a line for each as it finishes.
+
+	A saved baseline is plain text, a case per line, with the same columns
+	as the report ("-" for no 99th percentile):
+
+		name	median ns	p99 ns	max ns	iterations per sample
+
+	Compare() prints each case against it and counts those whose median is
+	slower by more than the tolerance (0.10 is 10%).
+*/
+
+#define	BENCH_DEFAULT_SAMPLES	101
+#define	BENCH_P99_MIN_SAMPLES	100
+#define	BENCH_MIN_SAMPLE_NS		2000000		// 2 ms
+#define	BENCH_TOLERANCE			0.10
+
+
+typedef std::function<void(int64 iterations)> LBenchFunc;
+
+
+// Keeps the compiler from dropping a result nothing else reads.
+template <typename T>
+inline void
+LKeep(const T& value)
+{
+	__asm__ __volatile__("" : : "r"(&value) : "memory");
+}
+
+
+struct EMBenchResult {
+	std::string			name;
+	int64				iterations;		// per sample
+	int32				samples;
+	double				median;			// ns per iteration
+	double				p99;			// the max below 100 samples
+	double				max;
+};
+
+
+class	EMBenchmark {
+public:
+								EMBenchmark();
+	virtual						~EMBenchmark();
+
+			// samples = 0 takes the default
+			void				Add			(const std::string& name,
+											const LBenchFunc&,
+											int32 samples = 0);
+
+			void				SetFilter	(const std::string&);
+			void				SetSamples	(int32);	// the default
+
+			// Returns the number of cases run.
+			int32				Run			();
+
+			const std::vector<EMBenchResult>&	Results() const;
+
+			bool				Save		(const std::string& path) const;
+
+			// Returns the number of regressions, or -1 without a baseline.
+			int32				Compare		(const std::string& path,
+											double tolerance
+												= BENCH_TOLERANCE) const;
+
+	static	std::string			FormatTime	(double ns);
+
+private:
+		struct _Case {
+			std::string			name;
+			LBenchFunc			function;
+			int32				samples;
+		};
+
+	static	double				_Time		(const LBenchFunc&,
+											int64 iterations);
+	static	int64				_Calibrate	(const LBenchFunc&);
+
+		std::vector<_Case>		fCases;
+		std::vector<EMBenchResult>	fResults;
+		std::string				fFilter;
+		int32					fSamples;
+};
+
+
+#endif // EM_BENCHMARK_H
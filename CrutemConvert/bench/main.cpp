@@ -0,0 +1,520 @@
+/*
+	crucon-bench
+		Repeatable timings of the pieces crucon spends its time in, from
+		Split() up to a whole ingest, on the bundled station files and on
+		generated ones of any size.
+
+			crucon-bench [-filter=text] [-samples=n] [-stations=n]
+						[-data=directory] [-save=file] [-compare=file]
+						[-tolerance=percent]
+
+		-save writes the results as a baseline; -compare prints them against
+		one and exits with 1 when any case got slower than the tolerance
+		allows (10% by default).  Run from the project directory, the bundled
+		data is found in data/.
+*/
+
+#include <fcntl.h>
+#include <memory>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "Benchmark.h"
+#include "Date.h"
+#include "GridPyramid.h"
+#include "IDAvgAccum.h"
+#include "MathUtils.h"
+#include "OutputWriter.h"
+#include "StationIndex.h"
+#include "StationListFormat.h"
+#include "StationParser.h"
+#include "StationSearch.h"
+#include "StdTypedefs.h"
+#include "SyntheticData.h"
+#include "Temperature.h"
+
+
+#define	BENCH_MACRO_SAMPLES		5		// for whole ingests and builds
+#define	BENCH_STATIONS			4800	// generated, about the bundled count
+#define	BENCH_SEED				SYNTHETIC_DEFAULT_SEED
+#define	BENCH_INPUTS			4096	// per case, cycled through
+
+
+// Silences stdout while in scope, for ParseFile()'s progress.
+class	_Quiet {
+public:
+	_Quiet()
+	{
+		fflush(stdout);
+		fSaved = dup(STDOUT_FILENO);
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, STDOUT_FILENO);
+		close(null);
+	}
+
+	~_Quiet()
+	{
+		fflush(stdout);
+		dup2(fSaved, STDOUT_FILENO);
+		close(fSaved);
+	}
+
+private:
+	int fSaved;
+};
+
+
+struct _Dataset {
+	LStringList				header;
+	LStringList				data;
+	LStringList				ignore;
+	std::vector<int32>		dataIndex;		// per header line, or -1
+	std::vector<Station*>	stations;
+};
+
+
+static bool
+_FileExists(const std::string& path)
+{
+	return access(path.c_str(), R_OK) == 0;
+}
+
+
+static int32
+_Ingest(_Dataset& set)
+{	// as crucon does it, ignore list and all; returns the stations kept
+	for (Station* station : set.stations)
+		delete station;
+	set.stations.clear();
+	set.dataIndex.assign(set.header.size(), -1);
+
+	int32 dataIndex = 0;
+	for (size_t i = 0; i < set.header.size(); ++i) {
+		bool ignore = false;
+		for (const auto& entry : set.ignore) {
+			if (set.header[i].find(entry) != std::string::npos) {
+				ignore = true;
+				break;
+			}
+		}
+
+		if (ignore)
+			continue;
+
+		Station* station = new Station();
+		if (ParseStation(set.header[i], set.data, *station, dataIndex) != "") {
+			delete station;
+			continue;
+		}
+
+		set.dataIndex[i] = dataIndex;
+		set.stations.push_back(station);
+	}
+
+	return set.stations.size();
+}
+
+
+static int32
+_IngestFiles(_Dataset& set, const std::string& headerPath,
+	const std::string& dataPath, const std::string& ignorePath)
+{
+	_Quiet quiet;
+	ParseFile(headerPath.c_str(), set.header);
+	ParseFile(dataPath.c_str(), set.data);
+	if (!ignorePath.empty())
+		ParseFile(ignorePath.c_str(), set.ignore);
+
+	return _Ingest(set);
+}
+
+
+static void
+_Annual(const std::vector<Station*>& stations,
+	IDAvgAccum<uint32, double>& global)
+{	// the per station pass of crucon's calculations
+	for (Station* station : stations) {
+		int32 years = station->ENDYEAR - station->STARTYEAR;
+		for (int32 j = 0; j < years; ++j) {
+			YearData& yd = station->DATA[j];
+			double sum = 0;
+			int32 valid = 0;
+			for (int16 month = 1; month <= 12; ++month) {
+				float value = yd.MonthValue(month);
+				if (value > -99) {
+					sum += value;
+					++valid;
+				}
+			}
+
+			if (valid > 0)
+				global.add(station->STARTYEAR + j, sum / valid);
+		}
+	}
+}
+
+
+static void
+_AddCases(EMBenchmark& bench, _Dataset& set, const std::string& name,
+	const std::string& headerPath, const std::string& dataPath,
+	const std::string& ignorePath)
+{	// the cases that depend on the data set, named "<case>/<set>"
+	const std::vector<Station*>& stations = set.stations;
+	const int32 count = stations.size();
+
+	std::mt19937 random(BENCH_SEED);
+
+	bench.Add("ingest/" + name, [=](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			_Dataset scratch;
+			LKeep(_IngestFiles(scratch, headerPath, dataPath, ignorePath));
+			for (Station* station : scratch.stations)
+				delete station;
+		}
+	}, BENCH_MACRO_SAMPLES);
+
+	// header lines which parsed, with where their data starts
+	std::vector<int32> parsed;
+	for (size_t i = 0; i < set.header.size(); ++i) {
+		if (set.dataIndex[i] >= 0)
+			parsed.push_back(i);
+	}
+
+	bench.Add("ParseStation/" + name, [&set, parsed](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			int32 line = parsed[i % parsed.size()],
+				dataIndex = set.dataIndex[line];
+			Station station;
+			LKeep(ParseStation(set.header[line], set.data, station,
+				dataIndex));
+		}
+	});
+
+	bench.Add("annual/" + name, [&stations](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			IDAvgAccum<uint32, double> global;
+			_Annual(stations, global);
+			LKeep(global);
+		}
+	});
+
+	// month ranges within each station's span
+	struct Range { Station* station; EMMonthIndex from, to; };
+	std::vector<Range> ranges(BENCH_INPUTS);
+	for (auto& range : ranges) {
+		Station* station = stations[random() % count];
+		int32 span = (station->ENDYEAR - station->STARTYEAR) * 12,
+			first = random() % span;
+		range.station = station;
+		range.from = EMMonthIndex(station->STARTYEAR, 1);
+		range.from += first;
+		range.to = range.from;
+		range.to += 1 + random() % (span - first);
+	}
+
+	for (Station* station : stations)
+		station->PrepareRanges();
+
+	bench.Add("AverageFor range/" + name, [ranges](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			const Range& range = ranges[i % BENCH_INPUTS];
+			LKeep(range.station->AverageFor(range.from, range.to));
+		}
+	});
+
+	bench.Add("AverageFor date/" + name, [ranges](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			const Range& range = ranges[i % BENCH_INPUTS];
+			EMDate date(range.from.Year(), range.from.Month());
+			LKeep(range.station->AverageFor(date));
+		}
+	});
+
+	bench.Add("grid CellFor/" + name, [&stations](int64 iterations) {
+		EMGridPyramid pyramid;
+		for (int64 i = 0; i < iterations; ++i) {
+			const Station* station = stations[i % stations.size()];
+			LKeep(pyramid.CellFor(0, station->LAT, station->LON));
+		}
+	});
+
+	bench.Add("grid Build/" + name, [&stations](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			EMGridPyramid pyramid;
+			pyramid.Build(stations);
+			LKeep(pyramid);
+		}
+	}, BENCH_MACRO_SAMPLES);
+
+	// the spatial queries, from points near stations
+	std::vector<EMPoint> points(BENCH_INPUTS);
+	for (auto& point : points) {
+		const Station* station = stations[random() % count];
+		point = EMPoint(station->LON + 0.5, station->LAT - 0.5);
+	}
+
+	auto index = std::make_shared<EMStationIndex>();
+	index->Build(stations);
+
+	bench.Add("index KNearest 8/" + name, [index, points](int64 iterations) {
+		std::vector<EMStationHit> hits;
+		for (int64 i = 0; i < iterations; ++i)
+			LKeep(index->KNearest(points[i % BENCH_INPUTS], 8, hits));
+	});
+
+	bench.Add("index Radius 500km/" + name, [index, points](int64 iterations) {
+		std::vector<EMStationHit> hits;
+		for (int64 i = 0; i < iterations; ++i)
+			LKeep(index->Radius(points[i % BENCH_INPUTS], 500, hits));
+	});
+
+	std::vector<EMPoint> locations;
+	for (const Station* station : stations)
+		locations.push_back(EMPoint(station->LON, station->LAT));
+
+	auto vectors = std::make_shared<EMUnitVectors>();
+	LUnitVectors(locations.data(), locations.size(), *vectors);
+
+	bench.Add("LDistances 1xN/" + name, [vectors, points](int64 iterations) {
+		std::vector<float> distances(vectors->x.size());
+		for (int64 i = 0; i < iterations; ++i) {
+			LDistances(points[i % BENCH_INPUTS], *vectors, EARTH_RADIUS_KM,
+				distances.data());
+			LKeep(distances[0]);
+		}
+	});
+
+	auto search = std::make_shared<EMStationSearch>();
+	search->Build(stations);
+
+	std::vector<std::string> queries;
+	for (int32 i = 0; i < BENCH_INPUTS; ++i) {
+		const Station* station = stations[random() % count];
+		std::string name = EMStationSearch::Normalize(station->NAME);
+		queries.push_back(name.substr(0, name.find(' ')));
+	}
+
+	bench.Add("search Find/" + name, [search, queries](int64 iterations) {
+		std::vector<int32> found;
+		for (int64 i = 0; i < iterations; ++i)
+			LKeep(search->Find(queries[i % BENCH_INPUTS], found));
+	});
+}
+
+
+static void
+_AddMicroCases(EMBenchmark& bench, const _Dataset& set)
+{	// the cases whose inputs are made up on the spot
+	std::mt19937 random(BENCH_SEED);
+	std::uniform_real_distribution<float> unit(0.0, 1.0);
+
+	const std::string headerLine = set.header.front(),
+		dataLine = set.data[1];
+
+	bench.Add("Split header line", [headerLine](int64 iterations) {
+		LStringList out;
+		for (int64 i = 0; i < iterations; ++i) {
+			out.clear();
+			LKeep(Split(headerLine, ' ', out));
+		}
+	});
+
+	bench.Add("Split data line", [dataLine](int64 iterations) {
+		LStringList out;
+		for (int64 i = 0; i < iterations; ++i) {
+			out.clear();
+			LKeep(Split(dataLine, ' ', out));
+		}
+	});
+
+	std::vector<uint32> years(BENCH_INPUTS);
+	std::vector<double> values(BENCH_INPUTS);
+	for (int32 i = 0; i < BENCH_INPUTS; ++i) {
+		years[i] = 1850 + random() % 162;
+		values[i] = unit(random) * 30;
+	}
+
+	bench.Add("IDAvgAccum add", [years, values](int64 iterations) {
+		IDAvgAccum<uint32, double> accum;
+		for (int64 i = 0; i < iterations; ++i)
+			accum.add(years[i % BENCH_INPUTS], values[i % BENCH_INPUTS]);
+		LKeep(accum);
+	});
+
+	std::vector<EMDate> dates;
+	for (int32 i = 0; i < BENCH_INPUTS; ++i) {
+		dates.push_back(EMDate(1700 + random() % 400, 1 + random() % 12,
+			1 + random() % 28));
+	}
+
+	bench.Add("EMDate DaysFrom", [dates](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			LKeep(dates[i % BENCH_INPUTS].DaysFrom(
+				dates[(i + 1) % BENCH_INPUTS]));
+		}
+	});
+
+	std::vector<EMPoint> points(BENCH_INPUTS);
+	for (auto& point : points)
+		point = EMPoint(unit(random) * 360 - 180, unit(random) * 180 - 90);
+
+	bench.Add("LDistance", [points](int64 iterations) {
+		for (int64 i = 0; i < iterations; ++i) {
+			LKeep(LDistance(points[i % BENCH_INPUTS],
+				points[(i + 1) % BENCH_INPUTS], EARTH_RADIUS_KM));
+		}
+	});
+
+	std::vector<float> temperatures(BENCH_INPUTS), converted(BENCH_INPUTS);
+	for (auto& temperature : temperatures)
+		temperature = unit(random) < 0.05 ? -99.9 : unit(random) * 60 - 30;
+
+	bench.Add("LConvertTemperatures 4096", [temperatures](int64 iterations) {
+		std::vector<float> out(BENCH_INPUTS);
+		for (int64 i = 0; i < iterations; ++i) {
+			LConvertTemperatures(Celsius, Fahrenheit, temperatures.data(),
+				out.data(), BENCH_INPUTS);
+			LKeep(out[0]);
+		}
+	});
+
+	bench.Add("LFormatFixed", [temperatures](int64 iterations) {
+		char text[LFORMAT_MAX];
+		for (int64 i = 0; i < iterations; ++i)
+			LKeep(LFormatFixed(text, temperatures[i % BENCH_INPUTS], 2));
+	});
+
+	bench.Add("LFormatShortest", [temperatures](int64 iterations) {
+		char text[LFORMAT_MAX];
+		for (int64 i = 0; i < iterations; ++i)
+			LKeep(LFormatShortest(text, temperatures[i % BENCH_INPUTS]));
+	});
+
+	bench.Add("LFormatInt", [years](int64 iterations) {
+		char text[LFORMAT_MAX];
+		for (int64 i = 0; i < iterations; ++i)
+			LKeep(LFormatInt(text, years[i % BENCH_INPUTS] * 1009));
+	});
+}
+
+
+static void
+_Usage()
+{
+	printf("crucon-bench [-filter=text] [-samples=n] [-stations=n]\n"
+		"             [-data=directory] [-save=file] [-compare=file]\n"
+		"             [-tolerance=percent]\n");
+}
+
+
+int main(int argc, char** argv)
+{
+	std::string filter, dataDirectory = "data", savePath, comparePath;
+	int32 samples = BENCH_DEFAULT_SAMPLES,
+		stationCount = BENCH_STATIONS;
+	double tolerance = BENCH_TOLERANCE;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i], value;
+		size_t equals = arg.find('=');
+		if (equals != std::string::npos) {
+			value = arg.substr(equals + 1);
+			arg.resize(equals);
+		}
+
+		if (arg == "-filter")
+			filter = value;
+		else if (arg == "-samples")
+			samples = atol(value.c_str());
+		else if (arg == "-stations")
+			stationCount = atol(value.c_str());
+		else if (arg == "-data")
+			dataDirectory = value;
+		else if (arg == "-save")
+			savePath = value;
+		else if (arg == "-compare")
+			comparePath = value;
+		else if (arg == "-tolerance")
+			tolerance = atof(value.c_str()) / 100;
+		else {
+			_Usage();
+			return arg == "-help" ? 0 : 1;
+		}
+	}
+
+	EMBenchmark bench;
+	bench.SetFilter(filter);
+	bench.SetSamples(samples);
+
+	// the bundled files, when the data file is in place
+	_Dataset bundled;
+	std::string bundledHeader = dataDirectory + "/header.txt",
+		bundledData = dataDirectory + "/data.txt",
+		bundledIgnore = dataDirectory + "/missing.txt";
+	if (!_FileExists(bundledIgnore))
+		bundledIgnore = "";
+
+	if (_FileExists(bundledHeader) && _FileExists(bundledData)) {
+		_IngestFiles(bundled, bundledHeader, bundledData, bundledIgnore);
+		printf("Bundled: %li stations from \"%s\"\n",
+			(int32)bundled.stations.size(), dataDirectory.c_str());
+	} else
+		printf("Bundled: no %s, skipped\n", bundledData.c_str());
+
+	// generated, and read back as the bundled files are
+	_Dataset synthetic;
+	const char* temp = getenv("TMPDIR");
+	std::string base = std::string(temp != NULL ? temp : "/tmp")
+		+ "/crucon-bench-" + ::to_string((int32)getpid()),
+		syntheticHeader = base + "-header.txt",
+		syntheticData = base + "-data.txt";
+
+	EMSyntheticData generator(stationCount);
+	if (generator.Write(syntheticHeader, syntheticData) < 0) {
+		printf("ERROR: unable to write \"%s\"\n", syntheticData.c_str());
+		return 2;
+	}
+
+	_IngestFiles(synthetic, syntheticHeader, syntheticData, "");
+	printf("Synthetic: %li stations, %li data lines\n\n",
+		(int32)synthetic.stations.size(), (int32)synthetic.data.size());
+
+	_AddMicroCases(bench, bundled.stations.empty() ? synthetic : bundled);
+	if (!bundled.stations.empty()) {
+		_AddCases(bench, bundled, "bundled", bundledHeader, bundledData,
+			bundledIgnore);
+	}
+	_AddCases(bench, synthetic, "synthetic", syntheticHeader, syntheticData,
+		"");
+
+	bench.Run();
+
+	unlink(syntheticHeader.c_str());
+	unlink(syntheticData.c_str());
+
+	int result = 0;
+	if (!comparePath.empty()) {
+		int32 regressions = bench.Compare(comparePath, tolerance);
+		if (regressions < 0) {
+			printf("ERROR: unable to read \"%s\"\n", comparePath.c_str());
+			result = 2;
+		} else if (regressions > 0)
+			result = 1;
+	}
+
+	if (!savePath.empty()) {
+		if (bench.Save(savePath))
+			printf("Saved baseline to \"%s\"\n", savePath.c_str());
+		else {
+			printf("ERROR: unable to write \"%s\"\n", savePath.c_str());
+			result = 2;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,168 @@
+/*
+	crucon-gen
+		Writes made up station files in the CRUTEM layout crucon reads, of
+		any size, for seeing how it copes at ten or a hundred times the real
+		data set:
+
+			crucon-gen [-stations=n] [-seed=n] [-years=first,last]
+						[-span=min,max] [-missing=percent]
+						[-layout=uniform|clustered|like:header.txt]
+						[-output=directory]
+
+		The directory (data/synthetic by default) gets header.txt and
+		data.txt, to be read with crucon -header=... -data=...  The same
+		settings always give the same files.
+*/
+
+#include <chrono>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "StationParser.h"
+#include "StdTypedefs.h"
+#include "SyntheticData.h"
+
+
+#define	GEN_DEFAULT_STATIONS	48000		// ten times the real list
+#define	GEN_DEFAULT_OUTPUT		"data/synthetic"
+
+
+static bool
+_Pair(const std::string& value, int32& first, int32& second)
+{	// "a,b"
+	size_t comma = value.find(',');
+	if (comma == std::string::npos)
+		return false;
+
+	first = atol(value.c_str());
+	second = atol(value.c_str() + comma + 1);
+	return true;
+}
+
+
+static bool
+_Centers(const std::string& headerPath, std::vector<EMPoint>& centers)
+{	// every station in a real header file
+	LStringList header;
+	if (ParseFile(headerPath.c_str(), header) != "")
+		return false;
+
+	LStringList fields;
+	for (const auto& line : header) {
+		fields.clear();
+		Split(line, ' ', fields);
+		if (fields.size() < 4)
+			continue;
+
+		centers.push_back(EMPoint(-atof(fields[2].c_str()) / 10.0,
+			atof(fields[1].c_str()) / 10.0));
+	}
+
+	return !centers.empty();
+}
+
+
+static void
+_Usage()
+{
+	printf("crucon-gen [-stations=n] [-seed=n] [-years=first,last]\n"
+		"           [-span=min,max] [-missing=percent]\n"
+		"           [-layout=uniform|clustered|like:header.txt]\n"
+		"           [-output=directory]\n");
+}
+
+
+int main(int argc, char** argv)
+{
+	int32 stations = GEN_DEFAULT_STATIONS,
+		firstYear = 1750, lastYear = 2011,
+		minSpan = 20, maxSpan = 160;
+	uint64_t seed = SYNTHETIC_DEFAULT_SEED;
+	double missing = 5;
+	std::string layout = "uniform", output = GEN_DEFAULT_OUTPUT;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i], value;
+		size_t equals = arg.find('=');
+		if (equals != std::string::npos) {
+			value = arg.substr(equals + 1);
+			arg.resize(equals);
+		}
+
+		bool valid = true;
+		if (arg == "-stations")
+			stations = atol(value.c_str());
+		else if (arg == "-seed")
+			seed = strtoull(value.c_str(), NULL, 10);
+		else if (arg == "-years")
+			valid = _Pair(value, firstYear, lastYear);
+		else if (arg == "-span")
+			valid = _Pair(value, minSpan, maxSpan);
+		else if (arg == "-missing")
+			missing = atof(value.c_str());
+		else if (arg == "-layout")
+			layout = value;
+		else if (arg == "-output")
+			output = value;
+		else
+			valid = false;
+
+		if (!valid) {
+			_Usage();
+			return arg == "-help" ? 0 : 1;
+		}
+	}
+
+	if (stations <= 0 || stations > SYNTHETIC_MAX_STATIONS) {
+		printf("ERROR: between 1 and %li stations, please\n",
+			(int32)SYNTHETIC_MAX_STATIONS);
+		return 1;
+	}
+
+	EMSyntheticData synthetic(stations, seed);
+	synthetic.SetYears(firstYear, lastYear);
+	synthetic.SetSpan(minSpan, maxSpan);
+	synthetic.SetMissingRate(missing / 100);
+
+	if (layout == "clustered")
+		synthetic.SetLayout(SYNTHETIC_CLUSTERED);
+	else if (layout.find("like:") == 0) {
+		std::vector<EMPoint> centers;
+		if (!_Centers(layout.substr(5), centers)) {
+			printf("ERROR: no stations in \"%s\"\n", layout.c_str() + 5);
+			return 2;
+		}
+		synthetic.SetCenters(centers);
+	} else if (layout != "uniform") {
+		_Usage();
+		return 1;
+	}
+
+	if (mkdir(output.c_str(), 0755) != 0 && errno != EEXIST) {
+		printf("ERROR: unable to create \"%s\"\n", output.c_str());
+		return 2;
+	}
+
+	std::string headerPath = output + "/header.txt",
+		dataPath = output + "/data.txt";
+	printf("Writing %li stations to \"%s\"...\n", stations, output.c_str());
+	fflush(stdout);
+
+	auto start = std::chrono::steady_clock::now();
+	int64 written = synthetic.Write(headerPath, dataPath);
+	double seconds = std::chrono::duration<double>(
+		std::chrono::steady_clock::now() - start).count();
+
+	if (written < 0) {
+		printf("ERROR: unable to write \"%s\"\n", dataPath.c_str());
+		return 2;
+	}
+
+	printf("\tWrote %.1f MB in %.2f s (%.0f MB/s)\n", written / 1048576.0,
+		seconds, written / 1048576.0 / seconds);
+	return 0;
+}
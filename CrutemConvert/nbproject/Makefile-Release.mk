@@ -35,14 +35,36 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/src/AreaTable.o \
+	${OBJECTDIR}/src/Bootstrap.o \
 	${OBJECTDIR}/src/CoordCell.o \
+	${OBJECTDIR}/src/Correlation.o \
+	${OBJECTDIR}/src/DailySeries.o \
 	${OBJECTDIR}/src/Date.o \
+	${OBJECTDIR}/src/DateIndex.o \
 	${OBJECTDIR}/src/EarthCoordSystem.o \
+	${OBJECTDIR}/src/GridCube.o \
+	${OBJECTDIR}/src/GridPyramid.o \
+	${OBJECTDIR}/src/Homogenize.o \
+	${OBJECTDIR}/src/Infill.o \
+	${OBJECTDIR}/src/MapRenderer.o \
 	${OBJECTDIR}/src/MathUtils.o \
+	${OBJECTDIR}/src/OutputWriter.o \
+	${OBJECTDIR}/src/Parallel.o \
 	${OBJECTDIR}/src/ParseArgs.o \
+	${OBJECTDIR}/src/PortStream.o \
+	${OBJECTDIR}/src/QueryServer.o \
 	${OBJECTDIR}/src/Rect.o \
+	${OBJECTDIR}/src/SeriesTable.o \
+	${OBJECTDIR}/src/SharedDataset.o \
+	${OBJECTDIR}/src/StationExport.o \
+	${OBJECTDIR}/src/StationIndex.o \
 	${OBJECTDIR}/src/StationListFormat.o \
+	${OBJECTDIR}/src/StationParser.o \
+	${OBJECTDIR}/src/StationSearch.o \
+	${OBJECTDIR}/src/Stats.o \
 	${OBJECTDIR}/src/StdTypedefs.o \
+	${OBJECTDIR}/src/SyntheticData.o \
 	${OBJECTDIR}/src/Temperature.o \
 	${OBJECTDIR}/src/main.o
 
@@ -61,7 +83,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=
+LDLIBSOPTIONS=-lpthread
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -71,46 +93,156 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/crutemconvert.exe: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.cc} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/crutemconvert ${OBJECTFILES} ${LDLIBSOPTIONS}
 
+${OBJECTDIR}/src/AreaTable.o: nbproject/Makefile-${CND_CONF}.mk src/AreaTable.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/AreaTable.o src/AreaTable.cpp
+
+${OBJECTDIR}/src/Bootstrap.o: nbproject/Makefile-${CND_CONF}.mk src/Bootstrap.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Bootstrap.o src/Bootstrap.cpp
+
 ${OBJECTDIR}/src/CoordCell.o: nbproject/Makefile-${CND_CONF}.mk src/CoordCell.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/CoordCell.o src/CoordCell.cpp
 
+${OBJECTDIR}/src/Correlation.o: nbproject/Makefile-${CND_CONF}.mk src/Correlation.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Correlation.o src/Correlation.cpp
+
+${OBJECTDIR}/src/DailySeries.o: nbproject/Makefile-${CND_CONF}.mk src/DailySeries.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/DailySeries.o src/DailySeries.cpp
+
 ${OBJECTDIR}/src/Date.o: nbproject/Makefile-${CND_CONF}.mk src/Date.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Date.o src/Date.cpp
 
+${OBJECTDIR}/src/DateIndex.o: nbproject/Makefile-${CND_CONF}.mk src/DateIndex.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/DateIndex.o src/DateIndex.cpp
+
 ${OBJECTDIR}/src/EarthCoordSystem.o: nbproject/Makefile-${CND_CONF}.mk src/EarthCoordSystem.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/EarthCoordSystem.o src/EarthCoordSystem.cpp
 
+${OBJECTDIR}/src/GridCube.o: nbproject/Makefile-${CND_CONF}.mk src/GridCube.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/GridCube.o src/GridCube.cpp
+
+${OBJECTDIR}/src/GridPyramid.o: nbproject/Makefile-${CND_CONF}.mk src/GridPyramid.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/GridPyramid.o src/GridPyramid.cpp
+
+${OBJECTDIR}/src/Homogenize.o: nbproject/Makefile-${CND_CONF}.mk src/Homogenize.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Homogenize.o src/Homogenize.cpp
+
+${OBJECTDIR}/src/Infill.o: nbproject/Makefile-${CND_CONF}.mk src/Infill.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Infill.o src/Infill.cpp
+
+${OBJECTDIR}/src/MapRenderer.o: nbproject/Makefile-${CND_CONF}.mk src/MapRenderer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/MapRenderer.o src/MapRenderer.cpp
+
 ${OBJECTDIR}/src/MathUtils.o: nbproject/Makefile-${CND_CONF}.mk src/MathUtils.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/MathUtils.o src/MathUtils.cpp
 
+${OBJECTDIR}/src/OutputWriter.o: nbproject/Makefile-${CND_CONF}.mk src/OutputWriter.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/OutputWriter.o src/OutputWriter.cpp
+
+${OBJECTDIR}/src/Parallel.o: nbproject/Makefile-${CND_CONF}.mk src/Parallel.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Parallel.o src/Parallel.cpp
+
 ${OBJECTDIR}/src/ParseArgs.o: nbproject/Makefile-${CND_CONF}.mk src/ParseArgs.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/ParseArgs.o src/ParseArgs.cpp
 
+${OBJECTDIR}/src/PortStream.o: nbproject/Makefile-${CND_CONF}.mk src/PortStream.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/PortStream.o src/PortStream.cpp
+
+${OBJECTDIR}/src/QueryServer.o: nbproject/Makefile-${CND_CONF}.mk src/QueryServer.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/QueryServer.o src/QueryServer.cpp
+
 ${OBJECTDIR}/src/Rect.o: nbproject/Makefile-${CND_CONF}.mk src/Rect.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Rect.o src/Rect.cpp
 
+${OBJECTDIR}/src/SeriesTable.o: nbproject/Makefile-${CND_CONF}.mk src/SeriesTable.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/SeriesTable.o src/SeriesTable.cpp
+
+${OBJECTDIR}/src/SharedDataset.o: nbproject/Makefile-${CND_CONF}.mk src/SharedDataset.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/SharedDataset.o src/SharedDataset.cpp
+
+${OBJECTDIR}/src/StationExport.o: nbproject/Makefile-${CND_CONF}.mk src/StationExport.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StationExport.o src/StationExport.cpp
+
+${OBJECTDIR}/src/StationIndex.o: nbproject/Makefile-${CND_CONF}.mk src/StationIndex.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StationIndex.o src/StationIndex.cpp
+
 ${OBJECTDIR}/src/StationListFormat.o: nbproject/Makefile-${CND_CONF}.mk src/StationListFormat.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StationListFormat.o src/StationListFormat.cpp
 
+${OBJECTDIR}/src/StationParser.o: nbproject/Makefile-${CND_CONF}.mk src/StationParser.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StationParser.o src/StationParser.cpp
+
+${OBJECTDIR}/src/StationSearch.o: nbproject/Makefile-${CND_CONF}.mk src/StationSearch.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StationSearch.o src/StationSearch.cpp
+
+${OBJECTDIR}/src/Stats.o: nbproject/Makefile-${CND_CONF}.mk src/Stats.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/Stats.o src/Stats.cpp
+
 ${OBJECTDIR}/src/StdTypedefs.o: nbproject/Makefile-${CND_CONF}.mk src/StdTypedefs.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
 	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/StdTypedefs.o src/StdTypedefs.cpp
 
+${OBJECTDIR}/src/SyntheticData.o: nbproject/Makefile-${CND_CONF}.mk src/SyntheticData.cpp 
+	${MKDIR} -p ${OBJECTDIR}/src
+	${RM} "$@.d"
+	$(COMPILE.cc) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/src/SyntheticData.o src/SyntheticData.cpp
+
 ${OBJECTDIR}/src/Temperature.o: nbproject/Makefile-${CND_CONF}.mk src/Temperature.cpp 
 	${MKDIR} -p ${OBJECTDIR}/src
 	${RM} "$@.d"
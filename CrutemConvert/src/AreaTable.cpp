@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cmath>
+
+#include "AreaTable.h"
+
+
+EMCellAreaTable	::	EMCellAreaTable(float latDegrees, float lonDegrees,
+						double radius)
+	:
+	fLatStep(latDegrees > 0 ? latDegrees : 5.0),
+	fLonStep(lonDegrees > 0 ? lonDegrees : 5.0)
+{
+	int32 rows = ceil(180.0 / fLatStep - 1e-4);
+	fArea.resize(rows);
+	fWeight.resize(rows);
+
+	double sphere = 4.0 * M_PI * radius * radius;
+
+	for (int32 row = 0; row < rows; ++row) {
+		double	north = 90.0 - row * fLatStep,
+				south = std::max(north - fLatStep, -90.0);
+
+		fArea[row] = LBandArea(north, south, fLonStep, radius);
+		fWeight[row] = fArea[row] / sphere;
+	}
+}
+
+
+EMCellAreaTable	::	~EMCellAreaTable()
+{
+}
+
+
+float
+EMCellAreaTable	::	LatStep		() const
+{
+	return fLatStep;
+}
+
+
+float
+EMCellAreaTable	::	LonStep		() const
+{
+	return fLonStep;
+}
+
+
+int32
+EMCellAreaTable	::	Rows		() const
+{
+	return fArea.size();
+}
+
+
+int32
+EMCellAreaTable	::	RowFor		(float lat) const
+{
+	int32 row = ceil((90.0 - lat) / fLatStep) - 1;
+	return std::min<int32>(std::max<int32>(row, 0), Rows() - 1);
+}
+
+
+double
+EMCellAreaTable	::	Area		(int32 row) const
+{
+	return fArea.at(row);
+}
+
+
+double
+EMCellAreaTable	::	Weight		(int32 row) const
+{
+	return fWeight.at(row);
+}
+
+
+double
+EMCellAreaTable	::	AreaAt		(float lat) const
+{
+	return fArea[RowFor(lat)];
+}
+
+
+double
+EMCellAreaTable	::	WeightAt	(float lat) const
+{
+	return fWeight[RowFor(lat)];
+}
+
+
+double
+EMCellAreaTable	::	AreaFor		(const EMCoordRect& rect) const
+{
+	return fArea[RowFor((rect.North + rect.South) / 2.0)];
+}
@@ -0,0 +1,60 @@
+#ifndef EM_AREA_TABLE_H
+#define EM_AREA_TABLE_H
+
+#include <vector>
+
+#include "EarthCoordSystem.h"
+#include "MathUtils.h"
+#include "StdTypedefs.h"
+
+/*
+	Cell areas on the sphere for a regular latitude/longitude grid.
+
+	Every cell in a latitude band has the same area, so a grid needs only
+	one value per row.  The table works them out once, exactly:
+
+		area = R^2 * width (radians) * (sin(north) - sin(south))
+
+	along with each row's weight, its cell's share of the whole sphere.
+	Cells and area-weighted sums then read a value instead of doing any
+	trigonometry of their own:
+
+		EMCellAreaTable areas(5.0, 5.0);
+		double weight = areas.WeightAt(station->LAT);
+
+	Rows run from the north pole down, as with EMGridPyramid.  A latitude on
+	a row boundary belongs to the row to its north - cells own their
+	southern edge - and the north pole to the first row.
+*/
+
+class	EMCellAreaTable {
+public:
+								EMCellAreaTable(float latDegrees = 5.0,
+									float lonDegrees = 5.0,
+									double radius = EARTH_RADIUS_KM);
+	virtual						~EMCellAreaTable();
+
+			float				LatStep		() const;
+			float				LonStep		() const;
+			int32				Rows		() const;
+
+			int32				RowFor		(float lat) const;
+
+			double				Area		(int32 row) const;	// km^2
+			double				Weight		(int32 row) const;
+			double				AreaAt		(float lat) const;
+			double				WeightAt	(float lat) const;
+
+			// the row the rect's middle falls in
+			double				AreaFor		(const EMCoordRect&) const;
+
+private:
+		float					fLatStep;
+		float					fLonStep;
+
+		std::vector<double>		fArea;
+		std::vector<double>		fWeight;
+};
+
+
+#endif // EM_AREA_TABLE_H
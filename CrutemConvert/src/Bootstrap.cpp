@@ -0,0 +1,351 @@
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+#include "OutputWriter.h"
+#include "Parallel.h"
+#include "SeriesTable.h"
+
+#include "Bootstrap.h"
+
+
+#define	BOOTSTRAP_GOLDEN			0x9E3779B97F4A7C15ULL
+
+
+static inline uint64
+_Mix(uint64 value)
+{	// SplitMix64 finalizer
+	value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31);
+}
+
+
+EMBootstrap	::	EMBootstrap(uint64 seed)
+	:
+	fSeed(seed),
+	fFirstYear(INT32_MAX),
+	fEndYear(INT32_MIN),
+	fReplicates(0)
+{
+}
+
+
+EMBootstrap	::	~EMBootstrap()
+{
+}
+
+
+void
+EMBootstrap	::	AddStations	(const std::vector<Station*>& stations)
+{
+	std::vector<float> means;
+
+	for (const auto* station : stations) {
+		int32 years = station->ENDYEAR - station->STARTYEAR;
+		if (years <= 0 || station->DATA == nullptr)
+			continue;
+
+		means.assign(years, SERIES_MISSING);
+		for (int32 y = 0; y < years; ++y) {
+			const YearData& yd = station->DATA[y];
+			if (!yd.VALID)
+				continue;
+
+			double accum = 0;
+			int32 count = 0;
+			for (int16 m = 1; m <= 12; ++m) {
+				float value = yd.MonthValue(m);
+				if (value > -99) {
+					accum += value;
+					++count;
+				}
+			}
+
+			if (count > 0)
+				means[y] = accum / count;
+		}
+
+		_AddUnit(station->STARTYEAR, means, 1.0);
+	}
+}
+
+
+void
+EMBootstrap	::	AddCells	(const EMGridPyramid& pyramid, int32 level)
+{
+	int32	months = pyramid.MonthCount(),
+			years = months / 12,
+			firstYear = pyramid.FirstMonth().Year();
+
+	std::vector<float> means;
+
+	for (int32 cell = 0; cell < pyramid.CellCount(level); ++cell) {
+		double area = 0;
+		int32 areaMonths = 0;
+
+		means.assign(years, SERIES_MISSING);
+		for (int32 y = 0; y < years; ++y) {
+			double accum = 0;
+			int32 count = 0;
+			for (int32 m = y * 12; m < y * 12 + 12; ++m) {
+				float weight = pyramid.Weight(level, cell, m);
+				if (weight <= 0)
+					continue;
+
+				accum += pyramid.Mean(level, cell, m);
+				area += weight;
+				++count;
+			}
+
+			if (count > 0)
+				means[y] = accum / count;
+			areaMonths += count;
+		}
+
+		if (areaMonths > 0)
+			_AddUnit(firstYear, means, area / areaMonths);
+	}
+}
+
+
+int32
+EMBootstrap	::	UnitCount	() const
+{
+	return fUnitFirst.size();
+}
+
+
+int32
+EMBootstrap	::	FirstYear	() const
+{
+	return fFirstYear;
+}
+
+
+int32
+EMBootstrap	::	YearCount	() const
+{
+	return fEndYear > fFirstYear ? fEndYear - fFirstYear : 0;
+}
+
+
+void
+EMBootstrap	::	Run			(int32 replicates)
+{
+	int32	units = UnitCount(),
+			years = YearCount();
+
+	fReplicates = replicates > 0 ? replicates : 0;
+	fSorted.assign((size_t)years * fReplicates, SERIES_MISSING);
+	fValid.assign(years, 0);
+
+	if (units == 0 || years == 0 || fReplicates == 0)
+		return;
+
+	std::vector<float> replicate((size_t)fReplicates * years);
+
+	struct _Scratch {
+		std::vector<int32>	drawn;
+		std::vector<double>	sum;
+		std::vector<double>	weight;
+	};
+	std::vector<_Scratch> scratch(LThreadCount());
+
+	LParallelFor(fReplicates, [&](int32 begin, int32 end, int32 thread) {
+		_Scratch& local = scratch[thread];
+
+		for (int32 r = begin; r < end; ++r) {
+			local.drawn.assign(units, 0);
+			local.sum.assign(years, 0.0);
+			local.weight.assign(years, 0.0);
+
+			// draw n of every replicate hashes (seed, r, n), nothing else
+			uint64 key = _Mix(fSeed + (r + 1) * BOOTSTRAP_GOLDEN);
+			for (int32 n = 0; n < units; ++n)
+				local.drawn[_Mix(key + (n + 1) * BOOTSTRAP_GOLDEN) % units]++;
+
+			for (int32 u = 0; u < units; ++u) {
+				if (local.drawn[u] == 0)
+					continue;
+
+				double weight = local.drawn[u] * fUnitWeight[u];
+				const float* means = &fMeans[fUnitStart[u]];
+				int32 offset = fUnitFirst[u] - fFirstYear;
+
+				for (int32 y = 0; y < fUnitYears[u]; ++y) {
+					if (means[y] <= -99)
+						continue;
+
+					local.sum[offset + y] += weight * means[y];
+					local.weight[offset + y] += weight;
+				}
+			}
+
+			float* out = &replicate[(size_t)r * years];
+			for (int32 y = 0; y < years; ++y) {
+				out[y] = local.weight[y] > 0
+					? local.sum[y] / local.weight[y] : SERIES_MISSING;
+			}
+		}
+	}, 4);
+
+	// transpose into per-year runs and sort them
+	LParallelFor(years, [&](int32 begin, int32 end, int32) {
+		for (int32 y = begin; y < end; ++y) {
+			float* sorted = &fSorted[(size_t)y * fReplicates];
+			int32 valid = 0;
+
+			for (int32 r = 0; r < fReplicates; ++r) {
+				float value = replicate[(size_t)r * years + y];
+				if (value > -99)
+					sorted[valid++] = value;
+			}
+
+			std::sort(sorted, sorted + valid);
+			fValid[y] = valid;
+		}
+	});
+}
+
+
+int32
+EMBootstrap	::	ReplicateCount() const
+{
+	return fReplicates;
+}
+
+
+float
+EMBootstrap	::	Estimate	(int32 year) const
+{
+	int32 y = _Year(year);
+	if (y < 0)
+		return SERIES_MISSING;
+
+	double sum = 0, weight = 0;
+	for (int32 u = 0; u < UnitCount(); ++u) {
+		int32 offset = year - fUnitFirst[u];
+		if (offset < 0 || offset >= fUnitYears[u])
+			continue;
+
+		float mean = fMeans[fUnitStart[u] + offset];
+		if (mean <= -99)
+			continue;
+
+		sum += fUnitWeight[u] * mean;
+		weight += fUnitWeight[u];
+	}
+
+	return weight > 0 ? sum / weight : SERIES_MISSING;
+}
+
+
+int32
+EMBootstrap	::	UnitsFor	(int32 year) const
+{
+	int32 count = 0;
+	for (int32 u = 0; u < UnitCount(); ++u) {
+		int32 offset = year - fUnitFirst[u];
+		if (offset >= 0 && offset < fUnitYears[u]
+			&& fMeans[fUnitStart[u] + offset] > -99)
+			++count;
+	}
+
+	return count;
+}
+
+
+float
+EMBootstrap	::	Percentile	(int32 year, float percent) const
+{
+	int32 y = _Year(year);
+	if (y < 0 || fValid.empty() || fValid[y] == 0)
+		return SERIES_MISSING;
+
+	const float* sorted = &fSorted[(size_t)y * fReplicates];
+	double	position = std::min(std::max(percent, 0.0f), 100.0f) / 100.0
+				* (fValid[y] - 1);
+	int32	lower = floor(position),
+			upper = std::min<int32>(lower + 1, fValid[y] - 1);
+
+	return sorted[lower] + (sorted[upper] - sorted[lower]) * (position - lower);
+}
+
+
+bool
+EMBootstrap	::	WriteCSV	(const std::string& path, TScale scale) const
+{
+	EMOutputWriter out;
+	if (!out.Open(path))
+		return false;
+
+	out.Write("YEAR,AVERAGE,COUNT,P").WriteGeneral(BOOTSTRAP_LOW_PERCENT)
+		.Write(",P50,P").WriteGeneral(BOOTSTRAP_HIGH_PERCENT).Write('\n');
+
+	// the four temperature columns, converted as one run
+	int32 years = YearCount();
+	std::vector<int32> counts(years);
+	std::vector<float> columns((size_t)years * 4);
+
+	for (int32 y = 0; y < years; ++y) {
+		int32 year = fFirstYear + y;
+		float* row = &columns[(size_t)y * 4];
+
+		counts[y] = UnitsFor(year);
+		row[0] = Estimate(year);
+		row[1] = Percentile(year, BOOTSTRAP_LOW_PERCENT);
+		row[2] = Percentile(year, 50.0);
+		row[3] = Percentile(year, BOOTSTRAP_HIGH_PERCENT);
+	}
+
+	LConvertTemperatures(Celsius, scale, columns.data(), columns.data(),
+		columns.size());
+
+	for (int32 y = 0; y < years; ++y) {
+		if (counts[y] == 0)
+			continue;
+
+		const float* row = &columns[(size_t)y * 4];
+		out.WriteInt(fFirstYear + y).Write(',').WriteFixed(row[0], 4)
+			.Write(',').WriteInt(counts[y]);
+		for (int32 c = 1; c < 4; ++c)
+			out.Write(',').WriteFixed(row[c], 4);
+		out.Write('\n');
+	}
+
+	return out.Close();
+}
+
+
+//#pragma mark private
+
+
+void
+EMBootstrap	::	_AddUnit	(int32 firstYear, const std::vector<float>& means,
+								float weight)
+{
+	fUnitFirst.push_back(firstYear);
+	fUnitYears.push_back(means.size());
+	fUnitStart.push_back(fMeans.size());
+	fUnitWeight.push_back(weight);
+	fMeans.insert(fMeans.end(), means.begin(), means.end());
+
+	fFirstYear = std::min(fFirstYear, firstYear);
+	fEndYear = std::max<int32>(fEndYear, firstYear + means.size());
+
+	// any earlier run no longer matches the units
+	fReplicates = 0;
+	fSorted.clear();
+	fValid.clear();
+}
+
+
+int32
+EMBootstrap	::	_Year		(int32 year) const
+{
+	if (year < fFirstYear || year >= fEndYear)
+		return -1;
+
+	return year - fFirstYear;
+}
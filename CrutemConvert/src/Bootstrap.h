@@ -0,0 +1,99 @@
+#ifndef EM_BOOTSTRAP_H
+#define EM_BOOTSTRAP_H
+
+#include <string>
+#include <vector>
+
+#include "GridPyramid.h"
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+#include "Temperature.h"
+
+/*
+	Confidence bands for the annual series by resampling.
+
+	The units being resampled - stations, or grid cells - are reduced once
+	to annual means (the mean of each year's valid months) and a weight:
+	one for a station, the cell's area for a cell.  The estimate for a year
+	is the weighted mean over the units which have that year:
+
+		estimate(year) = sum(weight * mean) / sum(weight)
+
+	which, for stations, is the unweighted average crucon has always
+	written.  Each replicate draws as many units as there are, with
+	replacement, and repeats the sum with each unit counted as often as it
+	was drawn.  The replicates for a year are then sorted, so any
+	percentile can be read off:
+
+		EMBootstrap bootstrap;
+		bootstrap.AddStations(StationList);
+		bootstrap.Run(1000);
+
+		float low = bootstrap.Percentile(year, 2.5),
+			high = bootstrap.Percentile(year, 97.5);
+
+	Replicates run in parallel.  Each draw is a counter-based hash of the
+	seed, the replicate number and the draw number rather than the next
+	number from a shared generator, so the results are the same whatever
+	the thread count or the order replicates are run in.
+*/
+
+#define	BOOTSTRAP_DEFAULT_SEED		0x43525554454D34ULL	// "CRUTEM4"
+#define	BOOTSTRAP_LOW_PERCENT		2.5
+#define	BOOTSTRAP_HIGH_PERCENT		97.5
+
+
+class	EMBootstrap {
+public:
+								EMBootstrap(
+									uint64 seed = BOOTSTRAP_DEFAULT_SEED);
+	virtual						~EMBootstrap();
+
+			void				AddStations	(const std::vector<Station*>&);
+			void				AddCells	(const EMGridPyramid&,
+											int32 level = 0);
+
+			int32				UnitCount	() const;
+			int32				FirstYear	() const;
+			int32				YearCount	() const;
+
+			void				Run			(int32 replicates);
+			int32				ReplicateCount() const;
+
+			// from every unit, SERIES_MISSING for a year without any
+			float				Estimate	(int32 year) const;
+			int32				UnitsFor	(int32 year) const;
+
+			// linear between the nearest replicates, SERIES_MISSING
+			// before Run() or for a year without data
+			float				Percentile	(int32 year, float percent) const;
+
+			// YEAR,AVERAGE,COUNT,P2.5,P50,P97.5, temperatures in `scale`
+			bool				WriteCSV	(const std::string& path,
+											TScale scale = Celsius) const;
+
+private:
+			void				_AddUnit	(int32 firstYear,
+											const std::vector<float>& means,
+											float weight);
+			int32				_Year		(int32 year) const;
+
+		uint64					fSeed;
+
+		// per unit, means for [fUnitFirst, fUnitFirst + fUnitYears)
+		std::vector<int32>		fUnitFirst;
+		std::vector<int32>		fUnitYears;
+		std::vector<int32>		fUnitStart;		// into fMeans
+		std::vector<float>		fUnitWeight;
+		std::vector<float>		fMeans;			// SERIES_MISSING if none
+
+		int32					fFirstYear;
+		int32					fEndYear;
+
+		int32					fReplicates;
+		std::vector<float>		fSorted;		// years x replicates
+		std::vector<int32>		fValid;			// replicates per year
+};
+
+
+#endif // EM_BOOTSTRAP_H
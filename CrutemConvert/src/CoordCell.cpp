@@ -16,11 +16,23 @@ EMCoordCell	::	EMCoordCell(const EMCoordRect& poly)
 	fElevationAvg(0),
 	fElevAvgDirty(false),
 	fArea(0),
-	fCoordinates(poly)
+	fCoordinates(poly),
+	fSeriesDirty(true)
+{
+	fArea = LBandArea(poly.North, poly.South, poly.Width(), EARTH_RADIUS_KM);
+}
+
+
+EMCoordCell	::	EMCoordCell(const EMCoordRect& poly,
+						const EMCellAreaTable& areas)
+	:
+	fElevationGrid(ELEV_GRID_SZ * ELEV_GRID_SZ),
+	fElevationAvg(0),
+	fElevAvgDirty(false),
+	fArea(areas.AreaFor(poly)),
+	fCoordinates(poly),
+	fSeriesDirty(true)
 {
-	EMPoint* pt = poly.ToPointArray();
-	fArea = LCalculateArea(pt, 4);
-	delete pt;
 }
 
 
@@ -80,12 +92,14 @@ EMCoordCell	::	Remove		(const Station* station)
 			return true;
 		}
 		return false;
-	}));
+	}), fStations.end());
 
 	if (result) {
 		auto& elevGrid = _ElevGridForCoord(station->LAT, station->LON);
 		elevGrid.first -= station->ELEV;
 		elevGrid.second--;
+		fElevAvgDirty = true;
+		fSeriesDirty = true;
 	}
 
 	return result;
@@ -106,6 +120,7 @@ EMCoordCell	::	Insert		(Station* station)
 	elevGrid.first += station->ELEV;
 	elevGrid.second++;
 	fElevAvgDirty = true;
+	fSeriesDirty = true;
 
 	// start/end year
 	if (fStartYear.IsYearValid() == false
@@ -113,7 +128,7 @@ EMCoordCell	::	Insert		(Station* station)
 		fStartYear = _year(station->STARTYEAR);
 
 	if (fEndYear.IsYearValid() == false
-		|| fEndYear.Year() > station->ENDYEAR)
+		|| fEndYear.Year() < station->ENDYEAR)
 		fEndYear = _year(station->ENDYEAR);
 
 	return true;
@@ -155,6 +170,9 @@ EMCoordCell	::	AverageFor	(EMDate date)
 	if (date.IsValid() == false)
 		return _kelvin(0.0);
 
+	if (date.IsYearValid() && date.IsMonthValid())
+		return AverageFor(EMMonthIndex(date));
+
 	double accum = 0;
 	int32 count = 0;
 
@@ -173,12 +191,65 @@ EMCoordCell	::	AverageFor	(EMDate date)
 
 EMTemperature
 EMCoordCell	::	AverageFor	(EMDate d1, EMDate d2)
+{	// whole months, [d1, d2); a date without a month starts at January
+	if (!d1.IsYearValid() || !d2.IsYearValid())
+		return _kelvin(0.0);
+
+	return AverageFor(
+		EMMonthIndex(d1.Year(), d1.IsMonthValid() ? d1.Month() : 1),
+		EMMonthIndex(d2.Year(), d2.IsMonthValid() ? d2.Month() : 1));
+}
+
+
+EMTemperature
+EMCoordCell	::	AverageFor	(EMMonthIndex month)
+{
+	int32 index = _SeriesMonth(month);
+	if (index < 0 || fSeriesCount[index] == 0)
+		return _kelvin(0.0);
+
+	return _celsius(fSeriesMean[index]);
+}
+
+
+EMTemperature
+EMCoordCell	::	AverageFor	(EMMonthIndex from, EMMonthIndex to)
 {
+	PrepareSeries();
 
-	return _kelvin(0.0);
+	if (!from.IsValid() || !to.IsValid() || fSeriesMean.empty())
+		return _kelvin(0.0);
+
+	int32	months = fSeriesMean.size(),
+			begin = std::min<int32>(std::max<int32>(from - fSeriesStart, 0),
+				months),
+			end = std::min<int32>(std::max<int32>(to - fSeriesStart, 0),
+				months),
+			count = end > begin
+				? fSeriesPrefixCount[end] - fSeriesPrefixCount[begin] : 0;
+
+	if (count == 0)
+		return _kelvin(0.0);
+
+	return _celsius((fSeriesPrefixSum[end] - fSeriesPrefixSum[begin]) / count);
 }
 
 
+int32
+EMCoordCell	::	CountFor	(EMMonthIndex month) const
+{
+	int32 index = _SeriesMonth(month);
+	return index < 0 ? 0 : fSeriesCount[index];
+}
+
+
+void
+EMCoordCell	::	PrepareSeries() const
+{
+	if (fSeriesDirty)
+		_RebuildSeries();
+}
+
 
 std::pair<double, uint32>&
 EMCoordCell	::	_ElevGridForCoord(float lat, float lon)
@@ -186,20 +257,19 @@ EMCoordCell	::	_ElevGridForCoord(float lat, float lon)
 	// lat & lon are guaranteed to be inside our bounds
 	// ELEV_GRID_SZ x ELEV_GRID_SZ
 
-	float gridTurn = 1.0/ELEV_GRID_SZ,
-		x = lon	/ fCoordinates.Width(),
-		y = lat / fCoordinates.Height();
+	// position within the cell, west to east and north to south; -180
+	// is in the cell as +180, as EMCoordRect has it
+	if (lon == -180)
+		lon = 180;
 
-		// guarantee a cell will be occupied
-		if (x / ELEV_GRID_SZ <= gridTurn)
-			x *= (ELEV_GRID_SZ - 1);
-		else
-			x *= ELEV_GRID_SZ;
+	int32	x = (lon - fCoordinates.West) / fCoordinates.Width()
+				* ELEV_GRID_SZ,
+			y = (fCoordinates.North - lat) / fCoordinates.Height()
+				* ELEV_GRID_SZ;
 
-		if (y / ELEV_GRID_SZ <= gridTurn)
-			y *= (ELEV_GRID_SZ - 1);
-		else
-			y *= ELEV_GRID_SZ;
+		// the eastern and southern edges belong to the last column/row
+		x = std::min<int32>(std::max<int32>(x, 0), ELEV_GRID_SZ - 1);
+		y = std::min<int32>(std::max<int32>(y, 0), ELEV_GRID_SZ - 1);
 
 	int32 position = (y * ELEV_GRID_SZ) + x;
 // TODO (use Build.h) ?
@@ -215,13 +285,98 @@ void
 EMCoordCell	::	_RecalcElevAvg() const
 {
 	double accum = 0;
+	int32 occupied = 0;
+
+	for (auto elP : fElevationGrid) {
+		if (elP.second == 0)
+			continue;	// no stations there to say
 
-	for (auto elP : fElevationGrid)
 		accum += (double)elP.first / (double)elP.second;
+		occupied++;
+	}
 
-	fElevationAvg = accum / (ELEV_GRID_SZ * ELEV_GRID_SZ);
+	fElevationAvg = occupied > 0 ? accum / occupied : 0;
 	fElevAvgDirty = false;
 }
 
 
+void
+EMCoordCell	::	_RebuildSeries() const
+{
+	int32 firstYear = INT32_MAX, endYear = INT32_MIN;
+	for (const Station* station : fStations) {
+		if (station->DATA == nullptr)
+			continue;
+
+		firstYear = std::min(firstYear, station->STARTYEAR);
+		endYear = std::max(endYear, station->ENDYEAR);
+	}
+
+	if (endYear <= firstYear) {
+		firstYear = 0;
+		endYear = 0;
+	}
+
+	int32 months = (endYear - firstYear) * 12;
+	std::vector<double> accum(months, 0.0);
+
+	fSeriesStart = EMMonthIndex(firstYear, 1);
+	fSeriesCount.assign(months, 0);
+
+	for (const Station* station : fStations) {
+		if (station->DATA == nullptr)
+			continue;
+
+		int32	offset = (station->STARTYEAR - firstYear) * 12,
+				years = station->ENDYEAR - station->STARTYEAR;
+
+		for (int32 y = 0; y < years; ++y) {
+			const YearData& yd = station->DATA[y];
+			if (!yd.VALID)
+				continue;
+
+			for (int16 m = 0; m < 12; ++m) {
+				float value = yd.MonthValue(m + 1);
+				if (value > -99.0) {
+					accum[offset + y * 12 + m] += value;
+					fSeriesCount[offset + y * 12 + m]++;
+				}
+			}
+		}
+	}
+
+	fSeriesMean.assign(months, -99.9);
+	fSeriesPrefixSum.assign(months + 1, 0.0);
+	fSeriesPrefixCount.assign(months + 1, 0);
+
+	for (int32 m = 0; m < months; ++m) {
+		bool valid = fSeriesCount[m] > 0;
+		if (valid)
+			fSeriesMean[m] = accum[m] / fSeriesCount[m];
+
+		fSeriesPrefixSum[m + 1] = fSeriesPrefixSum[m]
+			+ (valid ? fSeriesMean[m] : 0.0);
+		fSeriesPrefixCount[m + 1] = fSeriesPrefixCount[m] + (valid ? 1 : 0);
+	}
+
+	fSeriesDirty = false;
+}
+
+
+int32
+EMCoordCell	::	_SeriesMonth(EMMonthIndex month) const
+{	// position in the cell series, or -1
+	PrepareSeries();
+
+	if (!month.IsValid())
+		return -1;
+
+	int32 index = month - fSeriesStart;
+	if (index < 0 || index >= (int32)fSeriesMean.size())
+		return -1;
+
+	return index;
+}
+
+
 
@@ -12,6 +12,7 @@
 #include <future>
 #include <vector>
 
+#include "AreaTable.h"
 #include "EarthCoordSystem.h"
 #include "StationListFormat.h"
 #include "Temperature.h"
@@ -29,17 +30,29 @@
 
 		A vector of pointers to each station falling within the cell.
 
-		A computed area value.
+		An area value, on the sphere; from the grid's EMCellAreaTable when
+		given one.
 
 		A date range.
 
+		A cell series: for each month, the mean of the member stations
+		which reported it, and how many did.
+
+	The cell series is built by the first temperature query after an
+	Insert() or Remove(), along with prefix sums over it, so range queries
+	cost the same however long the range and never go back to the
+	stations.  A range average is the mean of the cell's monthly means.
+
 	EMCoordCell is not inherently thread safe, write accesses should be
 	controlled and no read operations should be in flight during writes.
+	Call PrepareSeries() before reading one cell from several threads.
 */
 
 class	EMCoordCell	{
 public:
 								EMCoordCell(const EMCoordRect&);
+								EMCoordCell(const EMCoordRect&,
+									const EMCellAreaTable&);
 	virtual						~EMCoordCell();
 
 	const	EMCoordRect&		Coordinates	() const;
@@ -64,11 +77,21 @@ public:
 
 			EMTemperature		AverageFor	(EMDate);
 			EMTemperature		AverageFor	(EMDate, EMDate);
+			EMTemperature		AverageFor	(EMMonthIndex);
+			EMTemperature		AverageFor	(EMMonthIndex from,
+											EMMonthIndex to);
+
+			// stations reporting the month
+			int32				CountFor	(EMMonthIndex) const;
+
+			void				PrepareSeries() const;
 
 private:
 		std::pair<double, uint32>&
 								_ElevGridForCoord(float, float);
 		void					_RecalcElevAvg() const;
+		void					_RebuildSeries() const;
+		int32					_SeriesMonth(EMMonthIndex) const;
 
 		std::vector<Station*>	fStations;
 
@@ -81,6 +104,13 @@ private:
 
 		EMDate					fStartYear;
 		EMDate					fEndYear;
+
+	mutable	EMMonthIndex		fSeriesStart;
+	mutable	std::vector<float>	fSeriesMean;
+	mutable	std::vector<int32>	fSeriesCount;
+	mutable	std::vector<double>	fSeriesPrefixSum;	// months + 1 each
+	mutable	std::vector<int32>	fSeriesPrefixCount;
+	mutable	bool				fSeriesDirty;
 };
 
 
@@ -0,0 +1,256 @@
+#include <algorithm>
+#include <cmath>
+
+#include "Parallel.h"
+
+#include "Correlation.h"
+
+
+#define CORR_BLOCK_MONTHS	512	// 2 KiB of anomalies + 2 KiB of mask
+#define CORR_LANES			8
+
+
+struct _PairSums {
+	double				n,
+						sx,
+						sy,
+						sxx,
+						syy,
+						sxy;
+};
+
+
+static void
+_AccumulateBlock(const float* x, const float* validX, const float* y,
+	const float* validY, int32 lo, int32 hi, _PairSums& sums)
+{	// Missing months hold zero anomalies, so multiplying by the other
+	// station's mask restricts every sum to the months both share.
+	float	n[CORR_LANES] = {},
+			sx[CORR_LANES] = {},
+			sy[CORR_LANES] = {},
+			sxx[CORR_LANES] = {},
+			syy[CORR_LANES] = {},
+			sxy[CORR_LANES] = {};
+
+	int32 m = lo;
+	for (; m + CORR_LANES <= hi; m += CORR_LANES) {
+		for (int32 l = 0; l < CORR_LANES; ++l) {
+			float	xv = x[m + l],
+					yv = y[m + l],
+					wx = validX[m + l],
+					wy = validY[m + l];
+
+			n[l] += wx * wy;
+			sx[l] += xv * wy;
+			sy[l] += yv * wx;
+			sxx[l] += xv * xv * wy;
+			syy[l] += yv * yv * wx;
+			sxy[l] += xv * yv;
+		}
+	}
+
+	for (; m < hi; ++m) {
+		n[0] += validX[m] * validY[m];
+		sx[0] += x[m] * validY[m];
+		sy[0] += y[m] * validX[m];
+		sxx[0] += x[m] * x[m] * validY[m];
+		syy[0] += y[m] * y[m] * validX[m];
+		sxy[0] += x[m] * y[m];
+	}
+
+	for (int32 l = 0; l < CORR_LANES; ++l) {
+		sums.n += n[l];
+		sums.sx += sx[l];
+		sums.sy += sy[l];
+		sums.sxx += sxx[l];
+		sums.syy += syy[l];
+		sums.sxy += sxy[l];
+	}
+}
+
+
+static float
+_Pearson(const _PairSums& sums)
+{
+	if (sums.n < 2)
+		return 0.0;
+
+	double	cov = sums.n * sums.sxy - sums.sx * sums.sy,
+			varX = sums.n * sums.sxx - sums.sx * sums.sx,
+			varY = sums.n * sums.syy - sums.sy * sums.sy;
+
+	if (varX <= 0 || varY <= 0)
+		return 0.0;
+
+	double r = cov / sqrt(varX * varY);
+	return std::max(-1.0, std::min(1.0, r));
+}
+
+
+EMCorrelationGraph	::	EMCorrelationGraph()
+{
+}
+
+
+EMCorrelationGraph	::	~EMCorrelationGraph()
+{
+}
+
+
+void
+EMCorrelationGraph	::	Build	(const EMSeriesTable& table,
+								const EMStationIndex& index,
+								float cutoffKm, int32 minOverlap,
+								float minCorrelation)
+{
+	int32 stations = table.StationCount();
+
+	// edges to higher numbered stations only, per station
+	std::vector<std::vector<EMNeighbour> > upper(stations);
+
+	int32 threads = LThreadCount();
+	std::vector<std::vector<EMStationHit> > hitScratch(threads);
+	std::vector<std::vector<_PairSums> > sumScratch(threads);
+
+	LParallelFor(stations, [&](int32 begin, int32 end, int32 thread) {
+		auto& hits = hitScratch[thread];
+		auto& sums = sumScratch[thread];
+
+		for (int32 i = begin; i < end; ++i) {
+			index.Radius(index.PointAt(i), cutoffKm, hits, i);
+
+			// each pair once, from its lower numbered end
+			hits.erase(std::remove_if(hits.begin(), hits.end(),
+				[i, &table](const EMStationHit& hit) {
+					return hit.index < i
+						|| table.EndMonth(hit.index) <= table.FirstMonth(i)
+						|| table.FirstMonth(hit.index) >= table.EndMonth(i);
+				}), hits.end());
+
+			if (hits.empty())
+				continue;
+
+			sums.assign(hits.size(), _PairSums());
+
+			const float	*x = table.Anomalies(i),
+						*validX = table.Mask(i);
+			int32	first = table.FirstMonth(i),
+					last = table.EndMonth(i);
+
+			for (int32 block = first; block < last;
+					block += CORR_BLOCK_MONTHS) {
+				int32 blockEnd = std::min(last, block + CORR_BLOCK_MONTHS);
+
+				for (size_t h = 0; h < hits.size(); ++h) {
+					int32	j = hits[h].index,
+							lo = std::max(block, table.FirstMonth(j)),
+							hi = std::min(blockEnd, table.EndMonth(j));
+
+					if (lo < hi) {
+						_AccumulateBlock(x, validX, table.Anomalies(j),
+							table.Mask(j), lo, hi, sums[h]);
+					}
+				}
+			}
+
+			for (size_t h = 0; h < hits.size(); ++h) {
+				if (sums[h].n < minOverlap)
+					continue;
+
+				float r = _Pearson(sums[h]);
+				if (r < minCorrelation)
+					continue;
+
+				EMNeighbour edge;
+				edge.index = hits[h].index;
+				edge.correlation = r;
+				edge.distance = hits[h].distance;
+				edge.overlap = (int32)(sums[h].n + 0.5);
+				upper[i].push_back(edge);
+			}
+		}
+	}, 8);
+
+	// mirror every edge so both ends list it
+	fStart.assign(stations + 1, 0);
+	for (int32 i = 0; i < stations; ++i) {
+		fStart[i + 1] += upper[i].size();
+		for (const auto& edge : upper[i])
+			fStart[edge.index + 1]++;
+	}
+
+	for (int32 i = 0; i < stations; ++i)
+		fStart[i + 1] += fStart[i];
+
+	fEdges.resize(fStart[stations]);
+	std::vector<int32> fill(fStart.begin(), fStart.end() - 1);
+
+	for (int32 i = 0; i < stations; ++i) {
+		for (const auto& edge : upper[i]) {
+			fEdges[fill[i]++] = edge;
+
+			EMNeighbour mirror = edge;
+			mirror.index = i;
+			fEdges[fill[edge.index]++] = mirror;
+		}
+	}
+
+	LParallelFor(stations, [this](int32 begin, int32 end, int32) {
+		for (int32 i = begin; i < end; ++i) {
+			std::sort(fEdges.begin() + fStart[i], fEdges.begin() + fStart[i + 1],
+				[](const EMNeighbour& one, const EMNeighbour& two) {
+					return one.correlation > two.correlation
+						|| (one.correlation == two.correlation
+							&& one.index < two.index);
+				});
+		}
+	}, 64);
+}
+
+
+int32
+EMCorrelationGraph	::	StationCount() const
+{
+	return fStart.empty() ? 0 : fStart.size() - 1;
+}
+
+
+int32
+EMCorrelationGraph	::	EdgeCount	() const
+{
+	return fEdges.size();
+}
+
+
+const EMNeighbour*
+EMCorrelationGraph	::	NeighboursOf(int32 station, int32& count) const
+{
+	if (station < 0 || station >= StationCount()) {
+		count = 0;
+		return nullptr;
+	}
+
+	count = fStart[station + 1] - fStart[station];
+	return fEdges.data() + fStart[station];
+}
+
+
+float
+EMCorrelationGraph	::	Correlate	(const EMSeriesTable& table,
+									int32 one, int32 two, int32* overlap)
+{
+	_PairSums sums = _PairSums();
+
+	int32	lo = std::max(table.FirstMonth(one), table.FirstMonth(two)),
+			hi = std::min(table.EndMonth(one), table.EndMonth(two));
+
+	if (lo < hi) {
+		_AccumulateBlock(table.Anomalies(one), table.Mask(one),
+			table.Anomalies(two), table.Mask(two), lo, hi, sums);
+	}
+
+	if (overlap != nullptr)
+		*overlap = (int32)(sums.n + 0.5);
+
+	return _Pearson(sums);
+}
@@ -0,0 +1,76 @@
+#ifndef EM_CORRELATION_H
+#define EM_CORRELATION_H
+
+#include <vector>
+
+#include "SeriesTable.h"
+#include "StationIndex.h"
+#include "StdTypedefs.h"
+
+/*
+	Sparse station neighbour graph, weighted by the Pearson correlation of
+	each pair's monthly anomalies over the months both have data for.
+
+	Only pairs within `cutoffKm` of each other are compared, and a pair is
+	kept only with at least `minOverlap` shared months and a correlation of
+	at least `minCorrelation`.  Edges are stored in both directions, each
+	station's neighbours sorted by descending correlation:
+
+		EMCorrelationGraph graph;
+		graph.Build(table, index, 1200.0);
+
+		int32 count = 0;
+		const EMNeighbour* neighbours = graph.NeighboursOf(i, count);
+		for (int32 n = 0; n < count; ++n)
+			use(neighbours[n].index, neighbours[n].correlation);
+
+	Station numbers are rows in the EMSeriesTable, which must line up with
+	the entries of the EMStationIndex (build both from the same list).
+
+	Each pair is computed once, on whichever thread owns the lower numbered
+	station.  The station's anomalies are walked in blocks of months small
+	enough to stay in L1 while every neighbour's matching block streams past
+	it, and the six masked sums per pair are kept in eight float lanes so
+	the compiler can vectorize them.  Lanes are folded into doubles at the
+	end of each block.
+*/
+
+struct EMNeighbour {
+	int32				index;
+	float				correlation;
+	float				distance;	// km
+	int32				overlap;	// shared months
+};
+
+
+class	EMCorrelationGraph {
+public:
+								EMCorrelationGraph();
+	virtual						~EMCorrelationGraph();
+
+			void				Build		(const EMSeriesTable&,
+											const EMStationIndex&,
+											float cutoffKm,
+											int32 minOverlap = 60,
+											float minCorrelation = 0.0);
+
+			int32				StationCount() const;
+			int32				EdgeCount	() const;
+
+			const EMNeighbour*	NeighboursOf(int32 station,
+											int32& count) const;
+
+			// Pearson correlation over the shared valid months of two
+			// table rows, or 0 with fewer than two shared months.
+	static	float				Correlate	(const EMSeriesTable&,
+											int32 one, int32 two,
+											int32* overlap = nullptr);
+
+private:
+		std::vector<int32>		fStart;	// per station, into fEdges
+		std::vector<EMNeighbour>
+								fEdges;
+};
+
+
+#endif // EM_CORRELATION_H
@@ -0,0 +1,270 @@
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
+
+#include "DateIndex.h"
+#include "OutputWriter.h"
+#include "Parallel.h"
+#include "SeriesTable.h"
+
+#include "DailySeries.h"
+
+
+#define DAILY_BATCH_PER_THREAD	4
+
+
+static void
+_SolveSpline(const std::vector<double>& x, const std::vector<float>& y,
+	int32 first, int32 last, std::vector<double>& second)
+{	// Natural cubic spline second derivatives for knots [first, last],
+	// by the Thomas algorithm.  The ends stay at zero.
+	int32 n = last - first + 1;
+	if (n < 3)
+		return;
+
+	std::vector<double> diag(n, 0.0), upper(n, 0.0), rhs(n, 0.0);
+
+	for (int32 i = 1; i < n - 1; ++i) {
+		int32 k = first + i;
+		double	hPrev = x[k] - x[k - 1],
+				hNext = x[k + 1] - x[k];
+
+		diag[i] = 2.0 * (hPrev + hNext);
+		upper[i] = hNext;
+		rhs[i] = 6.0 * ((y[k + 1] - y[k]) / hNext - (y[k] - y[k - 1]) / hPrev);
+
+		if (i > 1) {	// eliminate the sub-diagonal (hPrev)
+			double factor = hPrev / diag[i - 1];
+			diag[i] -= factor * upper[i - 1];
+			rhs[i] -= factor * rhs[i - 1];
+		}
+	}
+
+	for (int32 i = n - 2; i >= 1; --i) {
+		double next = (i + 1 < n - 1) ? second[first + i + 1] : 0.0;
+		second[first + i] = (rhs[i] - upper[i] * next) / diag[i];
+	}
+}
+
+
+static char*
+_FormatDate(char* out, int32 year, int16 month, int16 day)
+{
+	int32 y = year < 0 ? -year : year;
+	if (year < 0)
+		*out++ = '-';
+
+	out[0] = '0' + (y / 1000) % 10;
+	out[1] = '0' + (y / 100) % 10;
+	out[2] = '0' + (y / 10) % 10;
+	out[3] = '0' + y % 10;
+	out[4] = '-';
+	out[5] = '0' + month / 10;
+	out[6] = '0' + month % 10;
+	out[7] = '-';
+	out[8] = '0' + day / 10;
+	out[9] = '0' + day % 10;
+	return out + 10;
+}
+
+
+EMDailyInterpolator	::	EMDailyInterpolator(EMInterpolation mode, int32 step)
+	:
+	fMode(mode),
+	fStep(step > 0 ? step : 1)
+{
+}
+
+
+EMDailyInterpolator	::	~EMDailyInterpolator()
+{
+}
+
+
+EMInterpolation
+EMDailyInterpolator	::	Mode	() const
+{
+	return fMode;
+}
+
+
+int32
+EMDailyInterpolator	::	Step	() const
+{
+	return fStep;
+}
+
+
+int32
+EMDailyInterpolator	::	Generate	(const Station& station,
+		std::function<void(const EMDailyValue&)> func) const
+{
+	std::vector<EMDailyValue> values;
+	Generate(station, values);
+
+	for (const auto& value : values)
+		func(value);
+
+	return values.size();
+}
+
+
+int32
+EMDailyInterpolator	::	Generate	(const Station& station,
+									std::vector<EMDailyValue>& out) const
+{
+	out.clear();
+
+	int32 years = station.ENDYEAR - station.STARTYEAR;
+	if (years <= 0 || station.DATA == nullptr)
+		return 0;
+
+	int32 months = years * 12;
+
+	// month values, starts and mid-month anchors, in days
+	std::vector<float>	value(months);
+	std::vector<int32>	start(months + 1);
+	std::vector<double>	anchor(months);
+	std::vector<int16>	length(months);
+
+	int32 day = 0;
+	for (int32 y = 0; y < years; ++y) {
+		const YearData& yd = station.DATA[y];
+
+		for (int16 m = 0; m < 12; ++m) {
+			int32 k = y * 12 + m;
+			value[k] = yd.VALID ? yd.MonthValue(m + 1) : SERIES_MISSING;
+			length[k] = LDaysInMonth(station.STARTYEAR + y, m + 1);
+			start[k] = day;
+			anchor[k] = day + (length[k] - 1) / 2.0;
+			day += length[k];
+		}
+	}
+	start[months] = day;
+
+	auto valid = [&value, months](int32 k) {
+		return k >= 0 && k < months && value[k] > -99;
+	};
+
+	// spline curvature through each run of valid months
+	std::vector<double> second(months, 0.0);
+	if (fMode == INTERPOLATE_CUBIC) {
+		int32 k = 0;
+		while (k < months) {
+			if (!valid(k)) {
+				++k;
+				continue;
+			}
+			int32 runEnd = k;
+			while (valid(runEnd + 1))
+				++runEnd;
+
+			_SolveSpline(anchor, value, k, runEnd, second);
+			k = runEnd + 1;
+		}
+	}
+
+	out.reserve(day / fStep + 1);
+
+	for (int32 k = 0; k < months; ++k) {
+		if (!valid(k))
+			continue;
+
+		// first day of the month that lands on the step
+		int32 first = start[k] + (fStep - start[k] % fStep) % fStep;
+
+		for (int32 pos = first; pos < start[k + 1]; pos += fStep) {
+			int32	left = pos < anchor[k] ? k - 1 : k,
+					right = left + 1;
+			float	celsius = value[k];
+
+			if (valid(left) && valid(right)) {
+				double	h = anchor[right] - anchor[left],
+						a = (anchor[right] - pos) / h,
+						b = 1.0 - a;
+
+				celsius = a * value[left] + b * value[right]
+					+ ((a * a * a - a) * second[left]
+						+ (b * b * b - b) * second[right]) * h * h / 6.0;
+			}
+
+			EMDailyValue daily;
+			daily.year = station.STARTYEAR + k / 12;
+			daily.month = k % 12 + 1;
+			daily.day = pos - start[k] + 1;
+			daily.celsius = celsius;
+			out.push_back(daily);
+		}
+	}
+
+	return out.size();
+}
+
+
+int64
+EMDailyInterpolator	::	WriteCSV	(const std::vector<Station*>& stations,
+									const std::string& path,
+									TScale scale) const
+{
+	EMOutputWriter file;
+	if (!file.Open(path))
+		return -1;
+
+	file.Write("STATION,DATE,TEMP\n");
+
+	// Render a batch of stations in parallel, then write the batch out in
+	// order before starting the next, so memory stays bounded.
+	int32 batch = LThreadCount() * DAILY_BATCH_PER_THREAD;
+	std::vector<std::string> text(batch);
+	std::vector<std::vector<EMDailyValue> > scratch(LThreadCount());
+	std::vector<std::vector<float> > temperatures(LThreadCount());
+	int64 written = 0;
+
+	for (size_t first = 0; first < stations.size(); first += batch) {
+		int32 count = std::min<size_t>(batch, stations.size() - first);
+		std::vector<int32> produced(count, 0);
+
+		LParallelFor(count, [&](int32 begin, int32 end, int32 thread) {
+			auto& values = scratch[thread];
+			for (int32 i = begin; i < end; ++i) {
+				const Station& station = *stations[first + i];
+				produced[i] = Generate(station, values);
+
+				// the whole series into the output scale in one pass
+				auto& temps = temperatures[thread];
+				temps.resize(values.size());
+				for (size_t v = 0; v < values.size(); ++v)
+					temps[v] = values[v].celsius;
+				LConvertTemperatures(Celsius, scale, temps.data(), temps.data(),
+					temps.size());
+
+				char prefix[LFORMAT_MAX];
+				char* prefixEnd = LFormatInt(prefix, station.ID);
+				*prefixEnd++ = ',';
+				int32 prefixLength = prefixEnd - prefix;
+
+				std::string& out = text[i];
+				out.resize(values.size() * (prefixLength + 12 + LFORMAT_MAX));
+
+				char* cursor = &out[0];
+				for (size_t v = 0; v < values.size(); ++v) {
+					const EMDailyValue& value = values[v];
+					cursor = std::copy(prefix, prefix + prefixLength, cursor);
+					cursor = _FormatDate(cursor, value.year, value.month,
+						value.day);
+					*cursor++ = ',';
+					cursor = LFormatFixed(cursor, temps[v], 2);
+					*cursor++ = '\n';
+				}
+				out.resize(cursor - out.data());
+			}
+		}, 1);
+
+		for (int32 i = 0; i < count; ++i) {
+			file.Write(text[i]);
+			written += produced[i];
+		}
+	}
+
+	return file.Close() ? written : -1;
+}
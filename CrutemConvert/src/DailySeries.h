@@ -0,0 +1,85 @@
+#ifndef EM_DAILY_SERIES_H
+#define EM_DAILY_SERIES_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+#include "Temperature.h"
+
+/*
+	Produces a station's whole daily series in one linear pass, rather than
+	asking Station::AverageFor(EMDate, false) for every day in turn.
+
+	Each month's value is anchored at the middle of the month.  The anchor
+	positions (in days from January 1st of the station's first year) are
+	laid out once per station, then the days are walked in order with the
+	bracketing anchors advancing alongside them:
+
+		INTERPOLATE_LINEAR	Straight lines between neighbouring months'
+							anchors, the same estimate AverageFor() makes.
+							A day whose neighbouring month is missing
+							takes its own month's value.
+
+		INTERPOLATE_CUBIC	A natural cubic spline through each run of
+							consecutive valid months, with the real
+							(uneven) month lengths as knot spacing.  Runs
+							of one or two months fall back to linear.
+
+	Days within a missing month produce nothing.  With a step of N, only
+	every Nth day from the start of the record is produced.
+
+		EMDailyInterpolator daily(INTERPOLATE_CUBIC);
+		daily.Generate(*station, [](const EMDailyValue& value) { ... });
+
+		// or all stations, rendered in parallel, as CSV lines of
+		// "STATION,YYYY-MM-DD,TEMP" (TEMP in Celsius unless told otherwise)
+		daily.WriteCSV(StationList, "data/daily.csv");
+*/
+
+enum EMInterpolation {
+	INTERPOLATE_LINEAR = 0,
+	INTERPOLATE_CUBIC
+};
+
+
+struct EMDailyValue {
+	int32				year;
+	int16				month;
+	int16				day;
+	float				celsius;
+};
+
+
+class	EMDailyInterpolator {
+public:
+								EMDailyInterpolator(
+									EMInterpolation = INTERPOLATE_LINEAR,
+									int32 step = 1);
+	virtual						~EMDailyInterpolator();
+
+			EMInterpolation		Mode		() const;
+			int32				Step		() const;
+
+			// Returns the number of values produced.
+			int32				Generate	(const Station&,
+									std::function<void(const EMDailyValue&)>)
+										const;
+			int32				Generate	(const Station&,
+									std::vector<EMDailyValue>&) const;
+
+			// Writes every station's series, in list order.  Returns the
+			// number of values written, or -1 if the file can't be written.
+			int64				WriteCSV	(const std::vector<Station*>&,
+											const std::string& path,
+											TScale scale = Celsius) const;
+
+private:
+		EMInterpolation			fMode;
+		int32					fStep;
+};
+
+
+#endif // EM_DAILY_SERIES_H
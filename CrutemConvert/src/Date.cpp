@@ -131,55 +131,61 @@ EMDate	::	DaysInMonth	(int16 month) const
 
 
 int64
-EMDate	::	DaysFrom	(EMDate date)
-{	// due to our large date range with pre-big bang reference point
-	// we can't use the easy ways :-(
-	// This method isn't 100% accurate, sometimes being off by a day,
-	// but this is good enough for my needs, for now.
-
-	EMDate* first = nullptr, *second = first;
-
-	if (*this > date) {
-		first = &date;
-		second = this;
-	} else if (*this < date) {
-		first = this;
-		second = &date;
-	} else
-		return 0;
-
-	// brute force method (sadly, and I'm lazy, I just need it to work)
-	EMDate temp = *first;
-
-	int64 lastYear = 0, lastMonth = 0, days = 0;
-
-	while (temp < *second) {
-		temp += 1_year;
-		lastYear = temp.IsLeapYear() ? 366 : 365;
-		days += lastYear;
-	}
-	days -= lastYear;
-	temp -= 1_year;
+EMDate	::	DaysFrom	(EMDate date) const
+{	// always the distance, whichever comes first
+	int64 days = EpochDay() - date.EpochDay();
+	return days < 0 ? -days : days;
+}
 
-	while (temp < *second) {
-		temp += 1_month;
-		lastMonth = temp.DaysInMonth();
-		days += lastMonth;
-	}
-	days -= lastMonth;
-	temp -= 1_month;
 
-	while (temp < *second) {
-		temp += 1_day;
-		++days;
-	}
+int64
+EMDate	::	EpochDay	() const
+{	// Years are shifted to start in March, so the leap day is the last day
+	// of the year, then counted in 400 year eras of 146097 days.
+	int64	year = IsYearValid() ? fYear : 0,
+			month = IsMonthValid() ? fMonth : 1,
+			day = fDay > 0 ? fDay : 1;
+
+	if (month <= 2)
+		--year;
+
+	int64	era = (year >= 0 ? year : year - 399) / 400,
+			yearOfEra = year - era * 400,
+			dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5
+				+ day - 1,
+			dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100
+				+ dayOfYear;
+
+	return era * 146097 + dayOfEra - 719468;	// 719468: 0000-03-01 to 1970
+}
 
-	while (temp > *second) {
-		temp -= 1_day;
-		--days;
-	}
 
-	return days;
+EMDate
+EMDate	::	FromEpochDay(int64 epochDay)
+{
+	int64	shifted = epochDay + 719468,
+			era = (shifted >= 0 ? shifted : shifted - 146096) / 146097,
+			dayOfEra = shifted - era * 146097,
+			yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524
+				- dayOfEra / 146096) / 365,
+			dayOfYear = dayOfEra
+				- (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100),
+			shiftedMonth = (5 * dayOfYear + 2) / 153,
+			day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1,
+			month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+
+	return EMDate(yearOfEra + era * 400 + (month <= 2 ? 1 : 0), month, day);
+}
+
+
+EMDate&
+EMDate	::	AddDays		(int64 days)
+{	// negative to go backwards
+	int16 keepDay = fKeepDay;
+	*this = FromEpochDay(EpochDay() + days);
+	fKeepDay = keepDay;
+	_enforceKeepDay();
+	return *this;
 }
 
 
@@ -233,6 +239,8 @@ EMDate	::	operator += (const EMDate& other)
 			fDay = other.fDay;
 			_rollDay();
 		}
+		else if (_isComplete() && !IsKeepDaySet())
+			*this = FromEpochDay(EpochDay() + other.fDay);
 		else {
 			fDay += other.fDay;
 			_rollDay();
@@ -277,7 +285,9 @@ EMDate	::	operator -= (const EMDate& other)
 		return *this;	// you can't subtract from an invalid date
 
 	if (other.fDay > 0) {
-		if (IsDayValid()) {
+		if (_isComplete() && !IsKeepDaySet())
+			*this = FromEpochDay(EpochDay() - other.fDay);
+		else if (IsDayValid()) {
 			fDay -= other.fDay;
 			_rollDay();
 			_rollMonth();
@@ -311,6 +321,13 @@ EMDate	::	operator -= (const EMDate& other)
 //#pragma mark private
 
 
+bool
+EMDate	::	_isComplete	() const
+{
+	return IsYearValid() && IsMonthValid() && IsDayValid();
+}
+
+
 void
 EMDate	::	_rollDay()
 {
@@ -88,6 +88,20 @@
 		If the keep day was 30 or 31, the results get even more crazy!
 		As such, you should just use months and years to change the date
 		when you are trying to keep the same day of the month.
+
+	Epoch days:
+
+	A date can be turned into a signed count of days from Jan 1, 1970 on the
+	proleptic Gregorian calendar, and back, in constant time - whole 400 year
+	eras of 146097 days, then the days within the era:
+
+		int64 day = date.EpochDay();
+		EMDate later = EMDate::FromEpochDay(day + 90);
+
+	Unset month or day fields count as the first of the year/month.
+	DaysFrom(), AddDays(), and adding/subtracting days to a full date with
+	no keep day set all go through this, so they cost the same however far
+	apart the dates are.
 */
 
 
@@ -109,10 +123,14 @@ public:
 				int16			KeepDay		() const;
 				void			SetKeepDay	(int16);
 
-				bool			IsLeapYear	(int64 = INT32_MAX) const;
+				bool			IsLeapYear	(int64 = INT64_MAX) const;
 				int16			DaysInMonth	(int16 = 0) const;
 
-				int64			DaysFrom	(EMDate);
+				int64			DaysFrom	(EMDate) const;
+
+				int64			EpochDay	() const;
+	static		EMDate			FromEpochDay(int64);
+				EMDate&			AddDays		(int64);
 
 				void			PrintToStream() const;
 
@@ -122,6 +140,7 @@ public:
 		EMDate&	operator -= (const EMDate& other);
 
 private:
+				bool			_isComplete	() const;
 				void			_rollDay();
 				void			_rollMonth();
 				bool			_enforceKeepDay();
@@ -181,7 +200,7 @@ bool	operator < (const EMDate&, const EMDate&);
 
 constexpr	EMDate	::	EMDate()
 	:
-	fYear(INT32_MAX),
+	fYear(INT64_MAX),
 	fMonth(0),
 	fDay(0),
 	fKeepDay(0)
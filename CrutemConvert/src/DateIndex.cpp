@@ -0,0 +1,116 @@
+#include "DateIndex.h"
+
+
+EMMonthIndex	::	EMMonthIndex(const EMDate& date)
+	:
+	fValue(DATE_INDEX_INVALID)
+{
+	if (date.IsYearValid() && date.IsMonthValid())
+		fValue = date.Year() * 12 + date.Month() - 1;
+}
+
+
+EMDate
+EMMonthIndex	::	ToDate		() const
+{
+	if (!IsValid())
+		return EMDate();
+
+	return EMDate(Year(), Month());
+}
+
+
+EMMonthIndex&
+EMMonthIndex	::	operator ++	()
+{
+	++fValue;
+	return *this;
+}
+
+
+EMMonthIndex&
+EMMonthIndex	::	operator --	()
+{
+	--fValue;
+	return *this;
+}
+
+
+EMMonthIndex&
+EMMonthIndex	::	operator +=	(int32_t months)
+{
+	fValue += months;
+	return *this;
+}
+
+
+EMMonthIndex&
+EMMonthIndex	::	operator -=	(int32_t months)
+{
+	fValue -= months;
+	return *this;
+}
+
+
+//#pragma mark EMDayIndex
+
+
+EMDayIndex	::	EMDayIndex(const EMDate& date)
+	:
+	fValue(DATE_INDEX_INVALID)
+{
+	if (date.IsYearValid() && date.IsMonthValid())
+		fValue = date.EpochDay();
+}
+
+
+EMMonthIndex
+EMDayIndex	::	MonthIndex	() const
+{
+	if (!IsValid())
+		return EMMonthIndex();
+
+	return EMMonthIndex(ToDate());
+}
+
+
+EMDate
+EMDayIndex	::	ToDate		() const
+{
+	if (!IsValid())
+		return EMDate();
+
+	return EMDate::FromEpochDay(fValue);
+}
+
+
+EMDayIndex&
+EMDayIndex	::	operator ++	()
+{
+	++fValue;
+	return *this;
+}
+
+
+EMDayIndex&
+EMDayIndex	::	operator --	()
+{
+	--fValue;
+	return *this;
+}
+
+
+EMDayIndex&
+EMDayIndex	::	operator +=	(int32_t days)
+{
+	fValue += days;
+	return *this;
+}
+
+
+EMDayIndex&
+EMDayIndex	::	operator -=	(int32_t days)
+{
+	fValue -= days;
+	return *this;
+}
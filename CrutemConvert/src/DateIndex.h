@@ -0,0 +1,297 @@
+#ifndef EM_DATE_INDEX_H
+#define EM_DATE_INDEX_H
+
+#include <cstdint>
+
+#include "Date.h"
+#include "StdTypedefs.h"
+
+/*
+	Packed, 32-bit stand-ins for EMDate in code which walks dates in bulk.
+
+	EMMonthIndex is a count of months from January of year 0:
+
+		year * 12 + (month - 1)
+
+	EMDayIndex is a count of days from Jan 1, 1970 - the same count as
+	EMDate::EpochDay() - on the proleptic Gregorian calendar.
+
+	Neither has unset fields or keep days.  Comparing, incrementing or
+	taking the distance between two of them is one integer operation, and
+	building one from a year, month and day is constexpr, through the
+	calendar tables below:
+
+		constexpr EMMonthIndex start(1961, 1);
+		for (EMMonthIndex month = start; month < end; ++month)
+			sum += station->AverageFor(month).toCelsius();
+
+	Converting to or from an EMDate is explicit.  A date without a year or
+	month becomes an invalid index; a date without a day becomes the first
+	of its month.
+
+		EMMonthIndex month(date);
+		EMDate date = month.ToDate();	// day unset
+*/
+
+#define	DATE_INDEX_INVALID		INT32_MIN
+
+
+// [leap][month - 1]
+static constexpr int32_t kDaysInMonth[2][12] = {
+	{ 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 },
+	{ 31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 }
+};
+
+// [leap][month - 1], days in the year before the first of the month
+static constexpr int32_t kDaysBeforeMonth[2][13] = {
+	{ 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334, 365 },
+	{ 0, 31, 60, 91, 121, 152, 182, 213, 244, 274, 305, 335, 366 }
+};
+
+
+constexpr int32_t	LFloorDiv	(int32_t value, int32_t divisor)
+{
+	return value >= 0 ? value / divisor : -((divisor - 1 - value) / divisor);
+}
+
+
+constexpr bool		LIsLeapYear	(int32_t year)
+{
+	return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+
+constexpr int32_t	LDaysInMonth(int32_t year, int32_t month)
+{
+	return kDaysInMonth[LIsLeapYear(year) ? 1 : 0][month - 1];
+}
+
+
+// leap years in [0, year), negative for years before 0
+constexpr int32_t	LLeapYearsBefore(int32_t year)
+{
+	return LFloorDiv(year + 3, 4) - LFloorDiv(year + 99, 100)
+		+ LFloorDiv(year + 399, 400);
+}
+
+
+constexpr int32_t	LEpochDay	(int32_t year, int32_t month, int32_t day)
+{
+	return (year - 1970) * 365
+		+ LLeapYearsBefore(year) - LLeapYearsBefore(1970)
+		+ kDaysBeforeMonth[LIsLeapYear(year) ? 1 : 0][month - 1]
+		+ day - 1;
+}
+
+
+class	EMMonthIndex {
+public:
+	constexpr					EMMonthIndex();
+	constexpr					EMMonthIndex(int32_t year, int32_t month);
+	explicit					EMMonthIndex(const EMDate&);
+
+	static constexpr EMMonthIndex	FromValue(int32_t);
+
+	constexpr	int32_t			Value		() const;
+	constexpr	bool			IsValid		() const;
+
+	constexpr	int32_t			Year		() const;
+	constexpr	int32_t			Month		() const;	// 1 - 12
+	constexpr	int32_t			DaysInMonth	() const;
+
+				EMDate			ToDate		() const;
+
+	constexpr	int32_t			operator -	(const EMMonthIndex&) const;
+
+				EMMonthIndex&	operator ++	();
+				EMMonthIndex&	operator --	();
+				EMMonthIndex&	operator +=	(int32_t months);
+				EMMonthIndex&	operator -=	(int32_t months);
+
+private:
+				int32_t			fValue;
+};
+
+
+class	EMDayIndex {
+public:
+	constexpr					EMDayIndex();
+	constexpr					EMDayIndex(int32_t year, int32_t month,
+									int32_t day);
+	explicit					EMDayIndex(const EMDate&);
+
+	static constexpr EMDayIndex	FromValue	(int32_t);
+
+	constexpr	int32_t			Value		() const;
+	constexpr	bool			IsValid		() const;
+
+				EMMonthIndex	MonthIndex	() const;
+				EMDate			ToDate		() const;
+
+	constexpr	int32_t			operator -	(const EMDayIndex&) const;
+
+				EMDayIndex&		operator ++	();
+				EMDayIndex&		operator --	();
+				EMDayIndex&		operator +=	(int32_t days);
+				EMDayIndex&		operator -=	(int32_t days);
+
+private:
+				int32_t			fValue;
+};
+
+
+constexpr bool operator == (const EMMonthIndex& a, const EMMonthIndex& b)
+{
+	return a.Value() == b.Value();
+}
+
+constexpr bool operator != (const EMMonthIndex& a, const EMMonthIndex& b)
+{
+	return a.Value() != b.Value();
+}
+
+constexpr bool operator < (const EMMonthIndex& a, const EMMonthIndex& b)
+{
+	return a.Value() < b.Value();
+}
+
+constexpr bool operator > (const EMMonthIndex& a, const EMMonthIndex& b)
+{
+	return a.Value() > b.Value();
+}
+
+constexpr bool operator <= (const EMMonthIndex& a, const EMMonthIndex& b)
+{
+	return a.Value() <= b.Value();
+}
+
+constexpr bool operator >= (const EMMonthIndex& a, const EMMonthIndex& b)
+{
+	return a.Value() >= b.Value();
+}
+
+
+constexpr bool operator == (const EMDayIndex& a, const EMDayIndex& b)
+{
+	return a.Value() == b.Value();
+}
+
+constexpr bool operator != (const EMDayIndex& a, const EMDayIndex& b)
+{
+	return a.Value() != b.Value();
+}
+
+constexpr bool operator < (const EMDayIndex& a, const EMDayIndex& b)
+{
+	return a.Value() < b.Value();
+}
+
+constexpr bool operator > (const EMDayIndex& a, const EMDayIndex& b)
+{
+	return a.Value() > b.Value();
+}
+
+constexpr bool operator <= (const EMDayIndex& a, const EMDayIndex& b)
+{
+	return a.Value() <= b.Value();
+}
+
+constexpr bool operator >= (const EMDayIndex& a, const EMDayIndex& b)
+{
+	return a.Value() >= b.Value();
+}
+
+
+// Constructors and constexpr members
+
+constexpr	EMMonthIndex	::	EMMonthIndex()
+	:
+	fValue(DATE_INDEX_INVALID)
+	{}
+
+constexpr	EMMonthIndex	::	EMMonthIndex(int32_t year, int32_t month)
+	:
+	fValue(year * 12 + month - 1)
+	{}
+
+constexpr EMMonthIndex
+EMMonthIndex	::	FromValue	(int32_t value)
+{
+	return EMMonthIndex(LFloorDiv(value, 12), value - LFloorDiv(value, 12) * 12
+		+ 1);
+}
+
+constexpr int32_t
+EMMonthIndex	::	Value		() const
+{
+	return fValue;
+}
+
+constexpr bool
+EMMonthIndex	::	IsValid		() const
+{
+	return fValue != DATE_INDEX_INVALID;
+}
+
+constexpr int32_t
+EMMonthIndex	::	Year		() const
+{
+	return LFloorDiv(fValue, 12);
+}
+
+constexpr int32_t
+EMMonthIndex	::	Month		() const
+{
+	return fValue - LFloorDiv(fValue, 12) * 12 + 1;
+}
+
+constexpr int32_t
+EMMonthIndex	::	DaysInMonth	() const
+{
+	return LDaysInMonth(Year(), Month());
+}
+
+constexpr int32_t
+EMMonthIndex	::	operator -	(const EMMonthIndex& other) const
+{
+	return fValue - other.fValue;
+}
+
+
+constexpr	EMDayIndex	::	EMDayIndex()
+	:
+	fValue(DATE_INDEX_INVALID)
+	{}
+
+constexpr	EMDayIndex	::	EMDayIndex(int32_t year, int32_t month,
+	int32_t day)
+	:
+	fValue(LEpochDay(year, month, day))
+	{}
+
+constexpr EMDayIndex
+EMDayIndex	::	FromValue	(int32_t value)
+{
+	return EMDayIndex(1970, 1, 1 + value);
+}
+
+constexpr int32_t
+EMDayIndex	::	Value		() const
+{
+	return fValue;
+}
+
+constexpr bool
+EMDayIndex	::	IsValid		() const
+{
+	return fValue != DATE_INDEX_INVALID;
+}
+
+constexpr int32_t
+EMDayIndex	::	operator -	(const EMDayIndex& other) const
+{
+	return fValue - other.fValue;
+}
+
+
+#endif // EM_DATE_INDEX_H
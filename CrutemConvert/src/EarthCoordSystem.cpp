@@ -33,7 +33,7 @@ EMCoordRect	::	Width() const
 float
 EMCoordRect	::	Height() const
 {
-	return South - North;
+	return North - South;
 }
 
 
@@ -82,13 +82,15 @@ bool
 EMCoordRect	::	Contains	(float lat, float lon) const
 {
 	// If it falls on our eastern or southern edge or inside our
-	// borders, it is ours, otherwise not.
-
-	// TODO: make exception for north pole? Probably not needed...
+	// borders, it is ours, otherwise not.  Nothing is west of -180 or
+	// north of the pole, so -180 is taken as +180 and the pole belongs
+	// to the cells along it.
+	if (lon == -180)
+		lon = 180;
 
 	// The order of the checks are to optimize OoO branch prediction
 	// and cache locality.  No, seriously.
-	return 	(lat > West && lon > North)
-		&&	(lat<= East	&& lon <= South);
+	return 	(lon > West && (lat < North || (lat == 90 && North == 90)))
+		&&	(lon <= East && lat >= South);
 }
 
@@ -23,7 +23,7 @@ typedef struct	EMCoordinate	{
 
 class	EMCoordRect {
 public:
-	// Organized clockwise
+	// Organized clockwise, North > South
 	float			West,	//	x, lon, left
 					North,	//	y, lat, top
 					East,	//	x, lon, right
@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdint.h>
+#include <string.h>
+
+#include "OutputWriter.h"
+#include "Parallel.h"
+
+#include "GridCube.h"
+
+
+EMGridCube	::	EMGridCube(EMCubeValues values, TScale scale)
+	:
+	fValues(values),
+	fScale(scale),
+	fBaseFirst(CUBE_BASE_FIRST_YEAR),
+	fBaseLast(CUBE_BASE_LAST_YEAR),
+	fBaseMinYears(CUBE_BASE_MIN_YEARS),
+	fRows(0),
+	fColumns(0),
+	fMonths(0),
+	fLatStep(0),
+	fLonStep(0)
+{
+}
+
+
+EMGridCube	::	~EMGridCube()
+{
+}
+
+
+void
+EMGridCube	::	SetBasePeriod(int32 firstYear, int32 lastYear, int32 minYears)
+{
+	fBaseFirst = firstYear;
+	fBaseLast = lastYear;
+	fBaseMinYears = minYears > 0 ? minYears : 1;
+}
+
+
+int64
+EMGridCube	::	Fill	(const std::vector<Station*>& stations,
+							float fineDegrees, int32 level)
+{
+	EMGridPyramid pyramid(fineDegrees);
+	if (fValues != CUBE_ANOMALY) {
+		pyramid.Build(stations);
+		return Fill(pyramid, level);
+	}
+
+	// the stations as anomalies from their own normals, binned as usual
+	std::vector<std::unique_ptr<Station> > anomalies(stations.size());
+	LParallelFor(stations.size(), [&](int32 begin, int32 end, int32) {
+		for (int32 i = begin; i < end; ++i) {
+			anomalies[i].reset(new Station());
+			_Anomalies(*stations[i], *anomalies[i]);
+		}
+	}, 16);
+
+	std::vector<Station*> gridded;
+	for (const auto& station : anomalies) {
+		if (station->DATA != nullptr)
+			gridded.push_back(station.get());
+	}
+
+	pyramid.Build(gridded);
+	return Fill(pyramid, level);
+}
+
+
+int64
+EMGridCube	::	Fill	(const EMGridPyramid& pyramid, int32 level)
+{
+	fRows = pyramid.Rows(level);
+	fColumns = pyramid.Columns(level);
+	fMonths = pyramid.MonthCount();
+	fFirstMonth = pyramid.FirstMonth();
+	fLatStep = pyramid.LatStep(level);
+	fLonStep = pyramid.LonStep(level);
+
+	const int32	cells = fRows * fColumns;
+	const float	nan = std::numeric_limits<float>::quiet_NaN();
+
+	fData.assign((size_t)fMonths * cells, nan);
+	if (fMonths <= 0)
+		return 0;
+
+	std::vector<std::vector<float> > scratch(LThreadCount());
+	std::vector<int64> filled(LThreadCount(), 0);
+
+	LParallelFor(cells, [&](int32 begin, int32 end, int32 thread) {
+		std::vector<float>& series = scratch[thread];
+		series.resize(fMonths);
+
+		for (int32 cell = begin; cell < end; ++cell) {
+			bool any = false;
+			for (int32 m = 0; m < fMonths; ++m) {
+				series[m] = pyramid.Mean(level, cell, m);
+				any |= series[m] > -99;
+			}
+			if (!any)
+				continue;
+
+			if (fValues == CUBE_ANOMALY) {
+				LConvertDifferences(Celsius, fScale, series.data(),
+					series.data(), fMonths);
+			} else {
+				LConvertTemperatures(Celsius, fScale, series.data(),
+					series.data(), fMonths);
+			}
+
+			// missing values came through the conversion untouched
+			float* out = fData.data() + cell;
+			for (int32 m = 0; m < fMonths; ++m, out += cells) {
+				if (series[m] != (float)SERIES_MISSING) {
+					*out = series[m];
+					filled[thread]++;
+				}
+			}
+		}
+	}, 8);
+
+	int64 total = 0;
+	for (int64 count : filled)
+		total += count;
+
+	return total;
+}
+
+
+EMCubeValues
+EMGridCube	::	Values	() const
+{
+	return fValues;
+}
+
+
+TScale
+EMGridCube	::	Scale	() const
+{
+	return fScale;
+}
+
+
+int32
+EMGridCube	::	Rows	() const
+{
+	return fRows;
+}
+
+
+int32
+EMGridCube	::	Columns	() const
+{
+	return fColumns;
+}
+
+
+int32
+EMGridCube	::	MonthCount() const
+{
+	return fMonths;
+}
+
+
+EMMonthIndex
+EMGridCube	::	FirstMonth() const
+{
+	return fFirstMonth;
+}
+
+
+float
+EMGridCube	::	LatStep	() const
+{
+	return fLatStep;
+}
+
+
+float
+EMGridCube	::	LonStep	() const
+{
+	return fLonStep;
+}
+
+
+const float*
+EMGridCube	::	Data	() const
+{
+	return fData.data();
+}
+
+
+const float*
+EMGridCube	::	Frame	(int32 month) const
+{
+	return fData.data() + (size_t)month * fRows * fColumns;
+}
+
+
+float
+EMGridCube	::	Value	(int32 month, int32 row, int32 column) const
+{
+	return Frame(month)[row * fColumns + column];
+}
+
+
+bool
+EMGridCube	::	Write	(const std::string& path) const
+{
+	EMOutputWriter file;
+	if (!file.Open(path))
+		return false;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	// swapped a block at a time through the writer's buffer
+	std::vector<uint32_t> swapped(OUTPUT_BUFFER_SIZE / sizeof(uint32_t));
+	for (size_t first = 0; first < fData.size(); first += swapped.size()) {
+		size_t count = std::min(swapped.size(), fData.size() - first);
+		memcpy(swapped.data(), fData.data() + first, count * sizeof(float));
+		for (size_t i = 0; i < count; ++i)
+			swapped[i] = __builtin_bswap32(swapped[i]);
+		file.Write((const char*)swapped.data(), count * sizeof(float));
+	}
+#else
+	file.Write((const char*)fData.data(), fData.size() * sizeof(float));
+#endif
+
+	return file.Close() && _WriteHeader(path + ".json");
+}
+
+
+//#pragma mark private
+
+
+void
+EMGridCube	::	_Anomalies	(const Station& station, Station& out) const
+{	// out keeps DATA null if the station has no normal for any month.
+	int32 years = station.ENDYEAR - station.STARTYEAR;
+	if (years <= 0 || station.DATA == nullptr)
+		return;
+
+	double	sum[12] = { 0 };
+	int32	count[12] = { 0 };
+	for (int32 y = std::max<int32>(fBaseFirst - station.STARTYEAR, 0);
+		y < std::min<int32>(fBaseLast + 1 - station.STARTYEAR, years); ++y) {
+		const YearData& yd = station.DATA[y];
+		if (!yd.VALID)
+			continue;
+		for (int16 m = 0; m < 12; ++m) {
+			float value = yd.MonthValue(m + 1);
+			if (value > -99) {
+				sum[m] += value;
+				count[m]++;
+			}
+		}
+	}
+
+	float	normal[12];
+	bool	any = false;
+	for (int16 m = 0; m < 12; ++m) {
+		normal[m] = count[m] >= fBaseMinYears
+			? sum[m] / count[m] : SERIES_MISSING;
+		any |= count[m] >= fBaseMinYears;
+	}
+	if (!any)
+		return;
+
+	out.ID = station.ID;
+	out.LAT = station.LAT;
+	out.LON = station.LON;
+	out.ELEV = station.ELEV;
+	out.STARTYEAR = station.STARTYEAR;
+	out.ENDYEAR = station.ENDYEAR;
+	out.DATA = new YearData[years];
+
+	for (int32 y = 0; y < years; ++y) {
+		const YearData& yd = station.DATA[y];
+		YearData& anomaly = out.DATA[y];
+		anomaly.VALID = yd.VALID;
+		anomaly.YEAR = yd.YEAR;
+		for (int16 m = 0; m < 12; ++m) {
+			float value = yd.MonthValue(m + 1);
+			anomaly.SetMonthValue(m + 1, value > -99 && normal[m] > -99
+				? value - normal[m] : SERIES_MISSING);
+		}
+	}
+}
+
+
+bool
+EMGridCube	::	_WriteHeader(const std::string& path) const
+{
+	EMOutputWriter file;
+	if (!file.Open(path))
+		return false;
+
+	// the first row's and column's centres, then the steps between them
+	float	firstLat = 90.0 - fLatStep / 2,
+			firstLon = -180.0 + fLonStep / 2;
+
+	file.Write("{\n");
+	file.Write("\t\"format\": \"float32\",\n");
+	file.Write("\t\"byteOrder\": \"little\",\n");
+	file.Write("\t\"missing\": \"NaN\",\n");
+	file.Write("\t\"dimensions\": [\"month\", \"lat\", \"lon\"],\n");
+	file.Write("\t\"shape\": [").WriteInt(fMonths).Write(", ")
+		.WriteInt(fRows).Write(", ").WriteInt(fColumns).Write("],\n");
+	file.Write("\t\"values\": \"")
+		.Write(fValues == CUBE_ANOMALY ? "anomaly" : "absolute").Write("\",\n");
+	if (fValues == CUBE_ANOMALY) {
+		file.Write("\t\"basePeriod\": [").WriteInt(fBaseFirst).Write(", ")
+			.WriteInt(fBaseLast).Write("],\n");
+	}
+	file.Write("\t\"units\": \"").Write(LScaleName(fScale)).Write("\",\n");
+	file.Write("\t\"lat\": { \"first\": ").WriteGeneral(firstLat)
+		.Write(", \"step\": ").WriteGeneral(-fLatStep).Write(" },\n");
+	file.Write("\t\"lon\": { \"first\": ").WriteGeneral(firstLon)
+		.Write(", \"step\": ").WriteGeneral(fLonStep).Write(" },\n");
+	file.Write("\t\"time\": { \"firstYear\": ").WriteInt(fFirstMonth.Year())
+		.Write(", \"firstMonth\": ").WriteInt(fFirstMonth.Month())
+		.Write(", \"step\": \"month\" }\n");
+	file.Write("}\n");
+
+	return file.Close();
+}
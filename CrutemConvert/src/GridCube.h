@@ -0,0 +1,115 @@
+#ifndef EM_GRID_CUBE_H
+#define EM_GRID_CUBE_H
+
+#include <string>
+#include <vector>
+
+#include "DateIndex.h"
+#include "GridPyramid.h"
+#include "StdTypedefs.h"
+#include "Temperature.h"
+
+/*
+	One level of an EMGridPyramid as a flat array of floats, for tools which
+	would rather map a file than parse CSV.
+
+	The cube is month major: one rows x columns frame per month, rows from
+	the north, columns from the west, as the pyramid numbers its cells:
+
+		value = data[(month * rows + row) * columns + column]
+
+	Cells without data are NaN.  Values are either the cells' absolute
+	means or, as CRUTEM grids them, the mean of their stations' anomalies.
+	Each station's anomalies are from its own normal for that calendar
+	month over a base period (1961-1990 unless told otherwise), so a cell
+	doesn't step when a warmer or colder station joins or leaves it.  A
+	station with fewer than the minimum years of a calendar month in the
+	base period has no anomalies for that month.
+
+	Write() stores the floats little-endian whatever the host, with nothing
+	before or after them, and a JSON description of the grid and time axis
+	beside them, at path + ".json":
+
+		EMGridCube cube(CUBE_ANOMALY);
+		cube.Fill(StationList, 5.0);
+		cube.Write("data/grid.f32");	// and data/grid.f32.json
+
+	Given a pyramid instead, the cube takes its values as they are; an
+	absolute cube can so share the pyramid the rest of the run uses.
+
+	Stations' anomalies and cells are worked out in parallel.
+*/
+
+enum EMCubeValues {
+	CUBE_ABSOLUTE = 0,
+	CUBE_ANOMALY
+};
+
+
+#define	CUBE_BASE_FIRST_YEAR	1961
+#define	CUBE_BASE_LAST_YEAR		1990
+#define	CUBE_BASE_MIN_YEARS		15
+
+
+class	EMGridCube {
+public:
+								EMGridCube(EMCubeValues = CUBE_ABSOLUTE,
+									TScale scale = Celsius);
+	virtual						~EMGridCube();
+
+			void				SetBasePeriod(int32 firstYear,
+											int32 lastYear,
+											int32 minYears
+												= CUBE_BASE_MIN_YEARS);
+
+			// Both return the number of values which aren't NaN.  The
+			// stations are gridded fineDegrees on a side.
+			int64				Fill		(const std::vector<Station*>&,
+											float fineDegrees = 5.0,
+											int32 level = 0);
+			// The pyramid's means as they are: temperatures, or anomalies
+			// (converted as differences) for CUBE_ANOMALY.
+			int64				Fill		(const EMGridPyramid&,
+											int32 level = 0);
+
+			EMCubeValues		Values		() const;
+			TScale				Scale		() const;
+
+			int32				Rows		() const;
+			int32				Columns		() const;
+			int32				MonthCount	() const;
+			EMMonthIndex		FirstMonth	() const;
+			float				LatStep		() const;
+			float				LonStep		() const;
+
+			const float*		Data		() const;
+			const float*		Frame		(int32 month) const;
+			float				Value		(int32 month, int32 row,
+											int32 column) const;
+
+			bool				Write		(const std::string& path) const;
+
+private:
+			void				_Anomalies	(const Station&,
+											Station& out) const;
+			bool				_WriteHeader(const std::string& path) const;
+
+		EMCubeValues			fValues;
+		TScale					fScale;
+
+		int32					fBaseFirst;
+		int32					fBaseLast;
+		int32					fBaseMinYears;
+
+		int32					fRows;
+		int32					fColumns;
+		int32					fMonths;
+		EMMonthIndex			fFirstMonth;
+		float					fLatStep;
+		float					fLonStep;
+
+		std::vector<float>		fData;
+};
+
+
+#endif // EM_GRID_CUBE_H
@@ -0,0 +1,397 @@
+#include <algorithm>
+#include <cmath>
+
+#include "MathUtils.h"
+#include "Parallel.h"
+
+#include "GridPyramid.h"
+
+
+static bool
+_Divides(float step, float span)
+{	// span is a whole number of steps
+	double count = span / step;
+	return step > 0 && fabs(count - round(count)) < 1e-4;
+}
+
+
+EMGridPyramid	::	EMGridPyramid(float fineDegrees)
+	:
+	fMonthCount(0)
+{
+	if (!AddLevel(fineDegrees, fineDegrees))
+		AddLevel(5.0, 5.0);
+}
+
+
+EMGridPyramid	::	~EMGridPyramid()
+{
+	_Clear();
+}
+
+
+bool
+EMGridPyramid	::	AddLevel	(float latDegrees, float lonDegrees)
+{
+	if (!_Divides(latDegrees, 180.0) || !_Divides(lonDegrees, 360.0))
+		return false;
+
+	if (!fLevels.empty()
+		&& (!_Divides(fLevels.back().latStep, latDegrees)
+			|| !_Divides(fLevels.back().lonStep, lonDegrees)))
+		return false;
+
+	_Level level;
+	level.latStep = latDegrees;
+	level.lonStep = lonDegrees;
+	level.rows = round(180.0 / latDegrees);
+	level.columns = round(360.0 / lonDegrees);
+	level.areas = EMCellAreaTable(latDegrees, lonDegrees);
+	fLevels.push_back(level);
+	return true;
+}
+
+
+void
+EMGridPyramid	::	Build		(const std::vector<Station*>& stations)
+{
+	if (fLevels.size() == 1) {
+		// the usual reports; any the fine grid doesn't divide are skipped
+		AddLevel(10.0, 10.0);
+		AddLevel(30.0, 30.0);
+		AddLevel(30.0, 360.0);
+		AddLevel(90.0, 360.0);
+		AddLevel(180.0, 360.0);
+	}
+
+	_Clear();
+	_BuildFine(stations);
+
+	for (size_t level = 1; level < fLevels.size(); ++level)
+		_BuildLevel(level);
+}
+
+
+int32
+EMGridPyramid	::	LevelCount	() const
+{
+	return fLevels.size();
+}
+
+
+float
+EMGridPyramid	::	LatStep		(int32 level) const
+{
+	return fLevels.at(level).latStep;
+}
+
+
+float
+EMGridPyramid	::	LonStep		(int32 level) const
+{
+	return fLevels.at(level).lonStep;
+}
+
+
+int32
+EMGridPyramid	::	Rows		(int32 level) const
+{
+	return fLevels.at(level).rows;
+}
+
+
+const EMCellAreaTable&
+EMGridPyramid	::	Areas		(int32 level) const
+{
+	return fLevels.at(level).areas;
+}
+
+
+int32
+EMGridPyramid	::	Columns		(int32 level) const
+{
+	return fLevels.at(level).columns;
+}
+
+
+int32
+EMGridPyramid	::	CellCount	(int32 level) const
+{
+	return fLevels.at(level).rows * fLevels.at(level).columns;
+}
+
+
+int32
+EMGridPyramid	::	OccupiedCount(int32 level) const
+{
+	return fLevels.at(level).cellOf.size();
+}
+
+
+int32
+EMGridPyramid	::	CellFor		(int32 level, float lat, float lon) const
+{	// southern and eastern edges belong to the cell, as with EMCoordRect;
+	// -180 is +180 and the north pole is in the top row
+	const _Level& grid = fLevels.at(level);
+	if (lon == -180)
+		lon = 180;
+
+	int32	row = lat == 90 ? 0 : ceil((90.0 - lat) / grid.latStep) - 1,
+			column = ceil((lon + 180.0) / grid.lonStep) - 1;
+
+	if (row < 0 || row >= grid.rows || column < 0 || column >= grid.columns)
+		return -1;
+
+	return row * grid.columns + column;
+}
+
+
+EMCoordRect
+EMGridPyramid	::	CellRect	(int32 level, int32 cell) const
+{
+	const _Level& grid = fLevels.at(level);
+
+	EMCoordRect rect;
+	rect.West = -180.0 + (cell % grid.columns) * grid.lonStep;
+	rect.East = rect.West + grid.lonStep;
+	rect.North = 90.0 - (cell / grid.columns) * grid.latStep;
+	rect.South = rect.North - grid.latStep;
+	return rect;
+}
+
+
+EMCoordCell*
+EMGridPyramid	::	FineCell	(int32 cell) const
+{
+	if (cell < 0 || cell >= (int32)fCells.size())
+		return nullptr;
+
+	return fCells[cell];
+}
+
+
+EMMonthIndex
+EMGridPyramid	::	FirstMonth	() const
+{
+	return fFirstMonth;
+}
+
+
+int32
+EMGridPyramid	::	MonthCount	() const
+{
+	return fMonthCount;
+}
+
+
+float
+EMGridPyramid	::	Mean		(int32 level, int32 cell, int32 month) const
+{
+	int32 offset = _Offset(level, cell, month);
+	if (offset < 0)
+		return SERIES_MISSING;
+
+	return fLevels[level].mean[offset];
+}
+
+
+float
+EMGridPyramid	::	Weight		(int32 level, int32 cell, int32 month) const
+{
+	int32 offset = _Offset(level, cell, month);
+	return offset < 0 ? 0.0 : fLevels[level].weight[offset];
+}
+
+
+int32
+EMGridPyramid	::	Count		(int32 level, int32 cell, int32 month) const
+{
+	int32 offset = _Offset(level, cell, month);
+	return offset < 0 ? 0 : fLevels[level].count[offset];
+}
+
+
+//#pragma mark private
+
+
+void
+EMGridPyramid	::	_Clear		()
+{
+	for (auto* cell : fCells)
+		delete cell;
+
+	fCells.clear();
+
+	for (auto& level : fLevels) {
+		level.rowOf.clear();
+		level.cellOf.clear();
+		level.mean.clear();
+		level.weight.clear();
+		level.count.clear();
+	}
+
+	fFirstMonth = EMMonthIndex();
+	fMonthCount = 0;
+}
+
+
+void
+EMGridPyramid	::	_BuildFine	(const std::vector<Station*>& stations)
+{
+	int32 firstYear = INT32_MAX, endYear = INT32_MIN;
+	for (const auto* station : stations) {
+		if (station->DATA == nullptr)
+			continue;
+
+		firstYear = std::min(firstYear, station->STARTYEAR);
+		endYear = std::max(endYear, station->ENDYEAR);
+	}
+
+	if (endYear <= firstYear) {
+		firstYear = 0;
+		endYear = 0;
+	}
+
+	fFirstMonth = EMMonthIndex(firstYear, 1);
+	fMonthCount = (endYear - firstYear) * 12;
+
+	// the only pass over the stations
+	_Level& fine = fLevels[0];
+	fCells.assign(CellCount(0), nullptr);
+	fine.rowOf.assign(CellCount(0), -1);
+
+	for (auto* station : stations) {
+		int32 cell = CellFor(0, station->LAT, station->LON);
+		if (cell < 0 || station->DATA == nullptr)
+			continue;
+
+		if (fCells[cell] == nullptr)
+			fCells[cell] = new EMCoordCell(CellRect(0, cell), fine.areas);
+
+		fCells[cell]->Insert(station);
+	}
+
+	for (int32 cell = 0; cell < (int32)fCells.size(); ++cell) {
+		if (fCells[cell] == nullptr || fCells[cell]->Count() == 0)
+			continue;
+
+		fine.rowOf[cell] = fine.cellOf.size();
+		fine.cellOf.push_back(cell);
+	}
+
+	size_t values = fine.cellOf.size() * (size_t)fMonthCount;
+	fine.mean.assign(values, SERIES_MISSING);
+	fine.weight.assign(values, 0.0f);
+	fine.count.assign(values, 0);
+
+	LParallelFor(fine.cellOf.size(), [this, &fine](int32 begin, int32 end,
+		int32) {
+		for (int32 row = begin; row < end; ++row) {
+			EMCoordCell* cell = fCells[fine.cellOf[row]];
+			float area = cell->Area();
+
+			cell->PrepareSeries();
+
+			size_t offset = (size_t)row * fMonthCount;
+			EMMonthIndex month = fFirstMonth;
+			for (int32 m = 0; m < fMonthCount; ++m, ++month) {
+				int32 count = cell->CountFor(month);
+				if (count == 0)
+					continue;
+
+				fine.mean[offset + m] = cell->AverageFor(month).toCelsius();
+				fine.weight[offset + m] = area;
+				fine.count[offset + m] = count;
+			}
+		}
+	}, 4);
+}
+
+
+void
+EMGridPyramid	::	_BuildLevel	(int32 index)
+{
+	const _Level& child = fLevels[index - 1];
+	_Level& level = fLevels[index];
+
+	int32	rowRatio = round(level.latStep / child.latStep),
+			columnRatio = round(level.lonStep / child.lonStep);
+
+	// parents of the occupied children, and which children each one has
+	std::vector<int32> parentOf(child.cellOf.size());
+	level.rowOf.assign(CellCount(index), -1);
+
+	for (size_t row = 0; row < child.cellOf.size(); ++row) {
+		int32	cell = child.cellOf[row],
+				parent = (cell / child.columns / rowRatio) * level.columns
+					+ (cell % child.columns) / columnRatio;
+
+		parentOf[row] = parent;
+		level.rowOf[parent] = 0;
+	}
+
+	for (int32 cell = 0; cell < CellCount(index); ++cell) {
+		if (level.rowOf[cell] < 0)
+			continue;
+
+		level.rowOf[cell] = level.cellOf.size();
+		level.cellOf.push_back(cell);
+	}
+
+	std::vector<std::vector<int32> > children(level.cellOf.size());
+	for (size_t row = 0; row < parentOf.size(); ++row)
+		children[level.rowOf[parentOf[row]]].push_back(row);
+
+	size_t values = level.cellOf.size() * (size_t)fMonthCount;
+	level.mean.assign(values, SERIES_MISSING);
+	level.weight.assign(values, 0.0f);
+	level.count.assign(values, 0);
+
+	LParallelFor(level.cellOf.size(), [&](int32 begin, int32 end, int32) {
+		std::vector<double> sum, weight;
+
+		for (int32 row = begin; row < end; ++row) {
+			sum.assign(fMonthCount, 0.0);
+			weight.assign(fMonthCount, 0.0);
+
+			size_t offset = (size_t)row * fMonthCount;
+
+			for (int32 childRow : children[row]) {
+				size_t from = (size_t)childRow * fMonthCount;
+				for (int32 m = 0; m < fMonthCount; ++m) {
+					float w = child.weight[from + m];
+					if (w <= 0)
+						continue;
+
+					sum[m] += (double)w * child.mean[from + m];
+					weight[m] += w;
+					level.count[offset + m] += child.count[from + m];
+				}
+			}
+
+			for (int32 m = 0; m < fMonthCount; ++m) {
+				if (weight[m] <= 0)
+					continue;
+
+				level.mean[offset + m] = sum[m] / weight[m];
+				level.weight[offset + m] = weight[m];
+			}
+		}
+	}, 1);
+}
+
+
+int32
+EMGridPyramid	::	_Offset		(int32 level, int32 cell, int32 month) const
+{	// into the level's value arrays, or -1
+	if (level < 0 || level >= (int32)fLevels.size()
+		|| month < 0 || month >= fMonthCount
+		|| cell < 0 || cell >= (int32)fLevels[level].rowOf.size())
+		return -1;
+
+	int32 row = fLevels[level].rowOf[cell];
+	if (row < 0)
+		return -1;
+
+	return row * fMonthCount + month;
+}
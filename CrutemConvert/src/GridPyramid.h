@@ -0,0 +1,115 @@
+#ifndef EM_GRID_PYRAMID_H
+#define EM_GRID_PYRAMID_H
+
+#include <vector>
+
+#include "AreaTable.h"
+#include "CoordCell.h"
+#include "DateIndex.h"
+#include "EarthCoordSystem.h"
+#include "SeriesTable.h"
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+
+/*
+	Area-weighted monthly means at several grid resolutions from a single
+	binning of the stations.
+
+	Level 0 is a grid of EMCoordCells, `fineDegrees` on a side.  Stations
+	are inserted into those cells once; each cell's monthly value is the
+	mean of its stations (the cell's own cached series), weighted by the
+	cell's area on the sphere, read from the level's EMCellAreaTable.
+
+	Every coarser level is built only from the level below it: a parent's
+	value is the weighted mean of its children's values, its weight the sum
+	of the children's weights which had data, and its station count the sum
+	of theirs.  As weights only ever add up, a level comes out the same as
+	weighting the fine cells under it directly - so each level must divide
+	evenly into the one above it.
+
+	Without AddLevel() calls, Build() adds the usual set on top of the fine
+	grid: 10 and 30 degree cells, 30 degree zonal bands, hemispheres, and
+	the globe.
+
+		EMGridPyramid pyramid(5.0);
+		pyramid.Build(StationList);
+
+		int32 level = pyramid.LevelCount() - 1;		// global
+		float value = pyramid.Mean(level, 0, month);
+
+	Cells are numbered row by row from the north-west corner.  Only cells
+	with at least one station carry storage.  Values are absolute station
+	temperatures, in celsius, as with the rest of the cell code.
+*/
+
+class	EMGridPyramid {
+public:
+								EMGridPyramid(float fineDegrees = 5.0);
+	virtual						~EMGridPyramid();
+
+			// Coarser levels, in order.  Fails unless each level is a
+			// whole number of cells of the level below and of the globe.
+			bool				AddLevel	(float latDegrees,
+											float lonDegrees);
+
+			void				Build		(const std::vector<Station*>&);
+
+			int32				LevelCount	() const;
+			float				LatStep		(int32 level) const;
+			float				LonStep		(int32 level) const;
+			int32				Rows		(int32 level) const;
+			const EMCellAreaTable&	Areas	(int32 level) const;
+			int32				Columns		(int32 level) const;
+			int32				CellCount	(int32 level) const;
+			int32				OccupiedCount(int32 level) const;
+
+			int32				CellFor		(int32 level, float lat,
+											float lon) const;
+			EMCoordRect			CellRect	(int32 level, int32 cell) const;
+
+			// level 0 only; nullptr where no station fell
+			EMCoordCell*		FineCell	(int32 cell) const;
+
+			EMMonthIndex		FirstMonth	() const;
+			int32				MonthCount	() const;
+
+			// month counts from FirstMonth().  Mean is SERIES_MISSING
+			// without data, Weight is the area (km^2) which had data.
+			float				Mean		(int32 level, int32 cell,
+											int32 month) const;
+			float				Weight		(int32 level, int32 cell,
+											int32 month) const;
+			int32				Count		(int32 level, int32 cell,
+											int32 month) const;
+
+private:
+		struct _Level {
+			float				latStep;
+			float				lonStep;
+			int32				rows;
+			int32				columns;
+			EMCellAreaTable		areas;
+
+			std::vector<int32>	rowOf;	// cell -> storage row, or -1
+			std::vector<int32>	cellOf;	// storage row -> cell
+
+			std::vector<float>	mean;	// rows x months
+			std::vector<float>	weight;
+			std::vector<int32_t> count;
+		};
+
+			void				_Clear		();
+			void				_BuildFine	(const std::vector<Station*>&);
+			void				_BuildLevel	(int32 level);
+			int32				_Offset		(int32 level, int32 cell,
+											int32 month) const;
+
+		std::vector<_Level>		fLevels;
+		std::vector<EMCoordCell*> fCells;
+
+		EMMonthIndex			fFirstMonth;
+		int32					fMonthCount;
+};
+
+
+#endif // EM_GRID_PYRAMID_H
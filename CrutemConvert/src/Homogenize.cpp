@@ -0,0 +1,413 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#include "Parallel.h"
+
+#include "Homogenize.h"
+
+
+// 95% points of T, after Khaliq & Ouarda (2007); interpolated on log(n)
+static const float kSNHTCritical[][2] = {
+	{ 10, 5.70 }, { 20, 6.95 }, { 30, 7.65 }, { 40, 8.10 }, { 50, 8.45 },
+	{ 70, 8.80 }, { 100, 9.15 }, { 150, 9.50 }, { 200, 9.70 },
+	{ 250, 9.85 }, { 500, 10.30 }
+};
+
+
+struct _Sums {
+	std::vector<double>	x;		// running sums, n + 1 each
+	std::vector<double>	xx;
+};
+
+
+static void
+_Split(const _Sums& sums, const std::vector<int32>& years, int32 begin,
+	int32 end, int32 station, std::vector<EMBreakpoint>& out)
+{	// test [begin, end) and recurse into both sides of a break
+	int32 n = end - begin;
+	if (n < HOMOGENIZE_MIN_SEGMENT * 2)
+		return;
+
+	double	mean = (sums.x[end] - sums.x[begin]) / n,
+			variance = (sums.xx[end] - sums.xx[begin]) / n - mean * mean;
+	if (variance <= 1e-12)
+		return;
+
+	double	best = 0;
+	int32	split = -1;
+
+	for (int32 k = begin + HOMOGENIZE_MIN_SEGMENT;
+		k <= end - HOMOGENIZE_MIN_SEGMENT; ++k) {
+		int32	before = k - begin,
+				after = end - k;
+		double	one = sums.x[k] - sums.x[begin] - before * mean,
+				two = sums.x[end] - sums.x[k] - after * mean,
+				t = (one * one / before + two * two / after) / variance;
+
+		if (t > best) {
+			best = t;
+			split = k;
+		}
+	}
+
+	if (split < 0 || best <= EMHomogenizer::CriticalValue(n))
+		return;
+
+	EMBreakpoint breakpoint;
+	breakpoint.station = station;
+	breakpoint.year = years[split];
+	breakpoint.shift = 0;
+	breakpoint.statistic = best;
+	out.push_back(breakpoint);
+
+	_Split(sums, years, begin, split, station, out);
+	_Split(sums, years, split, end, station, out);
+}
+
+
+EMHomogenizer	::	EMHomogenizer(const EMSeriesTable& table,
+						const EMCorrelationGraph& graph)
+	:
+	fTable(table),
+	fGraph(graph),
+	fTested(0),
+	fPasses(0)
+{
+}
+
+
+EMHomogenizer	::	~EMHomogenizer()
+{
+}
+
+
+int32
+EMHomogenizer	::	Run		(int32 minNeighbours)
+{
+	int32 stations = fTable.StationCount();
+	std::vector<std::vector<EMBreakpoint> > found(stations), previous;
+	std::vector<std::vector<float> > shifts(stations);
+	std::vector<uint8> retest(stations, 1), changed(stations, 0);
+
+	for (fPasses = 1; ; ++fPasses) {
+		previous = found;
+		int32 tested = _Pass(shifts, retest, minNeighbours, found);
+		if (fPasses == 1)
+			fTested = tested;
+
+		// Keep only breaks which survive from the last pass, give or take
+		// HOMOGENIZE_SLACK years, so the set can only shrink.
+		bool settled = true;
+		for (int32 i = 0; i < stations; ++i) {
+			changed[i] = 0;
+			if (!retest[i])
+				continue;
+
+			if (fPasses > 1) {
+				std::vector<EMBreakpoint>& breaks = found[i];
+				breaks.erase(std::remove_if(breaks.begin(), breaks.end(),
+					[&](const EMBreakpoint& breakpoint) {
+						for (const auto& last : previous[i]) {
+							if (last.year >= breakpoint.year - HOMOGENIZE_SLACK
+								&& last.year <= breakpoint.year
+									+ HOMOGENIZE_SLACK)
+								return false;
+						}
+						return true;
+					}), breaks.end());
+			}
+
+			changed[i] = found[i].size() != previous[i].size()
+				|| !std::equal(found[i].begin(), found[i].end(),
+					previous[i].begin(),
+					[](const EMBreakpoint& one, const EMBreakpoint& two) {
+						return one.year == two.year;
+					});
+			if (changed[i])
+				settled = false;
+		}
+
+		if (settled || fPasses == HOMOGENIZE_MAX_PASSES)
+			break;
+
+		// the new shifts of each station whose breaks changed, for every
+		// year of the table
+		for (int32 i = 0; i < stations; ++i) {
+			if (!changed[i])
+				continue;
+
+			shifts[i].clear();
+			if (found[i].empty())
+				continue;
+
+			shifts[i].assign(fTable.MonthCount() / 12, 0.0f);
+			for (const auto& breakpoint : found[i]) {
+				int32 end = std::min(breakpoint.year - fTable.FirstYear(),
+					(int32)shifts[i].size());
+				for (int32 y = 0; y < end; ++y)
+					shifts[i][y] += breakpoint.shift;
+			}
+		}
+
+		// A station's own series never changes, so only those with a
+		// changed neighbour can come out differently.
+		for (int32 i = 0; i < stations; ++i) {
+			int32 count = 0;
+			const EMNeighbour* neighbours = fGraph.NeighboursOf(i, count);
+
+			retest[i] = 0;
+			for (int32 n = 0; n < count && !retest[i]; ++n)
+				retest[i] = changed[neighbours[n].index];
+		}
+	}
+
+	fBreakpoints.clear();
+	for (const auto& breaks : found)
+		fBreakpoints.insert(fBreakpoints.end(), breaks.begin(), breaks.end());
+
+	return fBreakpoints.size();
+}
+
+
+int32
+EMHomogenizer	::	Store	() const
+{
+	int32 written = 0;
+
+	for (size_t b = 0; b < fBreakpoints.size(); ) {
+		int32 row = fBreakpoints[b].station;
+		size_t end = b;
+		while (end < fBreakpoints.size() && fBreakpoints[end].station == row)
+			++end;
+
+		Station* station = fTable.StationAt(row);
+		int32 years = station->ENDYEAR - station->STARTYEAR;
+
+		for (int32 y = 0; y < years && station->DATA != nullptr; ++y) {
+			YearData& yd = station->DATA[y];
+			if (!yd.VALID)
+				continue;
+
+			// every break after this year shifts it
+			double shift = 0;
+			for (size_t k = b; k < end; ++k) {
+				if (fBreakpoints[k].year > station->STARTYEAR + y)
+					shift += fBreakpoints[k].shift;
+			}
+
+			if (shift == 0)
+				continue;
+
+			for (int16 m = 1; m <= 12; ++m) {
+				float value = yd.MonthValue(m);
+				if (value > -99) {
+					yd.SetMonthValue(m, value + shift);
+					++written;
+				}
+			}
+		}
+
+		station->InvalidateRanges();
+		b = end;
+	}
+
+	return written;
+}
+
+
+const std::vector<EMBreakpoint>&
+EMHomogenizer	::	Breakpoints	() const
+{
+	return fBreakpoints;
+}
+
+
+int32
+EMHomogenizer	::	TestedCount	() const
+{
+	return fTested;
+}
+
+
+int32
+EMHomogenizer	::	PassCount	() const
+{
+	return fPasses;
+}
+
+
+int32
+EMHomogenizer	::	AdjustedCount() const
+{
+	int32 count = 0;
+	for (size_t b = 0; b < fBreakpoints.size(); ++b) {
+		if (b == 0 || fBreakpoints[b].station != fBreakpoints[b - 1].station)
+			++count;
+	}
+
+	return count;
+}
+
+
+float
+EMHomogenizer	::	CriticalValue(int32 years)
+{
+	const int32 count = sizeof(kSNHTCritical) / sizeof(kSNHTCritical[0]);
+
+	if (years <= kSNHTCritical[0][0])
+		return kSNHTCritical[0][1];
+
+	for (int32 i = 1; i < count; ++i) {
+		if (years > kSNHTCritical[i][0])
+			continue;
+
+		double	low = log(kSNHTCritical[i - 1][0]),
+				high = log(kSNHTCritical[i][0]),
+				t = (log((double)years) - low) / (high - low);
+
+		return kSNHTCritical[i - 1][1]
+			+ t * (kSNHTCritical[i][1] - kSNHTCritical[i - 1][1]);
+	}
+
+	return kSNHTCritical[count - 1][1];
+}
+
+
+//#pragma mark private
+
+
+int32
+EMHomogenizer	::	_Pass	(const std::vector<std::vector<float> >& shifts,
+								const std::vector<uint8>& retest,
+								int32 minNeighbours,
+								std::vector<std::vector<EMBreakpoint> >& found)
+									const
+{	// tests the stations marked for it; returns the number tested
+	int32 stations = fTable.StationCount();
+	std::atomic<int32> tested(0);
+
+	LParallelFor(stations, [&](int32 begin, int32 end, int32) {
+		std::vector<double>	refSum, refWeight;
+		std::vector<float>	adjusted;
+		std::vector<int32>	years;
+		_Sums				sums;
+
+		for (int32 i = begin; i < end; ++i) {
+			if (!retest[i])
+				continue;
+
+			found[i].clear();
+
+			int32 count = 0;
+			const EMNeighbour* neighbours = fGraph.NeighboursOf(i, count);
+			if (count < minNeighbours)
+				continue;
+
+			int32	first = fTable.FirstMonth(i) / 12 * 12,
+					last = fTable.EndMonth(i),
+					months = last - first;
+			if (months < HOMOGENIZE_MIN_SEGMENT * 24)
+				continue;
+
+			const float*	anomaly = fTable.Anomalies(i) + first;
+			const float*	valid = fTable.Mask(i) + first;
+
+			// Reference: correlation^2 weighted neighbour anomalies, less
+			// the breaks found in them so far, each first offset to the
+			// station's mean over the months they share, so neighbours
+			// coming and going don't step it.
+			refSum.assign(months, 0.0);
+			refWeight.assign(months, 0.0);
+			adjusted.resize(months);
+			for (int32 n = 0; n < count; ++n) {
+				int32			j = neighbours[n].index;
+				const float*	other = fTable.Anomalies(j) + first;
+				const float*	otherValid = fTable.Mask(j) + first;
+				double			weight = neighbours[n].correlation
+									* neighbours[n].correlation,
+								offset = 0,
+								shared = 0;
+
+				for (int32 m = 0; m < months; ++m) {
+					adjusted[m] = shifts[j].empty() ? other[m]
+						: other[m] + shifts[j][(first + m) / 12];
+				}
+
+				for (int32 m = 0; m < months; ++m) {
+					float both = valid[m] * otherValid[m];
+					offset += both * (anomaly[m] - adjusted[m]);
+					shared += both;
+				}
+
+				if (shared == 0)
+					continue;
+
+				offset /= shared;
+				for (int32 m = 0; m < months; ++m) {
+					refSum[m] += weight * otherValid[m]
+						* (adjusted[m] + offset);
+					refWeight[m] += weight * otherValid[m];
+				}
+			}
+
+			// annual means of station - reference, and their running sums
+			years.clear();
+			sums.x.assign(1, 0.0);
+			sums.xx.assign(1, 0.0);
+
+			for (int32 y = 0; y < months; y += 12) {
+				double	accum = 0;
+				int32	used = 0;
+				for (int32 m = y; m < y + 12 && m < months; ++m) {
+					if (valid[m] == 0.0f || refWeight[m] <= 0)
+						continue;
+
+					accum += anomaly[m] - refSum[m] / refWeight[m];
+					++used;
+				}
+
+				if (used < HOMOGENIZE_MIN_MONTHS)
+					continue;
+
+				double difference = accum / used;
+				years.push_back(fTable.FirstYear() + (first + y) / 12);
+				sums.x.push_back(sums.x.back() + difference);
+				sums.xx.push_back(sums.xx.back() + difference * difference);
+			}
+
+			tested++;
+
+			std::vector<EMBreakpoint>& breaks = found[i];
+			_Split(sums, years, 0, years.size(), i, breaks);
+			if (breaks.empty())
+				continue;
+
+			std::sort(breaks.begin(), breaks.end(),
+				[](const EMBreakpoint& one, const EMBreakpoint& two) {
+					return one.year < two.year;
+				});
+
+			// shift: mean of the segment after the break minus the one
+			// before, segments running between neighbouring breaks
+			int32 previous = 0;
+			for (size_t b = 0; b < breaks.size(); ++b) {
+				int32	split = std::lower_bound(years.begin(), years.end(),
+							breaks[b].year) - years.begin(),
+						next = b + 1 < breaks.size()
+							? std::lower_bound(years.begin(), years.end(),
+								breaks[b + 1].year) - years.begin()
+							: (int32)years.size();
+
+				double	before = (sums.x[split] - sums.x[previous])
+							/ (split - previous),
+						after = (sums.x[next] - sums.x[split]) / (next - split);
+
+				breaks[b].shift = after - before;
+				previous = split;
+			}
+		}
+	}, 4);
+
+	return tested;
+}
@@ -0,0 +1,108 @@
+#ifndef EM_HOMOGENIZE_H
+#define EM_HOMOGENIZE_H
+
+#include <vector>
+
+#include "Correlation.h"
+#include "SeriesTable.h"
+#include "StdTypedefs.h"
+
+/*
+	Finds and removes step changes - station moves, new instruments,
+	changed observing times - from station records, by the standard normal
+	homogeneity test (SNHT) against the station's neighbours.
+
+	For each station, a reference series is built from its graph
+	neighbours' anomalies, weighted by correlation squared, and subtracted
+	from the station's own anomalies.  Whatever the neighbours share (the
+	climate) cancels; a step in the difference belongs to the station.  The
+	difference is averaged to years (those with at least
+	HOMOGENIZE_MIN_MONTHS of it) and standardized, and for a split after
+	year k of n:
+
+		T(k) = k * mean(z[0, k))^2 + (n - k) * mean(z[k, n))^2
+
+	The largest T(k), if above the 95% critical value for n, is a
+	breakpoint; both sides are then tested again on their own.  Every
+	segment's mean and variance, and every T(k), come from the same
+	running sums of the difference and its square, so testing a station
+	costs one pass over its neighbours and one over its years.
+
+	Segments are shifted onto the most recent one: each breakpoint's shift
+	is the mean difference after it minus the mean before, and is added to
+	every earlier month.
+
+	A break in one station is also in its neighbours' references, weakly,
+	so testing once would give them small false breaks of their own.  So
+	testing is repeated: each pass tests stations' original anomalies
+	against neighbours adjusted by the breaks the last pass found in them.
+	A break is kept only if the pass before found one within
+	HOMOGENIZE_SLACK years of it, so breaks can disappear but never appear,
+	and passes stop once no station's breaks change (or after
+	HOMOGENIZE_MAX_PASSES).  After the first pass only stations with a
+	changed neighbour are tested again.  Within a pass stations are tested
+	in parallel, so the order they run in doesn't matter.  Store() writes
+	the adjusted values back into the stations' data.
+
+		EMHomogenizer homogenizer(table, graph);
+		homogenizer.Run();
+		homogenizer.Store();
+*/
+
+#define	HOMOGENIZE_MIN_NEIGHBOURS	2
+#define	HOMOGENIZE_MIN_MONTHS		9	// for a year of the difference
+#define	HOMOGENIZE_MIN_SEGMENT		5	// years either side of a break
+#define	HOMOGENIZE_MAX_PASSES		10
+#define	HOMOGENIZE_SLACK			1	// years a break may move between passes
+
+
+struct EMBreakpoint {
+	int32				station;	// table row
+	int32				year;		// first year after the break
+	float				shift;		// added to everything before it
+	float				statistic;	// T(k)
+};
+
+
+class	EMHomogenizer {
+public:
+								EMHomogenizer(const EMSeriesTable&,
+									const EMCorrelationGraph&);
+	virtual						~EMHomogenizer();
+
+			// Returns the number of breakpoints found.
+			int32				Run			(int32 minNeighbours
+												= HOMOGENIZE_MIN_NEIGHBOURS);
+
+			// Writes the shifted values into the stations' data.  Returns
+			// the number of months changed.
+			int32				Store		() const;
+
+			const std::vector<EMBreakpoint>&
+								Breakpoints	() const;
+			int32				TestedCount	() const;	// stations
+			int32				AdjustedCount() const;	// stations
+			int32				PassCount	() const;	// by the last Run()
+
+			// approximate 95% critical value of T for n years
+	static	float				CriticalValue(int32 years);
+
+private:
+			int32				_Pass		(const std::vector<
+												std::vector<float> >& shifts,
+											const std::vector<uint8>& retest,
+											int32 minNeighbours,
+											std::vector<std::vector<
+												EMBreakpoint> >& found) const;
+
+	const EMSeriesTable&		fTable;
+	const EMCorrelationGraph&	fGraph;
+
+		std::vector<EMBreakpoint>
+								fBreakpoints;	// by station, then year
+		int32					fTested;
+		int32					fPasses;
+};
+
+
+#endif // EM_HOMOGENIZE_H
@@ -0,0 +1,178 @@
+#include <atomic>
+#include <cmath>
+
+#include "Parallel.h"
+
+#include "Infill.h"
+
+
+struct _Estimate {
+	int32				month;
+	float				anomaly;
+};
+
+
+EMInfill	::	EMInfill(EMSeriesTable& table, const EMCorrelationGraph& graph)
+	:
+	fTable(table),
+	fGraph(graph),
+	fFilled(0),
+	fGaps(0)
+{
+}
+
+
+EMInfill	::	~EMInfill()
+{
+}
+
+
+int32
+EMInfill	::	Run		(int32 maxSpan, int32 minNeighbours)
+{
+	int32 stations = fTable.StationCount();
+	std::vector<std::vector<_Estimate> > estimates(stations);
+	std::atomic<int32> gaps(0);
+
+	if (maxSpan < 1)
+		return 0;
+
+	LParallelFor(stations, [&](int32 begin, int32 end, int32) {
+		std::vector<float> weights;
+
+		for (int32 i = begin; i < end; ++i) {
+			int32 count = 0;
+			const EMNeighbour* neighbours = fGraph.NeighboursOf(i, count);
+			if (count == 0)
+				continue;
+
+			weights.resize(count);
+			for (int32 n = 0; n < count; ++n) {
+				float r = neighbours[n].correlation;
+				weights[n] = r * r * exp(-neighbours[n].distance
+					/ INFILL_DECAY_KM);
+			}
+
+			const Station* station = fTable.StationAt(i);
+			const float* valid = fTable.Mask(i);
+			int32	month = fTable.FirstMonth(i),
+					last = fTable.EndMonth(i),
+					offset = fTable.MonthIndex(station->STARTYEAR, 1);
+
+			while (month < last) {
+				if (valid[month] != 0.0f) {
+					++month;
+					continue;
+				}
+
+				int32 gapEnd = month;
+				while (gapEnd < last && valid[gapEnd] == 0.0f)
+					++gapEnd;
+
+				if (gapEnd - month <= maxSpan) {
+					size_t before = estimates[i].size();
+					for (int32 m = month; m < gapEnd; ++m) {
+						// Store() can't write into a year the parser
+						// rejected, so don't estimate for one
+						int32 year = (m - offset) / 12;
+						if (m < offset || station->DATA == nullptr
+							|| year >= station->ENDYEAR - station->STARTYEAR
+							|| !station->DATA[year].VALID)
+							continue;
+
+						double	accum = 0.0,
+								total = 0.0;
+						int32	used = 0;
+
+						for (int32 n = 0; n < count; ++n) {
+							int32 j = neighbours[n].index;
+							if (fTable.Mask(j)[m] == 0.0f
+								|| fTable.Provenance(j)[m]
+									!= PROVENANCE_ORIGINAL)
+								continue;
+
+							accum += weights[n] * fTable.Anomalies(j)[m];
+							total += weights[n];
+							++used;
+						}
+
+						if (used >= minNeighbours && total > 0) {
+							_Estimate estimate;
+							estimate.month = m;
+							estimate.anomaly = accum / total;
+							estimates[i].push_back(estimate);
+						}
+					}
+
+					if (estimates[i].size() > before)
+						gaps++;
+				}
+
+				month = gapEnd;
+			}
+		}
+	});
+
+	// nothing above read an infilled month, so apply them all at once
+	int32 filled = 0;
+	for (int32 i = 0; i < stations; ++i) {
+		for (const auto& estimate : estimates[i])
+			fTable.SetInfilled(i, estimate.month, estimate.anomaly);
+		filled += estimates[i].size();
+	}
+
+	fFilled += filled;
+	fGaps += gaps;
+	return filled;
+}
+
+
+int32
+EMInfill	::	Store	() const
+{
+	int32 written = 0;
+
+	for (int32 i = 0; i < fTable.StationCount(); ++i) {
+		Station* station = fTable.StationAt(i);
+		if (station->DATA == nullptr)
+			continue;
+
+		station->InvalidateRanges();
+
+		const uint8* provenance = fTable.Provenance(i);
+		int32	offset = fTable.MonthIndex(station->STARTYEAR, 1),
+				years = station->ENDYEAR - station->STARTYEAR;
+
+		for (int32 y = 0; y < years; ++y) {
+			YearData& yd = station->DATA[y];
+			if (!yd.VALID)
+				continue;
+
+			for (int16 m = 0; m < 12; ++m) {
+				int32 month = offset + y * 12 + m;
+				if (provenance[month] != PROVENANCE_INFILLED)
+					continue;
+
+				yd.SetMonthValue(m + 1, fTable.Value(i, month));
+				yd.SetInfilled(m + 1);
+				++written;
+			}
+		}
+	}
+
+	return written;
+}
+
+
+int32
+EMInfill	::	FilledCount	() const
+{
+	return fFilled;
+}
+
+
+int32
+EMInfill	::	GapCount	() const
+{
+	return fGaps;
+}
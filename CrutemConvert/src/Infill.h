@@ -0,0 +1,67 @@
+#ifndef EM_INFILL_H
+#define EM_INFILL_H
+
+#include <vector>
+
+#include "Correlation.h"
+#include "SeriesTable.h"
+#include "StdTypedefs.h"
+
+/*
+	Fills short gaps in station records from correlated neighbours.
+
+	A gap is a run of missing months between a station's first and last
+	valid month; runs longer than the maximum span are left alone, as is
+	anything before the first or after the last valid month.  Each month in
+	an eligible gap is estimated as the weighted mean of the anomalies of
+	the station's graph neighbours which measured that month:
+
+		weight = correlation^2 * exp(-distance / INFILL_DECAY_KM)
+
+	Only measured neighbour months are used - never another station's
+	infilled value - so the result does not depend on the order stations
+	are processed in.  Years the parser rejected are never estimated.
+	Stations are estimated in parallel, and the estimates are written into
+	the table (and its provenance mask) afterwards.  Store() marks each
+	month it writes in YearData::INFILLED, so it stays recognisable after
+	the table is gone - -export writes it as the INFILLED column.
+
+		EMInfill infill(table, graph);
+		infill.Run(pa->maxInfillSpan);
+		infill.Store();		// into the stations' YearData
+*/
+
+#define	INFILL_CUTOFF_KM		1200.0
+#define	INFILL_DECAY_KM			1000.0
+#define	INFILL_MIN_CORRELATION	0.5
+#define	INFILL_MIN_OVERLAP		60
+
+
+class	EMInfill {
+public:
+								EMInfill(EMSeriesTable&,
+									const EMCorrelationGraph&);
+	virtual						~EMInfill();
+
+			// Returns the number of months filled.
+			int32				Run			(int32 maxSpan,
+											int32 minNeighbours = 1);
+
+			// Writes the infilled months back into the stations' data,
+			// as climatology + anomaly.  Returns the number written.
+			int32				Store		() const;
+
+			int32				FilledCount	() const;
+			int32				GapCount	() const;	// gaps at least
+															// partly filled
+
+private:
+		EMSeriesTable&			fTable;
+	const EMCorrelationGraph&	fGraph;
+
+		int32					fFilled;
+		int32					fGaps;
+};
+
+
+#endif // EM_INFILL_H
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <limits>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "OutputWriter.h"
+#include "Parallel.h"
+
+#include "MapRenderer.h"
+
+
+#define	MAP_BATCH_PER_THREAD	2
+
+
+// RdBu, from -1 to +1
+static const float kRamp[][4] = {
+	{ -1.0,    5,  48,  97 },
+	{ -0.6,   33, 102, 172 },
+	{ -0.3,  146, 197, 222 },
+	{  0.0,  247, 247, 247 },
+	{  0.3,  244, 165, 130 },
+	{  0.6,  178,  24,  43 },
+	{  1.0,  103,   0,  31 }
+};
+
+static const uint8 kMissing[3] = { 128, 128, 128 };
+
+
+static uint8
+_Byte(double value)
+{
+	return value <= 0 ? 0 : value >= 255 ? 255 : (uint8)(value + 0.5);
+}
+
+
+EMMapRenderer	::	EMMapRenderer(int32 width, int32 height)
+	:
+	// 4:2:0 video wants both even
+	fWidth(std::max<int32>(2, (width + 1) & ~1)),
+	fHeight(std::max<int32>(2, (height + 1) & ~1)),
+	fPeriod(MAP_MONTHLY),
+	fRangeSet(false),
+	fLow(0),
+	fHigh(0)
+{
+	const int32 stops = sizeof(kRamp) / sizeof(kRamp[0]);
+
+	for (int32 i = 0; i <= MAP_LUT_SIZE; ++i) {
+		double rgb[3];
+
+		if (i == MAP_LUT_SIZE) {
+			for (int32 c = 0; c < 3; ++c)
+				rgb[c] = kMissing[c];
+		} else {
+			double	t = -1.0 + 2.0 * (i + 0.5) / MAP_LUT_SIZE;
+			int32	stop = 1;
+			while (stop < stops - 1 && t > kRamp[stop][0])
+				++stop;
+
+			double mix = (t - kRamp[stop - 1][0])
+				/ (kRamp[stop][0] - kRamp[stop - 1][0]);
+			for (int32 c = 0; c < 3; ++c) {
+				rgb[c] = kRamp[stop - 1][c + 1]
+					+ mix * (kRamp[stop][c + 1] - kRamp[stop - 1][c + 1]);
+			}
+		}
+
+		// BT.601, studio range
+		double	r = rgb[0], g = rgb[1], b = rgb[2];
+		for (int32 c = 0; c < 3; ++c)
+			fRGB[i][c] = _Byte(rgb[c]);
+
+		fYUV[i][0] = _Byte(16 + (65.738 * r + 129.057 * g + 25.064 * b) / 256);
+		fYUV[i][1] = _Byte(128 + (-37.945 * r - 74.494 * g + 112.439 * b) / 256);
+		fYUV[i][2] = _Byte(128 + (112.439 * r - 94.154 * g - 18.285 * b) / 256);
+	}
+}
+
+
+EMMapRenderer	::	~EMMapRenderer()
+{
+}
+
+
+int32
+EMMapRenderer	::	Width	() const
+{
+	return fWidth;
+}
+
+
+int32
+EMMapRenderer	::	Height	() const
+{
+	return fHeight;
+}
+
+
+void
+EMMapRenderer	::	SetPeriod	(EMMapPeriod period)
+{
+	fPeriod = period;
+}
+
+
+EMMapPeriod
+EMMapRenderer	::	Period	() const
+{
+	return fPeriod;
+}
+
+
+void
+EMMapRenderer	::	SetRange	(float low, float high)
+{
+	fRangeSet = high > low;
+	fLow = low;
+	fHigh = high;
+}
+
+
+int32
+EMMapRenderer	::	FrameCount	(const EMGridCube& cube) const
+{
+	if (fPeriod == MAP_MONTHLY)
+		return cube.MonthCount();
+
+	// years run from January, whichever month the cube starts in
+	int32 offset = cube.FirstMonth().Month() - 1;
+	return (offset + cube.MonthCount() + 11) / 12;
+}
+
+
+void
+EMMapRenderer	::	RenderFrame	(const EMGridCube& cube, int32 frame,
+									uint8* rgb) const
+{
+	_Layout layout = _Prepare(cube);
+
+	std::vector<float> values;
+	std::vector<uint8> colors;
+	_CellColors(cube, layout, frame, values, colors);
+	_RenderRGB(layout, cube, colors, rgb);
+}
+
+
+int32
+EMMapRenderer	::	WritePPM	(const EMGridCube& cube,
+									const std::string& directory) const
+{
+	if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+		return -1;
+
+	char header[64];
+	int32 headerLength = snprintf(header, sizeof(header), "P6\n%li %li\n255\n",
+		fWidth, fHeight);
+	size_t frameSize = headerLength + (size_t)fWidth * fHeight * 3;
+
+	_Layout layout = _Prepare(cube);
+	int32 frames = FrameCount(cube);
+	std::vector<std::vector<uint8> > buffers(LThreadCount());
+	std::vector<std::vector<float> > values(LThreadCount());
+	std::vector<std::vector<uint8> > colors(LThreadCount());
+	std::atomic<int32> written(0);
+	std::atomic<bool> failed(false);
+
+	LParallelFor(frames, [&](int32 begin, int32 end, int32 thread) {
+		std::vector<uint8>& buffer = buffers[thread];
+		buffer.resize(frameSize);
+		std::copy(header, header + headerLength, buffer.begin());
+
+		for (int32 frame = begin; frame < end && !failed; ++frame) {
+			_CellColors(cube, layout, frame, values[thread], colors[thread]);
+			_RenderRGB(layout, cube, colors[thread],
+				buffer.data() + headerLength);
+
+			char name[32];
+			snprintf(name, sizeof(name), "/frame_%05li.ppm", frame);
+			std::string path = directory + name;
+
+			FILE* file = fopen(path.c_str(), "wb");
+			bool ok = file != NULL
+				&& fwrite(buffer.data(), 1, frameSize, file) == frameSize;
+			if (file == NULL || fclose(file) != 0 || !ok) {
+				failed = true;
+				break;
+			}
+
+			written++;
+		}
+	}, 1);
+
+	return failed ? -1 : (int32)written;
+}
+
+
+int32
+EMMapRenderer	::	WriteY4M	(const EMGridCube& cube,
+									const std::string& path) const
+{
+	EMOutputWriter file;
+	if (!file.Open(path))
+		return -1;
+
+	char header[128];
+	snprintf(header, sizeof(header),
+		"YUV4MPEG2 W%li H%li F%li:1 Ip A1:1 C420jpeg\n", fWidth, fHeight,
+		(int32)(fPeriod == MAP_YEARLY ? MAP_FRAME_RATE / 4 : MAP_FRAME_RATE));
+	file.Write(header);
+
+	_Layout layout = _Prepare(cube);
+	size_t frameSize = (size_t)fWidth * fHeight * 3 / 2;
+
+	// Render a batch of frames in parallel, then write them out in order.
+	int32 frames = FrameCount(cube),
+		batch = LThreadCount() * MAP_BATCH_PER_THREAD;
+	std::vector<std::vector<uint8> > buffers(batch);
+	std::vector<std::vector<float> > values(LThreadCount());
+	std::vector<std::vector<uint8> > colors(LThreadCount());
+
+	for (int32 first = 0; first < frames; first += batch) {
+		int32 count = std::min(batch, frames - first);
+
+		LParallelFor(count, [&](int32 begin, int32 end, int32 thread) {
+			for (int32 i = begin; i < end; ++i) {
+				buffers[i].resize(frameSize);
+				_CellColors(cube, layout, first + i, values[thread],
+					colors[thread]);
+				_RenderYUV(layout, cube, colors[thread], buffers[i].data());
+			}
+		}, 1);
+
+		for (int32 i = 0; i < count; ++i) {
+			file.Write("FRAME\n");
+			file.Write((const char*)buffers[i].data(), frameSize);
+		}
+	}
+
+	return file.Close() ? frames : -1;
+}
+
+
+//#pragma mark private
+
+
+EMMapRenderer::_Layout
+EMMapRenderer	::	_Prepare	(const EMGridCube& cube) const
+{
+	_Layout layout;
+
+	// the cell under each pixel's centre
+	layout.rowOf.resize(fHeight);
+	for (int32 y = 0; y < fHeight; ++y) {
+		layout.rowOf[y] = std::min<int32>(cube.Rows() - 1,
+			(int32)((y + 0.5) * cube.Rows() / fHeight));
+	}
+
+	layout.columnOf.resize(fWidth);
+	for (int32 x = 0; x < fWidth; ++x) {
+		layout.columnOf[x] = std::min<int32>(cube.Columns() - 1,
+			(int32)((x + 0.5) * cube.Columns() / fWidth));
+	}
+
+	float low = fLow, high = fHigh;
+	if (!fRangeSet) {
+		double factor = LScaleFactor(Celsius, cube.Scale());
+		if (cube.Values() == CUBE_ANOMALY) {
+			low = -MAP_ANOMALY_RANGE * factor;
+			high = MAP_ANOMALY_RANGE * factor;
+		} else {
+			double offset = LScaleOffset(Celsius, cube.Scale());
+			low = -MAP_ABSOLUTE_RANGE * factor + offset;
+			high = MAP_ABSOLUTE_RANGE * factor + offset;
+		}
+	}
+
+	layout.low = low;
+	layout.scale = MAP_LUT_SIZE / (high - low);
+	return layout;
+}
+
+
+void
+EMMapRenderer	::	_CellColors	(const EMGridCube& cube,
+									const _Layout& layout, int32 frame,
+									std::vector<float>& values,
+									std::vector<uint8>& colors) const
+{	// the frame's value in each grid cell, then its ramp entry
+	const int32 cells = cube.Rows() * cube.Columns();
+
+	if (fPeriod == MAP_MONTHLY) {
+		const float* data = cube.Frame(frame);
+		values.assign(data, data + cells);
+	} else {
+		int32	offset = cube.FirstMonth().Month() - 1,
+				begin = std::max<int32>(frame * 12 - offset, 0),
+				end = std::min<int32>(frame * 12 - offset + 12,
+					cube.MonthCount());
+
+		std::vector<int32> used(cells, 0);
+		values.assign(cells, 0.0f);
+		for (int32 month = begin; month < end; ++month) {
+			const float* data = cube.Frame(month);
+			for (int32 cell = 0; cell < cells; ++cell) {
+				if (data[cell] == data[cell]) {
+					values[cell] += data[cell];
+					used[cell]++;
+				}
+			}
+		}
+
+		for (int32 cell = 0; cell < cells; ++cell) {
+			values[cell] = used[cell] >= MAP_YEAR_MIN_MONTHS
+				? values[cell] / used[cell]
+				: std::numeric_limits<float>::quiet_NaN();
+		}
+	}
+
+	colors.resize(cells);
+	for (int32 cell = 0; cell < cells; ++cell) {
+		float value = values[cell];
+		if (value != value) {
+			colors[cell] = MAP_LUT_SIZE;
+			continue;
+		}
+
+		float index = (value - layout.low) * layout.scale;
+		colors[cell] = index <= 0 ? 0 : index >= MAP_LUT_SIZE - 1
+			? MAP_LUT_SIZE - 1 : (uint8)index;
+	}
+}
+
+
+void
+EMMapRenderer	::	_RenderRGB	(const _Layout& layout,
+									const EMGridCube& cube,
+									const std::vector<uint8>& colors,
+									uint8* rgb) const
+{
+	for (int32 y = 0; y < fHeight; ++y) {
+		const uint8* row = colors.data() + layout.rowOf[y] * cube.Columns();
+		for (int32 x = 0; x < fWidth; ++x, rgb += 3) {
+			const uint8* color = fRGB[row[layout.columnOf[x]]];
+			rgb[0] = color[0];
+			rgb[1] = color[1];
+			rgb[2] = color[2];
+		}
+	}
+}
+
+
+void
+EMMapRenderer	::	_RenderYUV	(const _Layout& layout,
+									const EMGridCube& cube,
+									const std::vector<uint8>& colors,
+									uint8* yuv) const
+{	// full size Y, then U and V at half size from each 2x2 block
+	uint8*	luma = yuv;
+	uint8*	u = yuv + fWidth * fHeight;
+	uint8*	v = u + (fWidth / 2) * (fHeight / 2);
+
+	for (int32 y = 0; y < fHeight; y += 2) {
+		const uint8*	top = colors.data() + layout.rowOf[y] * cube.Columns();
+		const uint8*	bottom = colors.data()
+							+ layout.rowOf[y + 1] * cube.Columns();
+		uint8*			lumaTop = luma + y * fWidth;
+		uint8*			lumaBottom = lumaTop + fWidth;
+
+		for (int32 x = 0; x < fWidth; x += 2) {
+			const uint8*	a = fYUV[top[layout.columnOf[x]]];
+			const uint8*	b = fYUV[top[layout.columnOf[x + 1]]];
+			const uint8*	c = fYUV[bottom[layout.columnOf[x]]];
+			const uint8*	d = fYUV[bottom[layout.columnOf[x + 1]]];
+
+			lumaTop[x] = a[0];
+			lumaTop[x + 1] = b[0];
+			lumaBottom[x] = c[0];
+			lumaBottom[x + 1] = d[0];
+
+			*u++ = (a[1] + b[1] + c[1] + d[1] + 2) / 4;
+			*v++ = (a[2] + b[2] + c[2] + d[2] + 2) / 4;
+		}
+	}
+}
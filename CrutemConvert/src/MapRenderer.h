@@ -0,0 +1,114 @@
+#ifndef EM_MAP_RENDERER_H
+#define EM_MAP_RENDERER_H
+
+#include <string>
+#include <vector>
+
+#include "GridCube.h"
+#include "StdTypedefs.h"
+
+/*
+	Global maps of an EMGridCube, one frame per month or per year, on an
+	equirectangular (plate carree) image with a blue - white - red ramp.
+
+	Frames go out as binary PPM (P6) files, frame_00000.ppm onwards, or as
+	one YUV4MPEG2 (4:2:0) stream any video tool can take in.  Neither needs
+	anything beyond the C library.
+
+	Everything a frame needs that isn't the data is worked out up front: the
+	grid row and column under every image row and column, and the ramp as
+	RGB and YUV tables.  A frame is then a colour index per grid cell and a
+	table lookup per pixel.  Frames render in parallel; PPM files are
+	written by the thread that rendered them, a video a batch of frames at
+	a time, in order.
+
+		EMMapRenderer map(720, 360);
+		map.SetPeriod(MAP_YEARLY);
+		map.WriteY4M(cube, "data/map.y4m");
+
+	Without SetRange(), anomalies span -4 to +4 degrees C and absolute
+	values -40 to +40, in the cube's scale.  Cells without data are grey.
+	A year needs MAP_YEAR_MIN_MONTHS valid months to be drawn.
+*/
+
+enum EMMapPeriod {
+	MAP_MONTHLY = 0,
+	MAP_YEARLY
+};
+
+
+#define	MAP_DEFAULT_WIDTH		720
+#define	MAP_DEFAULT_HEIGHT		360
+#define	MAP_FRAME_RATE			12
+#define	MAP_LUT_SIZE			255		// + missing, still a byte
+#define	MAP_YEAR_MIN_MONTHS		6
+#define	MAP_ANOMALY_RANGE		4.0		// degrees C either side of zero
+#define	MAP_ABSOLUTE_RANGE		40.0
+
+
+class	EMMapRenderer {
+public:
+								EMMapRenderer(
+									int32 width = MAP_DEFAULT_WIDTH,
+									int32 height = MAP_DEFAULT_HEIGHT);
+	virtual						~EMMapRenderer();
+
+			int32				Width		() const;
+			int32				Height		() const;
+
+			void				SetPeriod	(EMMapPeriod);
+			EMMapPeriod			Period		() const;
+
+			// values at or beyond either end take the end's colour
+			void				SetRange	(float low, float high);
+
+			int32				FrameCount	(const EMGridCube&) const;
+
+			// width * height * 3 bytes of RGB
+			void				RenderFrame	(const EMGridCube&, int32 frame,
+											uint8* rgb) const;
+
+			// Both return the number of frames written, or -1.
+			int32				WritePPM	(const EMGridCube&,
+											const std::string& directory)
+												const;
+			int32				WriteY4M	(const EMGridCube&,
+											const std::string& path) const;
+
+private:
+		struct _Layout {
+			std::vector<int32>	rowOf;		// image row -> grid row
+			std::vector<int32>	columnOf;	// image column -> grid column
+			float				low;
+			float				scale;		// value -> ramp index
+		};
+
+			_Layout				_Prepare	(const EMGridCube&) const;
+			void				_CellColors	(const EMGridCube&, const _Layout&,
+											int32 frame,
+											std::vector<float>& values,
+											std::vector<uint8>& colors) const;
+			void				_RenderRGB	(const _Layout&,
+											const EMGridCube&,
+											const std::vector<uint8>& colors,
+											uint8* rgb) const;
+			void				_RenderYUV	(const _Layout&,
+											const EMGridCube&,
+											const std::vector<uint8>& colors,
+											uint8* yuv) const;
+
+		int32					fWidth;
+		int32					fHeight;
+		EMMapPeriod				fPeriod;
+
+		bool					fRangeSet;
+		float					fLow;
+		float					fHigh;
+
+		// the ramp, plus one entry for missing
+		uint8					fRGB[MAP_LUT_SIZE + 1][3];
+		uint8					fYUV[MAP_LUT_SIZE + 1][3];
+};
+
+
+#endif // EM_MAP_RENDERER_H
@@ -5,10 +5,6 @@
 
 #include "MathUtils.h"
 
-#ifndef M_PI    // Windows issue...
-#   define  M_PI 3.14159265358979323846
-#endif
-
 float	LMax(const float* floats, uint32 count)
 {
 	float max = FLT_MIN;
@@ -100,7 +96,10 @@ EMPoint	LCalculateCenter(const EMPoint* points, int32 count)
 double	LCalculateAreaOnSphere(const EMPoint* points, int32 count,
 	double radius)
 {
-	return LCalculateArea(LSinusProject(points, count, radius), count);
+	EMPoint* projected = LSinusProject(points, count, radius);
+	double area = LCalculateArea(projected, count);
+	delete[] projected;
+	return area;
 }
 
 
@@ -123,6 +122,14 @@ EMPoint*	LSinusProject(const EMPoint* points, int32 count, double radius)
 
 
 
+double	LBandArea(double north, double south, double lonDegrees,
+	double radius)
+{
+	return radius * radius * LRadians(lonDegrees)
+		* fabs(sin(LRadians(north)) - sin(LRadians(south)));
+}
+
+
 float	LDistance(const EMPoint& from, const EMPoint& to,
 	 float radius)	// Warning! Not throughly tested!
 {
@@ -139,6 +146,143 @@ float	LDistance(const EMPoint& from, const EMPoint& to,
 }
 
 
+static inline float
+_Sqrt(float value)
+{	// 1/sqrt by the bit trick and three Newton steps, good to about 1 ulp
+	float	half = 0.5f * value,
+			r = LBitsFloat(0x5F3759DF - (LFloatBits(value) >> 1));
+
+	r = r * (1.5f - half * r * r);
+	r = r * (1.5f - half * r * r);
+	r = r * (1.5f - half * r * r);
+
+	return value * r;
+}
+
+
+static inline float
+_Asin(float s, float sSq)
+{	// Cephes' asinf for 0 <= s <= sqrt(0.5), with sSq = s * s.  Compares
+	// are made on the bits (nothing here is negative) so that no floating
+	// point compare stands in the way of the selects.
+	int32_t	large = -(LFloatBits(sSq) > 0x3E800000);				// s > 0.5
+	float	folded = 0.5f * (1.0f - s),
+			z = LSelect(large, folded, sSq),
+			t = LSelect(large, _Sqrt(folded), s);
+
+	float p = ((((4.2163199048e-2f * z + 2.4181311049e-2f) * z
+		+ 4.5470025998e-2f) * z + 7.4953002686e-2f) * z
+		+ 1.6666752422e-1f) * z * t + t;
+
+	// asin(s) = pi/2 - 2 asin(sqrt((1 - s) / 2))
+	return LSelect(large, 1.5707963267948966f - 2.0f * p, p);
+}
+
+
+static inline float
+_ChordAngle(float chordSq, float sumSq)
+{	// The angle between unit vectors a and b, given |a - b|^2 and |a + b|^2.
+	// Half of it has sine |a - b| / 2 and cosine |a + b| / 2; taking the
+	// asin of whichever is smaller keeps near antipodes as accurate as
+	// near neighbours.
+	float	sinSq = 0.25f * chordSq,
+			cosSq = 0.25f * sumSq;
+	int32_t	far = -(LFloatBits(sinSq) > LFloatBits(cosSq));
+	float	v = LSelect(far, cosSq, sinSq),
+			half = _Asin(_Sqrt(v), v);
+
+	return 2.0f * LSelect(far, 1.5707963267948966f - half, half);
+}
+
+
+static void
+_DistanceLanes(float cx, float cy, float cz, const float* __restrict x,
+	const float* __restrict y, const float* __restrict z, float radius,
+	float* __restrict out)
+{
+	for (int32 i = 0; i < DISTANCE_LANES; ++i) {
+		float	dx = x[i] - cx,
+				dy = y[i] - cy,
+				dz = z[i] - cz,
+				sx = x[i] + cx,
+				sy = y[i] + cy,
+				sz = z[i] + cz;
+
+		out[i] = radius * _ChordAngle(dx * dx + dy * dy + dz * dz,
+			sx * sx + sy * sy + sz * sz);
+	}
+}
+
+
+static void
+_DistanceRow(float cx, float cy, float cz, const EMUnitVectors& to,
+	float radius, float* out)
+{
+	int32	count = to.x.size(),
+			i = 0;
+
+	for (; i + DISTANCE_LANES <= count; i += DISTANCE_LANES) {
+		_DistanceLanes(cx, cy, cz, &to.x[i], &to.y[i], &to.z[i], radius,
+			out + i);
+	}
+
+	if (i == count)
+		return;
+
+	// the tail, padded out to a whole block
+	float	x[DISTANCE_LANES] = {},
+			y[DISTANCE_LANES] = {},
+			z[DISTANCE_LANES] = {},
+			result[DISTANCE_LANES];
+	int32	rest = count - i;
+
+	memcpy(x, &to.x[i], rest * sizeof(float));
+	memcpy(y, &to.y[i], rest * sizeof(float));
+	memcpy(z, &to.z[i], rest * sizeof(float));
+	_DistanceLanes(cx, cy, cz, x, y, z, radius, result);
+	memcpy(out + i, result, rest * sizeof(float));
+}
+
+
+void	LUnitVectors(const EMPoint* points, int32 count, EMUnitVectors& out)
+{
+	out.x.resize(count);
+	out.y.resize(count);
+	out.z.resize(count);
+
+	for (int32 i = 0; i < count; ++i) {
+		double	lat = LRadians(points[i].y),
+				lon = LRadians(points[i].x);
+
+		out.x[i] = cos(lat) * cos(lon);
+		out.y[i] = cos(lat) * sin(lon);
+		out.z[i] = sin(lat);
+	}
+}
+
+
+void	LDistances(const EMPoint& from, const EMUnitVectors& to, float radius,
+	float* out)
+{
+	double	lat = LRadians(from.y),
+			lon = LRadians(from.x);
+
+	_DistanceRow(cos(lat) * cos(lon), cos(lat) * sin(lon), sin(lat), to,
+		radius, out);
+}
+
+
+void	LDistances(const EMUnitVectors& from, const EMUnitVectors& to,
+	float radius, float* out)
+{
+	size_t columns = to.x.size();
+
+	for (size_t f = 0; f < from.x.size(); ++f)
+		_DistanceRow(from.x[f], from.y[f], from.z[f], to, radius,
+			out + f * columns);
+}
+
+
 double	LRadians(double degrees)
 {
 	return degrees * M_PI / 180.0;
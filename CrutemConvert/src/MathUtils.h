@@ -1,9 +1,18 @@
 #ifndef L_MATH_UTILS_H
 #define L_MATH_UTILS_H
 
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
 #include "Point.h"
 #include "StdTypedefs.h"
 
+#ifndef M_PI    // Windows issue...
+#   define  M_PI 3.14159265358979323846
+#endif
+
 float	LMax(const float*, uint32 count);
 float	LMin(const float*, uint32 count);
 
@@ -12,12 +21,79 @@ double	LCalculateArea(const EMPoint*, int32 count);
 EMPoint	LCalculateCenter(const EMPoint*, int32 count);
 double	LCalculateAreaOnSphere(const EMPoint*, int32, double radius);
 
-// Convert spherical polygon into a flat representation
+// Convert spherical polygon into a flat representation, caller delete[]s
 EMPoint*	LSinusProject(const EMPoint*, int32, double radius);
 
+// Exact area between two latitudes, `lonDegrees` wide
+double	LBandArea(double north, double south, double lonDegrees,
+			double radius);
+
+// Mean radius, as used for station distances
+#define EARTH_RADIUS_KM	6371.0
+
 // Distance between two points on a sphere
 float	LDistance(const EMPoint&, const EMPoint&, float radius);
 
+/*	Batch distances
+
+	Points are given as unit vectors, one array per axis, so the distance
+	between two of them is their chord turned into an angle:
+
+		distance = radius * 2 asin(chord / 2)
+
+	The asin is a polynomial (Cephes' asinf) and the square roots are
+	Newton steps, with selects in place of branches, run DISTANCE_LANES
+	points at a time so the compiler turns each block into SIMD code even
+	at -O2.  Against the haversine in double on the mean Earth radius, the
+	result is within 2 m below 1000 km and 2e-6 of the distance beyond,
+	antipodes included (LDistance() manages 1.5e-5).
+*/
+#define	DISTANCE_LANES	8
+
+struct EMUnitVectors {
+	std::vector<float>	x;
+	std::vector<float>	y;
+	std::vector<float>	z;
+};
+
+void	LUnitVectors(const EMPoint*, int32 count, EMUnitVectors& out);
+
+// From one point to each of `to`, `out` holding to.x.size() values
+void	LDistances(const EMPoint& from, const EMUnitVectors& to, float radius,
+			float* out);
+
+// Every `from` against every `to`, row major: out[f * to.x.size() + t]
+void	LDistances(const EMUnitVectors& from, const EMUnitVectors& to,
+			float radius, float* out);
+
+/*	Branch free selects, for loops meant to vectorize.  Floating point
+	compares can't be made into vector selects while they may trap, so
+	compare the bits instead (as integers, they order non-negative floats
+	the same as the values) and pick with a mask of all ones or zero.
+*/
+inline	int32_t	LFloatBits(float value)
+{
+	int32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+
+inline	float	LBitsFloat(int32_t bits)
+{
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+
+// `one` where mask is all ones, `two` where it is zero
+inline	float	LSelect(int32_t mask, float one, float two)
+{
+	return LBitsFloat((LFloatBits(one) & mask) | (LFloatBits(two) & ~mask));
+}
+
+
 double	LRadians(double degrees);
 double	LDegrees(double radians);
 
@@ -0,0 +1,551 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "OutputWriter.h"
+
+
+#define	FORMAT_EXACT_LIMIT		4503599627370496.0	// 2^52
+#define	FORMAT_SHORTEST_FIXED	15	// exponents from here on go to e+XX
+
+
+static const double kPow10[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+	1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const uint64 kIntPow10[] = {
+	1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL, 100000ULL, 1000000ULL,
+	10000000ULL, 100000000ULL, 1000000000ULL, 10000000000ULL,
+	100000000000ULL, 1000000000000ULL, 10000000000000ULL,
+	100000000000000ULL, 1000000000000000ULL, 10000000000000000ULL,
+	100000000000000000ULL, 1000000000000000000ULL,
+	10000000000000000000ULL
+};
+
+
+static inline void
+_TwoProduct(double a, double b, double& product, double& error)
+{	// a * b == product + error, exactly
+	product = a * b;
+#ifdef FP_FAST_FMA
+	error = fma(a, b, -product);
+#else
+	// Dekker's product, from Veltkamp's split of each side in two halves
+	const double split = 134217729.0;	// 2^27 + 1
+	double	t = split * a,
+			aHigh = t - (t - a),
+			aLow = a - aHigh;
+
+	t = split * b;
+	double	bHigh = t - (t - b),
+			bLow = b - bHigh;
+
+	error = ((aHigh * bHigh - product) + aHigh * bLow + aLow * bHigh)
+		+ aLow * bLow;
+#endif
+}
+
+
+static bool
+_RoundScaled(double value, int32 exponent, uint64& out)
+{	// value * 10^exponent (value >= 0) rounded to nearest, ties to even,
+	// decided on the exact product or quotient rather than a rounded one
+	if (exponent > 22 || exponent < -22)
+		return false;
+
+	double whole, product, error;
+	bool up;
+
+	if (exponent >= 0) {
+		_TwoProduct(value, kPow10[exponent], product, error);
+		if (!(product < FORMAT_EXACT_LIMIT))
+			return false;
+
+		whole = floor(product);
+		double fraction = product - whole;	// exact below 2^52
+
+		up = fraction > 0.5 || (fraction == 0.5
+			&& (error > 0 || (error == 0 && ((uint64)whole & 1) != 0)));
+	} else {
+		double power = kPow10[-exponent];
+		double quotient = value / power;
+		if (!(quotient < FORMAT_EXACT_LIMIT))
+			return false;
+
+		// against the midpoint (whole + 1/2) * 10^-exponent, exactly
+		whole = floor(quotient);
+		_TwoProduct(whole + 0.5, power, product, error);
+		double difference = value - product;
+
+		up = difference > error
+			|| (difference == error && ((uint64)whole & 1) != 0);
+	}
+
+	out = (uint64)whole + (up ? 1 : 0);
+	return true;
+}
+
+
+static bool
+_Significant(double magnitude, int32 precision, uint64& digits,
+	int32& exponent)
+{	// magnitude > 0 as digits * 10^(exponent - precision + 1), with
+	// `digits` holding exactly `precision` digits
+	exponent = floor(log10(magnitude));
+
+	// log10 may be off by one either side of a power of ten, and rounding
+	// may carry into the next one; both come out on a second try
+	for (int32 attempt = 0; attempt < 3; ++attempt) {
+		if (!_RoundScaled(magnitude, precision - 1 - exponent, digits))
+			return false;
+
+		if (digits >= kIntPow10[precision])
+			++exponent;
+		else if (digits < kIntPow10[precision - 1])
+			--exponent;
+		else
+			return true;
+	}
+
+	return false;
+}
+
+
+static inline char*
+_WriteUnsigned(char* out, uint64 value)
+{
+	char digits[20];
+	int32 count = 0;
+
+	do {
+		digits[count++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+
+	while (count > 0)
+		*out++ = digits[--count];
+
+	return out;
+}
+
+
+static inline char*
+_WritePadded(char* out, uint64 value, int32 width)
+{	// exactly `width` digits, leading zeros included
+	for (int32 i = width - 1; i >= 0; --i) {
+		out[i] = '0' + value % 10;
+		value /= 10;
+	}
+
+	return out + width;
+}
+
+
+static inline char*
+_WriteString(char* out, const char* string)
+{
+	while (*string != '\0')
+		*out++ = *string++;
+
+	return out;
+}
+
+
+static char*
+_WriteSpecial(char* out, double value)
+{	// as glibc's printf spells them
+	if (signbit(value))
+		*out++ = '-';
+
+	return _WriteString(out, isnan(value) ? "nan" : "inf");
+}
+
+
+static char*
+_WriteSignificant(char* out, uint64 digits, int32 precision,
+	int32 exponent, int32 fixedBelow)
+{	// %g's layout: trailing zeros dropped, fixed for exponents in
+	// [-4, fixedBelow), otherwise d.ddde+XX
+	while (precision > 1 && digits % 10 == 0) {
+		digits /= 10;
+		--precision;
+	}
+
+	if (exponent < -4 || exponent >= fixedBelow) {
+		uint64 power = kIntPow10[precision - 1];
+
+		*out++ = '0' + digits / power;
+		if (precision > 1) {
+			*out++ = '.';
+			out = _WritePadded(out, digits % power, precision - 1);
+		}
+
+		*out++ = 'e';
+		*out++ = exponent < 0 ? '-' : '+';
+		if (exponent < 0)
+			exponent = -exponent;
+		if (exponent < 10)
+			*out++ = '0';
+
+		return _WriteUnsigned(out, exponent);
+	}
+
+	int32 decimals = precision - 1 - exponent;
+	if (decimals <= 0) {
+		out = _WriteUnsigned(out, digits);
+		for (int32 i = 0; i < -decimals; ++i)
+			*out++ = '0';
+
+		return out;
+	}
+
+	out = _WriteUnsigned(out, digits / kIntPow10[decimals]);
+	*out++ = '.';
+	return _WritePadded(out, digits % kIntPow10[decimals], decimals);
+}
+
+
+char*
+LFormatInt(char* out, int64 value)
+{
+	if (value < 0) {
+		*out++ = '-';
+		return _WriteUnsigned(out, 0 - (uint64)value);
+	}
+
+	return _WriteUnsigned(out, value);
+}
+
+
+char*
+LFormatFixed(char* out, double value, int32 decimals)
+{
+	if (isnan(value) || isinf(value))
+		return _WriteSpecial(out, value);
+
+	double magnitude = fabs(value);
+	if (!(magnitude < 1e18))
+		return LFormatGeneral(out, value, 17);
+
+	decimals = decimals < 0 ? 0 : (decimals > 15 ? 15 : decimals);
+
+	// whole and fraction are both exact, and the fraction scales exactly
+	double	whole = floor(magnitude);
+	uint64	integer = whole,
+			fraction = 0;
+
+	if (decimals == 0) {
+		// a tie goes to the even side of the whole part
+		double half = magnitude - whole;
+		if (half > 0.5 || (half == 0.5 && integer % 2 != 0))
+			++integer;
+	} else
+		_RoundScaled(magnitude - whole, decimals, fraction);
+
+	if (fraction >= kIntPow10[decimals]) {
+		fraction -= kIntPow10[decimals];
+		++integer;
+	}
+
+	if (signbit(value))
+		*out++ = '-';
+
+	out = _WriteUnsigned(out, integer);
+	if (decimals == 0)
+		return out;
+
+	*out++ = '.';
+	return _WritePadded(out, fraction, decimals);
+}
+
+
+char*
+LFormatGeneral(char* out, double value, int32 precision)
+{
+	if (isnan(value) || isinf(value))
+		return _WriteSpecial(out, value);
+
+	if (precision <= 0)
+		precision = 1;
+
+	if (signbit(value))
+		*out++ = '-';
+
+	double magnitude = fabs(value);
+	if (magnitude == 0) {
+		*out++ = '0';
+		return out;
+	}
+
+	uint64 digits;
+	int32 exponent;
+	if (precision > 15 || !_Significant(magnitude, precision, digits,
+			exponent)) {
+		// out of the exact range; the C library's digits, sign already out
+		char text[LFORMAT_MAX + 8];
+		int32 length = snprintf(text, sizeof(text), "%.*g",
+			precision > 17 ? 17 : (int)precision, magnitude);
+		memcpy(out, text, length);
+		return out + length;
+	}
+
+	return _WriteSignificant(out, digits, precision, exponent, precision);
+}
+
+
+char*
+LFormatShortest(char* out, float value)
+{
+	if (isnan(value) || isinf(value))
+		return _WriteSpecial(out, value);
+
+	if (signbit(value))
+		*out++ = '-';
+
+	double magnitude = fabs((double)value);
+	if (magnitude == 0) {
+		*out++ = '0';
+		return out;
+	}
+
+	// The nearest p digit decimal reads back as the float if any p digit
+	// decimal does, and nine digits always do.  Shorter roundings come from
+	// the nine digit one: it sits on the same side of every p digit
+	// midpoint as the exact value, unless it is the midpoint.
+	uint64 nine = 0;
+	int32 exponent = 0;
+	if (_Significant(magnitude, 9, nine, exponent)
+		&& exponent <= 22 - 8 && exponent >= -22) {
+		for (int32 precision = 1; precision <= 9; ++precision) {
+			int32	scale = precision - 1 - exponent,
+					shown = exponent;
+			uint64	power = kIntPow10[9 - precision],
+					digits = nine / power,
+					rest = nine % power;
+
+			if (precision < 9 && rest == power / 2)
+				_RoundScaled(magnitude, scale, digits);
+			else if (rest > power / 2)
+				++digits;
+
+			if (digits == kIntPow10[precision]) {
+				digits = kIntPow10[precision - 1];
+				++shown;
+				--scale;
+			}
+
+			// one correctly rounded operation, then to float, which the
+			// double's 53 bits keep safe from double rounding
+			double decimal = scale >= 0 ? digits / kPow10[scale]
+				: digits * kPow10[-scale];
+
+			if ((float)decimal == (float)magnitude) {
+				return _WriteSignificant(out, digits, precision, shown,
+					FORMAT_SHORTEST_FIXED);
+			}
+		}
+	}
+
+	// far from 1, or subnormal: ask the C library, shortest first
+	char text[LFORMAT_MAX + 8];
+	int32 length = 0;
+	for (int32 precision = 1; precision <= 9; ++precision) {
+		length = snprintf(text, sizeof(text), "%.*g", (int)precision,
+			magnitude);
+		if (strtof(text, nullptr) == (float)magnitude)
+			break;
+	}
+
+	memcpy(out, text, length);
+	return out + length;
+}
+
+
+EMOutputWriter	::	EMOutputWriter(size_t bufferSize)
+	:
+	fFile(nullptr),
+	fOwnsFile(false),
+	fFailed(false),
+	fBuffer(bufferSize > LFORMAT_MAX ? bufferSize : LFORMAT_MAX),
+	fUsed(0),
+	fWritten(0)
+{
+}
+
+
+EMOutputWriter	::	~EMOutputWriter()
+{
+	Close();
+}
+
+
+bool
+EMOutputWriter	::	Open		(const std::string& path)
+{
+	Close();
+
+	fFile = fopen(path.c_str(), "wb");
+	fOwnsFile = true;
+	fFailed = fFile == nullptr;
+	return fFile != nullptr;
+}
+
+
+void
+EMOutputWriter	::	Attach		(FILE* file)
+{
+	Close();
+
+	fFile = file;
+	fOwnsFile = false;
+	fFailed = file == nullptr;
+}
+
+
+bool
+EMOutputWriter	::	IsOpen		() const
+{
+	return fFile != nullptr;
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	Write		(const char* text, size_t length)
+{
+	if (length > fBuffer.size()) {
+		// too big to buffer, so don't
+		_Drain();
+		if (fFile != nullptr && fwrite(text, 1, length, fFile) != length)
+			fFailed = true;
+
+		fWritten += length;
+		return *this;
+	}
+
+	memcpy(_Reserve(length), text, length);
+	fUsed += length;
+	return *this;
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	Write		(const char* text)
+{
+	return Write(text, strlen(text));
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	Write		(const std::string& text)
+{
+	return Write(text.data(), text.size());
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	Write		(char character)
+{
+	*_Reserve(1) = character;
+	fUsed++;
+	return *this;
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	WriteInt	(int64 value)
+{
+	char* start = _Reserve(LFORMAT_MAX);
+	fUsed += LFormatInt(start, value) - start;
+	return *this;
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	WriteFixed	(double value, int32 decimals)
+{
+	char* start = _Reserve(LFORMAT_MAX);
+	fUsed += LFormatFixed(start, value, decimals) - start;
+	return *this;
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	WriteGeneral(double value, int32 precision)
+{
+	char* start = _Reserve(LFORMAT_MAX);
+	fUsed += LFormatGeneral(start, value, precision) - start;
+	return *this;
+}
+
+
+EMOutputWriter&
+EMOutputWriter	::	WriteShortest(float value)
+{
+	char* start = _Reserve(LFORMAT_MAX);
+	fUsed += LFormatShortest(start, value) - start;
+	return *this;
+}
+
+
+bool
+EMOutputWriter	::	Flush		()
+{
+	_Drain();
+
+	if (fFile != nullptr && fflush(fFile) != 0)
+		fFailed = true;
+
+	return !fFailed;
+}
+
+
+bool
+EMOutputWriter	::	Close		()
+{
+	if (fFile == nullptr)
+		return !fFailed;
+
+	Flush();
+
+	if (fOwnsFile && fclose(fFile) != 0)
+		fFailed = true;
+
+	fFile = nullptr;
+	fOwnsFile = false;
+	return !fFailed;
+}
+
+
+int64
+EMOutputWriter	::	BytesWritten() const
+{
+	return fWritten + fUsed;
+}
+
+
+//#pragma mark private
+
+
+char*
+EMOutputWriter	::	_Reserve	(size_t length)
+{
+	if (fUsed + length > fBuffer.size())
+		_Drain();
+
+	return fBuffer.data() + fUsed;
+}
+
+
+void
+EMOutputWriter	::	_Drain		()
+{	// the buffer to the file, leaving the stream's own flushing alone
+	if (fUsed == 0)
+		return;
+
+	if (fFile == nullptr || fwrite(fBuffer.data(), 1, fUsed, fFile) != fUsed)
+		fFailed = true;
+
+	fWritten += fUsed;
+	fUsed = 0;
+}
@@ -0,0 +1,104 @@
+#ifndef EM_OUTPUT_WRITER_H
+#define EM_OUTPUT_WRITER_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "StdTypedefs.h"
+
+/*
+	Buffered text output, and the number formatting to go with it.
+
+	The formatters write straight into a character buffer and return the
+	position after the last character, so they can be used on their own
+	(as the parallel exports do) or through EMOutputWriter:
+
+		LFormatFixed	like printf's %.*f
+		LFormatGeneral	like printf's %.*g, which is also what an ostream
+						writes at its default settings
+		LFormatShortest	the fewest significant digits that read back as
+						the same float
+
+	Normally none of them goes through the C library or a locale.  A value
+	is scaled to an integer with an exact product (or quotient) and
+	rounded to nearest, ties to even, on the exact binary value - the same
+	digits glibc's printf produces, and the same on every IEEE 754
+	platform.
+	Outside the range that can be done exactly - never a temperature -
+	they hand the magnitude to the C library's %g instead:
+
+		LFormatFixed	at 1e18 and beyond, as %.17g
+		LFormatGeneral	for a precision above 15 (capped at 17), or where
+						scaling to the digits takes a power of ten
+						beyond 10^22 either way
+		LFormatShortest	outside 1e-14 to 1e15, as the shortest %g
+						that reads back
+
+	No formatter writes more than LFORMAT_MAX characters.
+
+	EMOutputWriter collects text in a large buffer and hands it to the file
+	a buffer at a time:
+
+		EMOutputWriter out;
+		if (out.Open("data/output.csv")) {
+			out.Write("YEAR,AVERAGE\n");
+			out.WriteInt(year).Write(',').WriteFixed(average, 4).Write('\n');
+			out.Close();	// false if anything failed to write
+		}
+*/
+
+#define	LFORMAT_MAX				40
+#define	OUTPUT_BUFFER_SIZE		(1 << 20)
+
+
+char*	LFormatInt				(char* out, int64 value);
+char*	LFormatFixed			(char* out, double value, int32 decimals);
+char*	LFormatGeneral			(char* out, double value,
+									int32 precision = 6);
+char*	LFormatShortest			(char* out, float value);
+
+
+class	EMOutputWriter {
+public:
+								EMOutputWriter(
+									size_t bufferSize = OUTPUT_BUFFER_SIZE);
+	virtual						~EMOutputWriter();
+
+			bool				Open		(const std::string& path);
+			// writes to a stream that stays open afterwards, e.g. stdout
+			void				Attach		(FILE*);
+			bool				IsOpen		() const;
+
+			EMOutputWriter&		Write		(const char*, size_t length);
+			EMOutputWriter&		Write		(const char*);
+			EMOutputWriter&		Write		(const std::string&);
+			EMOutputWriter&		Write		(char);
+
+			EMOutputWriter&		WriteInt	(int64);
+			EMOutputWriter&		WriteFixed	(double, int32 decimals);
+			EMOutputWriter&		WriteGeneral(double, int32 precision = 6);
+			EMOutputWriter&		WriteShortest(float);
+
+			bool				Flush		();
+			// Flushes, and closes the file if Open() opened it.  False if
+			// any write failed along the way.
+			bool				Close		();
+
+			int64				BytesWritten() const;
+
+private:
+			char*				_Reserve	(size_t length);
+			void				_Drain		();
+
+		FILE*					fFile;
+		bool					fOwnsFile;
+		bool					fFailed;
+
+		std::vector<char>		fBuffer;
+		size_t					fUsed;
+		int64					fWritten;
+};
+
+
+#endif // EM_OUTPUT_WRITER_H
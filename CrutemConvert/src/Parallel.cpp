@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "Parallel.h"
+#include "Stats.h"
+
+
+static int32 sThreadCount = 0;
+
+
+int32	LThreadCount()
+{
+	if (sThreadCount > 0)
+		return sThreadCount;
+
+	int32 hardware = std::thread::hardware_concurrency();
+	return hardware > 0 ? hardware : 1;
+}
+
+
+void	LSetThreadCount(int32 count)
+{
+	sThreadCount = count > 0 ? count : 0;
+}
+
+
+void	LParallelFor(int32 count, const LParallelFunc& func, int32 grain)
+{
+	if (count <= 0)
+		return;
+
+	if (grain < 1)
+		grain = 1;
+
+	int32 chunks = (count + grain - 1) / grain,
+		threads = std::min(LThreadCount(), chunks);
+
+	bool timed = LStatsEnabled();
+	auto start = timed ? std::chrono::steady_clock::now()
+		: std::chrono::steady_clock::time_point();
+
+	if (threads <= 1) {
+		func(0, count, 0);
+		if (timed) {
+			LStatsAddThreadTime(0, std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - start).count());
+		}
+		return;
+	}
+
+	std::atomic<int32> next(0);
+
+	auto worker = [&](int32 thread) {
+		auto begun = timed ? std::chrono::steady_clock::now() : start;
+
+		while (true) {
+			int32 begin = next.fetch_add(grain);
+			if (begin >= count)
+				break;
+			func(begin, std::min(count, begin + grain), thread);
+		}
+
+		if (timed) {
+			LStatsAddThreadTime(thread, std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - begun).count());
+		}
+	};
+
+	std::vector<std::thread> pool;
+	pool.reserve(threads - 1);
+
+	for (int32 t = 1; t < threads; ++t)
+		pool.push_back(std::thread(worker, t));
+
+	worker(0);
+
+	for (auto& thread : pool)
+		thread.join();
+}
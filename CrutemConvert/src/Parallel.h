@@ -0,0 +1,37 @@
+#ifndef L_PARALLEL_H
+#define L_PARALLEL_H
+
+#include <functional>
+
+#include "StdTypedefs.h"
+
+/*
+	Minimal C++11 work splitting, shared by every pass that runs per station
+	or per cell.
+
+	LParallelFor(count, func) hands out [begin, end) chunks of `grain` items
+	to LThreadCount() threads until the range is used up.  The calling thread
+	works as well, so a thread count of one runs everything in place.
+
+		LParallelFor(StationList.size(),
+			[&](int32 begin, int32 end, int32 thread) {
+				for (int32 i = begin; i < end; ++i)
+					work(i, scratch[thread]);
+			});
+
+	Chunks are handed out dynamically, so work must not depend on which
+	thread gets which chunk.  `thread` is only meant for indexing per-thread
+	scratch space, which must hold LThreadCount() entries.
+*/
+
+typedef std::function<void(int32 begin, int32 end, int32 thread)>
+	LParallelFunc;
+
+
+int32	LThreadCount();
+void	LSetThreadCount(int32 count);	// 0 restores the hardware count
+
+void	LParallelFor(int32 count, const LParallelFunc&, int32 grain = 16);
+
+
+#endif // L_PARALLEL_H
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cctype>
 #include <iostream>
 #include <iomanip>
 #include <sstream>
@@ -6,6 +7,8 @@
 
 #include "StdTypedefs.h"
 #include "ParseArgs.h"
+#include "QueryServer.h"
+#include "SharedDataset.h"
 
 using namespace std;
 
@@ -16,15 +19,53 @@ vector<pair<LString, LString>>  ParameterHelp = {
     make_pair("data", "Set location of station list data file."),
     make_pair("ignore", "Set location of list of stations to ignore."),
     make_pair("output", "Set output location:\n"
-                        "\t\t\t\tport:id  - local application port (Haiku only)\n"
+                        "\t\t\t\tport:id  - local application port (a Unix\n"
+                        "\t\t\t\t           socket, /tmp/crucon-id.sock)\n"
                         "\t\t\t\tfile.csv - Comma Separated Values\n"
-                        "\t\t\t\tfile.emsl- EarthModel StationList format"),
-    make_pair("gridsize", "Set size of grids for use with area weighting."),
+                        "\t\t\t\tfile.emsl- EarthModel StationList format\n"
+                        "\t\t\t\tfile.f32 - gridded float32 cube (+ .json)"),
+    make_pair("cube", "Set what the gridded cube holds:\n"
+                        "\t\t\t\tabsolute (default) or anomaly (1961-1990)"),
+    make_pair("map", "Render the gridded stations as global maps:\n"
+                        "\t\t\t\tPPM frames into a directory (default) or a\n"
+                        "\t\t\t\tY4M video, monthly or yearly, any size,\n"
+                        "\t\t\t\tof anomalies (default) or absolute values:\n"
+                        "\t\t\t\t-map=data/map.y4m,yearly,1440x720,absolute"),
+    make_pair("units", "Set the temperature scale written out:\n"
+                        "\t\t\t\tC (default), F or K"),
+    make_pair("gridsize", "Set size of grids for use with area weighting.\n"
+                          "\t\t\t\tCoarser levels (10, 30, zonal bands,\n"
+                          "\t\t\t\themispheres, global) are built from it"),
     make_pair("interpolate", "Use data interpolation to estimate daily values\n"
-                            "\t\t\t\tTakes a parameter of days (default is 1)"),
+                            "\t\t\t\tTakes a parameter of days (default is 1)\n"
+                            "\t\t\t\tand optionally a mode: -interpolate=1,cubic"),
+    make_pair("daily", "Set location of the interpolated daily CSV file."),
     make_pair("infill", "Attempt to infill missing station data\n"
-                        "\t\t\t\tTakes a parameter for maximum infill span"),
-    make_pair("station", "Set search string to find a specific station"),
+                        "\t\t\t\tTakes a parameter for maximum infill span\n"
+                        "\t\t\t\tin months (default is 1)"),
+    make_pair("homogenize", "Detect and remove station breakpoints (SNHT)\n"
+                        "\t\t\t\tagainst correlated neighbours"),
+    make_pair("bootstrap", "Estimate confidence bands by resampling\n"
+                        "\t\t\t\tTakes a replicate count (default is 1000)\n"
+                        "\t\t\t\tand optionally what to resample:\n"
+                        "\t\t\t\t-bootstrap=1000,cells (default stations)"),
+    make_pair("bands", "Set location of the bootstrap bands CSV file."),
+    make_pair("export", "Write every station's monthly series as CSV,\n"
+                        "\t\t\t\tor only those matching -station and -cellrect\n"
+                        "\t\t\t\tOne long file, or a file per station:\n"
+                        "\t\t\t\t-export=data/stations,files"),
+    make_pair("publish", "Publish the stations in POSIX shared memory\n"
+                        "\t\t\t\tfor other processes to map (default /crucon)"),
+    make_pair("serve", "Stay resident, answering queries on a Unix\n"
+                        "\t\t\t\tsocket, /tmp/crucon-daemon.sock by default:\n"
+                        "\t\t\t\t-serve=name (send it \"help\" for commands)"),
+    make_pair("station", "Find stations by ID, or by the start of words in\n"
+                        "\t\t\t\ttheir name or country: -station=\"jan may\"\n"
+                        "\t\t\t\tor many at once, one per line: -station=@list"),
+    make_pair("fuzzy", "Let -station fall back to fuzzy (trigram) matching"),
+    make_pair("stats", "Print where the run's time went, phase by phase,\n"
+                        "\t\t\t\twith counters, and write it as JSON\n"
+                        "\t\t\t\t(default data/stats.json): --stats=file"),
     make_pair("cellrect", "Limit analysis to specific cooridnate area.\n"
                             "\t\t\t\t-cellrect=\"west, north, east, south\"")
 };
@@ -37,21 +78,54 @@ PAOutput	::	PAOutput()
 	dataFile	(DEFAULT_DATAFILE),
 	outputFile	(DEFAULT_OUTPUTFILE),
 	ignoreFile	(DEFAULT_IGNOREFILE),
+	dailyFile	(DEFAULT_DAILYFILE),
+	bandsFile	(DEFAULT_BANDSFILE),
 
+	autoValues      (false),
 	expectIgnored   (false),
 
 	outputTarget    (OUTPUT_TO_CONSOLE),
+	outputScale     (Celsius),
 
 	useGrid		(false),
 	gridSize	(5.0),
 
 	interpolate	(false),
-	interpolateDayCount(3),
+	interpolateDayCount(1),
+	interpolateCubic(false),
 
 	infill		(false),
 	maxInfillSpan(1),
 
+	homogenize	(false),
+
+	cubeAnomaly	(false),
+
+	map			(false),
+	mapVideo	(false),
+	mapYearly	(false),
+	mapAnomaly	(true),
+	mapWidth	(720),
+	mapHeight	(360),
+
+	bootstrap	(false),
+	bootstrapCount(1000),
+	bootstrapCells(false),
+
+	exportStations(false),
+	exportPerStation(false),
+
+	publish		(false),
+	publishName	(SHARED_DEFAULT_NAME),
+
+	serve		(false),
+	serveName	(QUERY_SOCKET_DEFAULT),
+
 	findStation	(false),
+	findStationFuzzy(false),
+
+	stats		(false),
+	statsFile	(DEFAULT_STATSFILE),
 
 	singleCell	(false),
         returnValue     (0)
@@ -85,12 +159,12 @@ pair<LString, LString>	SplitParam(const LString& string) {
 
 	if (argSep != std::string::npos) {
             value = string;
-            value.erase(0, argSep);
+            value.erase(0, argSep + 1);
             value.erase(remove(value.begin(), value.end(), '"'), value.end());
 
             param.resize(argSep);
         }
-		param.erase(0,1);
+		param.erase(0, param.compare(0, 2, "--") == 0 ? 2 : 1);	// -name or --name
         // make param lowercase
         transform(param.begin(), param.end(), param.begin(), ::tolower);
 	return make_pair(param, value);
@@ -130,25 +204,137 @@ PAOutput*	ParseArgs(int argc, char** argv)
             pa->ignoreFile = entry.second;
             pa->expectIgnored = true;
         } else if (entry.first == "output") {
-            pa->outputFile == entry.second;
-            if (entry.second.find(".csv"))
+            pa->outputFile = entry.second;
+            if (entry.second.find("port:") == 0)
+                pa->outputTarget = OUTPUT_TO_PORT;
+            else if (entry.second.find(".csv") != string::npos)
                 pa->outputTarget = OUTPUT_TO_CSV;
-            else if (entry.second.find(".emsl"))
+            else if (entry.second.find(".emsl") != string::npos)
                 pa->outputTarget = OUTPUT_TO_EMSL;
-            else if (entry.second.find("port:"))
-                pa->outputTarget = OUTPUT_TO_PORT;
+            else if (entry.second.find(".f32") != string::npos)
+                pa->outputTarget = OUTPUT_TO_CUBE;
+        } else if (entry.first == "cube") {
+            LString tmp = entry.second;
+            transform(tmp.begin(), tmp.end(), tmp.begin(), ::tolower);
+            if (tmp == "anomaly" || tmp == "anomalies")
+                pa->cubeAnomaly = true;
+            else if (tmp == "absolute")
+                pa->cubeAnomaly = false;
+            else
+                cerr << "Unknown cube values: " << entry.second << endl;
+        } else if (entry.first == "units") {
+            if (!LParseScale(entry.second.c_str(), pa->outputScale))
+                cerr << "Unknown temperature scale: " << entry.second << endl;
         } else if (entry.first == "gridsize") {
             pa->useGrid = true;
             pa->gridSize = atof(entry.second.c_str());
         } else if (entry.first == "interpolate") {
             pa->interpolate = true;
-            pa->interpolateDayCount = atof(entry.second.c_str());
+
+            istringstream ss(entry.second);
+            LString tmp;
+            while (getline(ss, tmp, ',')) {
+                transform(tmp.begin(), tmp.end(), tmp.begin(), ::tolower);
+                if (tmp == "cubic")
+                    pa->interpolateCubic = true;
+                else if (tmp == "linear")
+                    pa->interpolateCubic = false;
+                else if (tmp != "")
+                    pa->interpolateDayCount = atof(tmp.c_str());
+            }
+        } else if (entry.first == "daily") {
+            pa->dailyFile = entry.second;
+        } else if (entry.first == "map") {
+            pa->map = true;
+
+            istringstream ss(entry.second);
+            LString tmp;
+            while (getline(ss, tmp, ',')) {
+                LString lower = tmp;
+                transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                size_t by = lower.find('x');
+                if (lower == "ppm")
+                    pa->mapVideo = false;
+                else if (lower == "y4m")
+                    pa->mapVideo = true;
+                else if (lower == "yearly")
+                    pa->mapYearly = true;
+                else if (lower == "monthly")
+                    pa->mapYearly = false;
+                else if (lower == "anomaly" || lower == "anomalies")
+                    pa->mapAnomaly = true;
+                else if (lower == "absolute")
+                    pa->mapAnomaly = false;
+                else if (by != string::npos && isdigit(lower[0])) {
+                    pa->mapWidth = atoi(lower.c_str());
+                    pa->mapHeight = atoi(lower.c_str() + by + 1);
+                } else if (tmp != "") {
+                    pa->mapPath = tmp;
+                    if (lower.find(".y4m") != string::npos)
+                        pa->mapVideo = true;
+                }
+            }
+
+            if (pa->mapPath == "")
+                pa->mapPath = pa->mapVideo ? DEFAULT_MAPVIDEO : DEFAULT_MAPDIR;
         } else if (entry.first == "infill"){
             pa->infill = true;
-            pa->maxInfillSpan = atof(entry.second.c_str());
+            if (entry.second != "")
+                pa->maxInfillSpan = atof(entry.second.c_str());
+        } else if (entry.first == "homogenize") {
+            pa->homogenize = true;
+        } else if (entry.first == "bootstrap") {
+            pa->bootstrap = true;
+
+            istringstream ss(entry.second);
+            LString tmp;
+            while (getline(ss, tmp, ',')) {
+                transform(tmp.begin(), tmp.end(), tmp.begin(), ::tolower);
+                if (tmp == "cells")
+                    pa->bootstrapCells = true;
+                else if (tmp == "stations")
+                    pa->bootstrapCells = false;
+                else if (tmp != "")
+                    pa->bootstrapCount = atof(tmp.c_str());
+            }
+        } else if (entry.first == "bands") {
+            pa->bandsFile = entry.second;
+        } else if (entry.first == "export") {
+            pa->exportStations = true;
+
+            istringstream ss(entry.second);
+            LString tmp;
+            while (getline(ss, tmp, ',')) {
+                LString lower = tmp;
+                transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+                if (lower == "files")
+                    pa->exportPerStation = true;
+                else if (lower == "single")
+                    pa->exportPerStation = false;
+                else if (tmp != "")
+                    pa->exportPath = tmp;
+            }
+
+            if (pa->exportPath == "")
+                pa->exportPath = pa->exportPerStation ? DEFAULT_EXPORTDIR
+                    : DEFAULT_EXPORTFILE;
+        } else if (entry.first == "publish") {
+            pa->publish = true;
+            if (entry.second != "")
+                pa->publishName = entry.second;
+        } else if (entry.first == "serve") {
+            pa->serve = true;
+            if (entry.second != "")
+                pa->serveName = entry.second;
         } else if (entry.first == "station") {
             pa->findStation = true;
             pa->findStationString = entry.second;
+        } else if (entry.first == "fuzzy") {
+            pa->findStationFuzzy = true;
+        } else if (entry.first == "stats") {
+            pa->stats = true;
+            if (entry.second != "")
+                pa->statsFile = entry.second;
         } else if (entry.first == "cellrect"){
             pa->singleCell = true;
             
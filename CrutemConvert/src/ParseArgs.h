@@ -14,6 +14,7 @@
 #define	CRUCON_VER_S	"0.5"
 
 #include "EarthCoordSystem.h"
+#include "Temperature.h"
 #include <string>
 using namespace std;
 
@@ -21,13 +22,21 @@ using namespace std;
 #	define	DEFAULT_DATAFILE	"data/data.txt"
 #	define	DEFAULT_OUTPUTFILE	"data/output.txt"
 #	define	DEFAULT_IGNOREFILE	"data/missing.txt"
+#	define	DEFAULT_DAILYFILE	"data/daily.csv"
+#	define	DEFAULT_BANDSFILE	"data/bands.csv"
+#	define	DEFAULT_EXPORTFILE	"data/stations.csv"
+#	define	DEFAULT_EXPORTDIR	"data/stations"
+#	define	DEFAULT_MAPDIR		"data/map"
+#	define	DEFAULT_MAPVIDEO	"data/map.y4m"
+#	define	DEFAULT_STATSFILE	"data/stats.json"
 
 
 enum OutputTo {
 	OUTPUT_TO_CSV = 0,
 	OUTPUT_TO_EMSL,
 	OUTPUT_TO_CONSOLE,
-	OUTPUT_TO_PORT
+	OUTPUT_TO_PORT,
+	OUTPUT_TO_CUBE
 };
 
 
@@ -35,24 +44,58 @@ struct PAOutput {
 	string		headerFile,
 			dataFile,
 			outputFile,
-			ignoreFile;
+			ignoreFile,
+			dailyFile,
+			bandsFile;
 
 	bool            autoValues;
         bool		expectIgnored;
 
 	OutputTo	outputTarget;
+	TScale		outputScale;
 
 	bool		useGrid;
 	float		gridSize;
 
 	bool		interpolate;
 	float		interpolateDayCount;
+	bool		interpolateCubic;
 
 	bool		infill;
 	float		maxInfillSpan;
 
+	bool		homogenize;
+
+	bool		cubeAnomaly;	// else absolute
+
+	bool		map;
+	string		mapPath;
+	bool		mapVideo;		// else PPM frames
+	bool		mapYearly;
+	bool		mapAnomaly;		// else absolute, whatever -cube says
+	int32		mapWidth;
+	int32		mapHeight;
+
+	bool		bootstrap;
+	float		bootstrapCount;
+	bool		bootstrapCells;
+
+	bool		exportStations;
+	string		exportPath;
+	bool		exportPerStation;	// one file each, into exportPath
+
+	bool		publish;
+	string		publishName;
+
+	bool		serve;
+	string		serveName;
+
 	bool		findStation;
-	string		findStationString;
+	string		findStationString;	// or @file, a query per line
+	bool		findStationFuzzy;
+
+	bool		stats;		// -stats or --stats
+	string		statsFile;
 
 	bool		singleCell;	// amoeba
 	EMCoordRect	cellRect;
@@ -71,10 +114,22 @@ PAOutput*	ParseArgs	(int, char**);
  *      data
  *      ignore
  *      output
+ *      cube
+ *      map
+ *      units
  *      gridsize
  *      interpolate
+ *      daily
  *      infill
+ *      homogenize
+ *      bootstrap
+ *      bands
+ *      export
+ *      publish
+ *      serve
  *      station
+ *      fuzzy
+ *      stats
  *      cellrect
  *      help
  */
@@ -0,0 +1,219 @@
+#include <algorithm>
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "PortStream.h"
+
+
+#ifndef MSG_NOSIGNAL
+#	define MSG_NOSIGNAL	0
+#	define PORT_IGNORE_SIGPIPE
+#endif
+
+
+EMPortStream	::	EMPortStream(size_t bufferSize)
+	:
+	fSocket(-1),
+	fFailed(false),
+	fLimit(bufferSize > 64 ? bufferSize : 64)
+{
+	fBuffer.reserve(fLimit);
+}
+
+
+EMPortStream	::	~EMPortStream()
+{
+	Close();
+}
+
+
+std::string
+EMPortStream	::	SocketPath	(const std::string& name)
+{
+	if (name.find('/') != std::string::npos)
+		return name;
+
+	return PORT_SOCKET_PREFIX + name + PORT_SOCKET_SUFFIX;
+}
+
+
+bool
+EMPortStream	::	Connect		(const std::string& name)
+{
+	Close();
+
+	std::string path = SocketPath(name);
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	if (path.size() >= sizeof(address.sun_path))
+		return false;
+
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, path.c_str(), path.size());
+
+	fSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fSocket < 0)
+		return false;
+
+	if (connect(fSocket, (struct sockaddr*)&address, sizeof(address)) != 0) {
+		close(fSocket);
+		fSocket = -1;
+		return false;
+	}
+
+#ifdef PORT_IGNORE_SIGPIPE
+	signal(SIGPIPE, SIG_IGN);
+#endif
+
+	fFailed = false;
+	fBuffer.clear();
+
+	_Frame(PORT_FRAME_HELLO, 0, 4);
+	_Put(PORT_PROTOCOL_VERSION);
+	return Flush();
+}
+
+
+bool
+EMPortStream	::	IsConnected	() const
+{
+	return fSocket >= 0 && !fFailed;
+}
+
+
+bool
+EMPortStream	::	DefineSeries(uint32_t series, const std::string& name)
+{
+	if (!IsConnected())
+		return false;
+
+	_Frame(PORT_FRAME_SERIES, series, name.size());
+	_Put(name.data(), name.size());
+	return IsConnected();
+}
+
+
+bool
+EMPortStream	::	WriteChunk	(uint32_t series, int32 key, int32 firstYear,
+									const float* values, int32 count)
+{
+	if (!IsConnected() || count < 0)
+		return false;
+
+	_Frame(PORT_FRAME_CHUNK, series, 12 + count * sizeof(float));
+	_Put((uint32_t)key);
+	_Put((uint32_t)firstYear);
+	_Put((uint32_t)count);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	for (int32 i = 0; i < count; ++i) {
+		uint32_t bits;
+		memcpy(&bits, values + i, sizeof(bits));
+		_Put(bits);
+	}
+#else
+	_Put(values, count * sizeof(float));
+#endif
+
+	return IsConnected();
+}
+
+
+bool
+EMPortStream	::	Flush		()
+{
+	if (fSocket < 0)
+		return false;
+
+	if (!fFailed && !fBuffer.empty())
+		fFailed = !_Send(fBuffer.data(), fBuffer.size());
+
+	fBuffer.clear();
+	return !fFailed;
+}
+
+
+bool
+EMPortStream	::	Close		()
+{
+	if (fSocket < 0)
+		return false;
+
+	_Frame(PORT_FRAME_END, 0, 0);
+	bool ok = Flush();
+
+	close(fSocket);
+	fSocket = -1;
+	return ok;
+}
+
+
+//#pragma mark private
+
+
+void
+EMPortStream	::	_Frame		(uint32_t type, uint32_t series,
+									uint32_t length)
+{
+	// a frame which won't fit goes out in pieces, after what's buffered
+	if (fBuffer.size() + 12 + length > fLimit)
+		Flush();
+
+	_Put(type);
+	_Put(series);
+	_Put(length);
+}
+
+
+void
+EMPortStream	::	_Put		(uint32_t value)
+{
+	unsigned char bytes[4] = {
+		(unsigned char)value,
+		(unsigned char)(value >> 8),
+		(unsigned char)(value >> 16),
+		(unsigned char)(value >> 24)
+	};
+	_Put(bytes, 4);
+}
+
+
+void
+EMPortStream	::	_Put		(const void* data, size_t length)
+{
+	const char* bytes = (const char*)data;
+
+	while (length > 0 && !fFailed) {
+		if (fBuffer.size() == fLimit)
+			Flush();
+
+		size_t count = std::min(length, fLimit - fBuffer.size());
+		fBuffer.insert(fBuffer.end(), bytes, bytes + count);
+		bytes += count;
+		length -= count;
+	}
+}
+
+
+bool
+EMPortStream	::	_Send		(const char* data, size_t length)
+{
+	while (length > 0) {
+		ssize_t sent = send(fSocket, data, length, MSG_NOSIGNAL);
+		if (sent < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+
+		data += sent;
+		length -= sent;
+	}
+
+	return true;
+}
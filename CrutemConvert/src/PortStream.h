@@ -0,0 +1,92 @@
+#ifndef EM_PORT_STREAM_H
+#define EM_PORT_STREAM_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "StdTypedefs.h"
+
+/*
+	Streams results to a local consumer over a Unix domain socket, as they
+	are computed - the socket stand-in for a Haiku application port.
+
+	The consumer listens; crucon connects.  "-output=port:name" connects to
+	/tmp/crucon-name.sock, or to name itself when it holds a '/'.
+
+	Everything is a frame: a 12 byte header, then the payload.  All fields
+	are little-endian whatever the host.
+
+		uint32	type
+		uint32	series		0 for HELLO and END
+		uint32	length		payload bytes
+
+		PORT_FRAME_HELLO	uint32 protocol version (PORT_PROTOCOL_VERSION)
+		PORT_FRAME_SERIES	the series' name, UTF-8, not terminated.  Comes
+							before the series' first chunk.
+		PORT_FRAME_CHUNK	int32 key, int32 first year, uint32 count, then
+							count float32 values, one per year from the
+							first.  NaN where there is no value.
+		PORT_FRAME_END		the run is complete; nothing follows
+
+	A series may arrive in any number of chunks, interleaved with other
+	series' chunks.  The key tells apart chunks covering the same years,
+	e.g. the station ID in a per-station series; it is 0 otherwise.
+
+	Frames are gathered in a small buffer, so a consumer sees them within
+	a few kilobytes of being produced, and Flush() sends what there is.
+	A consumer going away is reported by the next call, not a SIGPIPE.
+*/
+
+#define	PORT_PROTOCOL_VERSION	1
+#define	PORT_SOCKET_PREFIX		"/tmp/crucon-"
+#define	PORT_SOCKET_SUFFIX		".sock"
+#define	PORT_BUFFER_SIZE		(16 * 1024)
+
+enum EMPortFrame {
+	PORT_FRAME_HELLO	= 1,
+	PORT_FRAME_SERIES	= 2,
+	PORT_FRAME_CHUNK	= 3,
+	PORT_FRAME_END		= 4
+};
+
+
+class	EMPortStream {
+public:
+								EMPortStream(
+									size_t bufferSize = PORT_BUFFER_SIZE);
+	virtual						~EMPortStream();
+
+	static	std::string			SocketPath	(const std::string& name);
+
+			// Connects and sends HELLO.
+			bool				Connect		(const std::string& name);
+			bool				IsConnected	() const;
+
+			bool				DefineSeries(uint32_t series,
+											const std::string& name);
+			bool				WriteChunk	(uint32_t series, int32 key,
+											int32 firstYear,
+											const float* values,
+											int32 count);
+
+			bool				Flush		();
+			// Sends END and disconnects.  False if anything failed to send.
+			bool				Close		();
+
+private:
+			void				_Frame		(uint32_t type, uint32_t series,
+											uint32_t length);
+			void				_Put		(uint32_t);
+			void				_Put		(const void*, size_t length);
+			bool				_Send		(const char*, size_t length);
+
+		int						fSocket;
+		bool					fFailed;
+
+		std::vector<char>		fBuffer;
+		size_t					fLimit;
+};
+
+
+#endif // EM_PORT_STREAM_H
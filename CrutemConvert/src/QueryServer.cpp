@@ -0,0 +1,565 @@
+#include <algorithm>
+#include <errno.h>
+#include <signal.h>
+#include <sstream>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+#include "OutputWriter.h"
+#include "Parallel.h"
+#include "PortStream.h"
+
+#include "QueryServer.h"
+
+
+#ifndef MSG_NOSIGNAL
+#	define MSG_NOSIGNAL	0
+#endif
+
+
+static const char* kHelp =
+	"{\"ok\":true,\"commands\":[\"global [from [to]]\","
+	"\"cell <lat> <lon> [from [to]]\",\"station <search>\","
+	"\"average station <id> <from> <to>\","
+	"\"average cell <lat> <lon> <from> <to>\",\"help\",\"quit\","
+	"\"shutdown\"]}";
+
+
+static std::string
+_Error(const char* message)
+{
+	return std::string("{\"ok\":false,\"error\":\"") + message + "\"}";
+}
+
+
+static void
+_Number(std::string& out, double value)
+{	// shortest float; JSON has no NaN or infinity
+	char buffer[LFORMAT_MAX];
+	if (value != value || value - value != 0)
+		out += "null";
+	else
+		out.append(buffer, LFormatShortest(buffer, value) - buffer);
+}
+
+
+static void
+_Temperature(std::string& out, double value)
+{	// null only for the missing marker: Fahrenheit goes below -99 for real
+	if ((float)value == (float)SERIES_MISSING)
+		out += "null";
+	else
+		_Number(out, value);
+}
+
+
+static void
+_Int(std::string& out, int64 value)
+{
+	char buffer[LFORMAT_MAX];
+	out.append(buffer, LFormatInt(buffer, value) - buffer);
+}
+
+
+static void
+_String(std::string& out, const char* text)
+{
+	out += '"';
+	for (; *text != 0; ++text) {
+		unsigned char c = *text;
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += c;
+		} else if (c < 0x20) {
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			out += escape;
+		} else
+			out += c;
+	}
+	out += '"';
+}
+
+
+static bool
+_ParseMonth(const std::string& text, bool end, EMMonthIndex& month)
+{	// YYYY or YYYY-MM; an end is taken to include the year or month given
+	char* rest = nullptr;
+	long year = strtol(text.c_str(), &rest, 10);
+	if (rest == text.c_str())
+		return false;
+
+	long number = 1;
+	bool whole = *rest == 0;
+	if (!whole) {
+		if (*rest != '-')
+			return false;
+
+		const char* start = rest + 1;
+		number = strtol(start, &rest, 10);
+		if (rest == start || *rest != 0 || number < 1 || number > 12)
+			return false;
+	}
+
+	month = EMMonthIndex(year, number);
+	if (end)
+		month += whole ? 12 : 1;
+	return true;
+}
+
+
+static bool
+_ParseFloat(const std::string& text, float& value)
+{
+	char* rest = nullptr;
+	value = strtof(text.c_str(), &rest);
+	return rest != text.c_str() && *rest == 0;
+}
+
+
+static double
+_InScale(const EMTemperature& temperature, TScale scale)
+{
+	switch (scale) {
+		case TScale::Kelvin:
+			return temperature.toKelvin();
+		case TScale::Fahrenheit:
+			return temperature.toFahrenheit();
+		default:
+			return temperature.toCelsius();
+	}
+}
+
+
+EMQueryServer	::	EMQueryServer(const std::vector<Station*>& stations,
+						const EMGridPyramid& pyramid, TScale scale)
+	:
+	fStations(stations),
+	fPyramid(pyramid),
+	fScale(scale),
+	fListener(-1),
+	fRunning(false),
+	fRequests(0)
+{
+	for (Station* station : fStations)
+		fByID[station->ID] = station;
+	fSearch.Build(fStations);
+
+	// every range sum built now, so the workers only ever read
+	LParallelFor(fStations.size(), [&](int32 begin, int32 end, int32) {
+		for (int32 i = begin; i < end; ++i)
+			fStations[i]->PrepareRanges();
+	});
+
+	if (fPyramid.LevelCount() > 0) {
+		LParallelFor(fPyramid.CellCount(0), [&](int32 begin, int32 end,
+			int32) {
+			for (int32 cell = begin; cell < end; ++cell) {
+				if (fPyramid.FineCell(cell) != nullptr)
+					fPyramid.FineCell(cell)->PrepareSeries();
+			}
+		}, 64);
+	}
+}
+
+
+EMQueryServer	::	~EMQueryServer()
+{
+}
+
+
+void
+EMQueryServer	::	SetGlobalSeries(const std::vector<uint32>& years,
+						const std::vector<double>& means,
+						const std::vector<uint32>& counts)
+{
+	fYears = years;
+	fMeans = means;
+	fCounts = counts;
+}
+
+
+bool
+EMQueryServer	::	Run		(const std::string& name, int32 workers)
+{
+	std::string path = EMPortStream::SocketPath(name);
+
+	struct sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	if (path.size() >= sizeof(address.sun_path))
+		return false;
+
+	address.sun_family = AF_UNIX;
+	memcpy(address.sun_path, path.c_str(), path.size());
+
+	fListener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fListener < 0)
+		return false;
+
+	unlink(path.c_str());	// left behind by an earlier run
+	if (bind(fListener, (struct sockaddr*)&address, sizeof(address)) != 0
+		|| listen(fListener, 64) != 0) {
+		close(fListener);
+		fListener = -1;
+		return false;
+	}
+
+	signal(SIGPIPE, SIG_IGN);
+	fRunning = true;
+
+	if (workers <= 0)
+		workers = LThreadCount();
+
+	std::vector<std::thread> pool;
+	for (int32 i = 0; i < workers; ++i)
+		pool.push_back(std::thread(&EMQueryServer::_Worker, this));
+
+	while (fRunning) {
+		int fd = accept(fListener, nullptr, nullptr);
+		if (fd < 0) {
+			if (fRunning && errno == EINTR)
+				continue;
+			break;
+		}
+
+		std::lock_guard<std::mutex> lock(fLock);
+		fConnections.push(fd);
+		fWaiting.notify_one();
+	}
+
+	_Stop();
+	for (auto& thread : pool)
+		thread.join();
+
+	close(fListener);
+	fListener = -1;
+	unlink(path.c_str());
+	return true;
+}
+
+
+std::string
+EMQueryServer	::	Answer	(const std::string& request) const
+{
+	LStringList args;
+	std::istringstream ss(request);
+	std::string word;
+	while (ss >> word)
+		args.push_back(word);
+
+	if (args.empty())
+		return _Error("empty request");
+
+	std::string command = args[0];
+	transform(command.begin(), command.end(), command.begin(), ::tolower);
+	args.erase(args.begin());
+
+	if (command == "global")
+		return _Global(args);
+	if (command == "cell")
+		return _Cell(args);
+	if (command == "station")
+		return _Station(args);
+	if (command == "average")
+		return _Average(args);
+	if (command == "help")
+		return kHelp;
+
+	return _Error("unknown command");
+}
+
+
+int64
+EMQueryServer	::	RequestCount() const
+{
+	return fRequests;
+}
+
+
+//#pragma mark private
+
+
+void
+EMQueryServer	::	_Worker	()
+{
+	while (true) {
+		int fd = -1;
+		{
+			std::unique_lock<std::mutex> lock(fLock);
+			fWaiting.wait(lock, [this] {
+				return !fConnections.empty() || !fRunning;
+			});
+
+			if (fConnections.empty())
+				return;
+
+			fd = fConnections.front();
+			fConnections.pop();
+		}
+
+		_Serve(fd);
+		close(fd);
+	}
+}
+
+
+void
+EMQueryServer	::	_Serve	(int fd)
+{
+	// wake up now and then to notice a shutdown
+	struct timeval timeout = { 1, 0 };
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	std::string pending;
+	char buffer[QUERY_MAX_LINE];
+
+	while (fRunning) {
+		ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+		if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK
+				|| errno == EINTR))
+			continue;
+		if (received <= 0)
+			return;
+
+		pending.append(buffer, received);
+
+		size_t newline;
+		while ((newline = pending.find('\n')) != std::string::npos) {
+			std::string line = pending.substr(0, newline);
+			pending.erase(0, newline + 1);
+			if (!line.empty() && line.back() == '\r')
+				line.pop_back();
+
+			bool last = false;
+			std::string answer;
+			if (line == "quit")
+				return;
+			else if (line == "shutdown") {
+				answer = "{\"ok\":true}";
+				last = true;
+			} else
+				answer = Answer(line);
+
+			fRequests++;
+			answer += '\n';
+			if (send(fd, answer.data(), answer.size(), MSG_NOSIGNAL)
+					!= (ssize_t)answer.size())
+				return;
+
+			if (last) {
+				_Stop();
+				return;
+			}
+		}
+
+		if (pending.size() > QUERY_MAX_LINE) {
+			std::string answer = _Error("request too long") + '\n';
+			send(fd, answer.data(), answer.size(), MSG_NOSIGNAL);
+			return;
+		}
+	}
+}
+
+
+void
+EMQueryServer	::	_Stop	()
+{
+	{
+		std::lock_guard<std::mutex> lock(fLock);
+		fRunning = false;
+		fWaiting.notify_all();
+	}
+
+	// wakes the accept() in Run()
+	if (fListener >= 0)
+		shutdown(fListener, SHUT_RDWR);
+}
+
+
+std::string
+EMQueryServer	::	_Global	(const LStringList& args) const
+{
+	long	from = args.size() > 0 ? atol(args[0].c_str()) : 0,
+			to = args.size() > 1 ? atol(args[1].c_str()) : 1L << 30;
+
+	std::string out = "{\"ok\":true,\"series\":[";
+	bool first = true;
+	for (size_t i = 0; i < fYears.size(); ++i) {
+		if ((long)fYears[i] < from || (long)fYears[i] > to)
+			continue;
+
+		out += first ? "[" : ",[";
+		_Int(out, fYears[i]);
+		out += ',';
+		_Temperature(out, fMeans[i]);
+		out += ',';
+		_Int(out, fCounts[i]);
+		out += ']';
+		first = false;
+	}
+	out += "]}";
+	return out;
+}
+
+
+std::string
+EMQueryServer	::	_Cell	(const LStringList& args) const
+{
+	if (args.size() < 2)
+		return _Error("usage: cell <lat> <lon> [from [to]]");
+
+	int32 cell = _CellFor(args[0], args[1]);
+	if (cell < 0)
+		return _Error("no such cell");
+
+	EMMonthIndex	first = fPyramid.FirstMonth(),
+					end = first;
+	end += fPyramid.MonthCount();
+
+	EMMonthIndex from = first, to = end;
+	if ((args.size() > 2 && !_ParseMonth(args[2], false, from))
+		|| (args.size() > 3 && !_ParseMonth(args[3], true, to)))
+		return _Error("bad month");
+
+	int32	begin = std::max<int32>(from - first, 0),
+			stop = std::min<int32>(to - first, fPyramid.MonthCount());
+
+	std::vector<float> values;
+	for (int32 m = begin; m < stop; ++m)
+		values.push_back(fPyramid.Mean(0, cell, m));
+	LConvertTemperatures(Celsius, fScale, values.data(), values.data(),
+		values.size());
+
+	EMCoordRect rect = fPyramid.CellRect(0, cell);
+	EMMonthIndex start = first;
+	start += begin;
+
+	std::string out = "{\"ok\":true,\"cell\":{\"west\":";
+	_Number(out, rect.West);
+	out += ",\"north\":";
+	_Number(out, rect.North);
+	out += ",\"east\":";
+	_Number(out, rect.East);
+	out += ",\"south\":";
+	_Number(out, rect.South);
+	out += "},\"firstYear\":";
+	_Int(out, start.Year());
+	out += ",\"firstMonth\":";
+	_Int(out, start.Month());
+	out += ",\"values\":[";
+	for (size_t i = 0; i < values.size(); ++i) {
+		if (i > 0)
+			out += ',';
+		_Temperature(out, values[i]);
+	}
+	out += "]}";
+	return out;
+}
+
+
+std::string
+EMQueryServer	::	_Station(const LStringList& args) const
+{
+	if (args.empty())
+		return _Error("usage: station <search>");
+
+	std::string search = args[0];
+	for (size_t i = 1; i < args.size(); ++i)
+		search += " " + args[i];
+
+	std::vector<int32> matches;
+	fSearch.Find(search, matches, true, QUERY_MAX_STATIONS + 1);
+
+	std::string out = "{\"ok\":true,\"stations\":[";
+	int32 found = 0;
+	bool more = (int32)matches.size() > QUERY_MAX_STATIONS;
+	if (more)
+		matches.pop_back();
+
+	for (int32 index : matches) {
+		const Station* station = fSearch.StationAt(index);
+
+		out += found > 0 ? ",{\"id\":" : "{\"id\":";
+		_Int(out, station->ID);
+		out += ",\"name\":";
+		_String(out, station->NAME);
+		out += ",\"country\":";
+		_String(out, station->COUNTRY);
+		out += ",\"lat\":";
+		_Number(out, station->LAT);
+		out += ",\"lon\":";
+		_Number(out, station->LON);
+		out += ",\"elevation\":";
+		_Int(out, station->ELEV);
+		out += ",\"firstYear\":";
+		_Int(out, station->STARTYEAR);
+		out += ",\"endYear\":";
+		_Int(out, station->ENDYEAR - 1);
+		out += '}';
+		++found;
+	}
+
+	out += more ? "],\"more\":true}" : "]}";
+	return out;
+}
+
+
+std::string
+EMQueryServer	::	_Average(const LStringList& args) const
+{
+	if (args.size() < 4)
+		return _Error("usage: average station <id> <from> <to> | "
+			"average cell <lat> <lon> <from> <to>");
+
+	EMTemperature average;
+	EMMonthIndex from, to;
+
+	if (args[0] == "station") {
+		if (!_ParseMonth(args[2], false, from)
+			|| !_ParseMonth(args[3], true, to))
+			return _Error("bad month");
+
+		auto found = fByID.find(strtoul(args[1].c_str(), nullptr, 10));
+		if (found == fByID.end())
+			return _Error("no such station");
+
+		average = found->second->AverageFor(from, to);
+	} else if (args[0] == "cell" && args.size() >= 5) {
+		if (!_ParseMonth(args[3], false, from)
+			|| !_ParseMonth(args[4], true, to))
+			return _Error("bad month");
+
+		int32 cell = _CellFor(args[1], args[2]);
+		if (cell < 0)
+			return _Error("no such cell");
+
+		EMCoordCell* coordCell = fPyramid.FineCell(cell);
+		if (coordCell != nullptr)
+			average = coordCell->AverageFor(from, to);
+	} else
+		return _Error("average what?");
+
+	// nothing in range comes back as absolute zero
+	std::string out = "{\"ok\":true,\"average\":";
+	_Temperature(out, average.toKelvin() > 0 ? _InScale(average, fScale)
+		: SERIES_MISSING);
+	out += '}';
+	return out;
+}
+
+
+int32
+EMQueryServer	::	_CellFor(const std::string& lat,
+						const std::string& lon) const
+{
+	float latitude, longitude;
+	if (!_ParseFloat(lat, latitude) || !_ParseFloat(lon, longitude))
+		return -1;
+
+	return fPyramid.CellFor(0, latitude, longitude);
+}
@@ -0,0 +1,116 @@
+#ifndef EM_QUERY_SERVER_H
+#define EM_QUERY_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "DateIndex.h"
+#include "GridPyramid.h"
+#include "StationListFormat.h"
+#include "StationSearch.h"
+#include "StdTypedefs.h"
+#include "Temperature.h"
+
+/*
+	Keeps the loaded stations and grid in memory and answers questions
+	about them over a Unix domain socket, so asking costs milliseconds
+	rather than a fresh ingest.
+
+	Requests are single lines; every answer is a single line of JSON, with
+	"ok" saying whether it worked and "error" why not.  Years run from
+	January, so a range "from to" covers both ends in full; months may be
+	given as YYYY-MM:
+
+		global [from [to]]				the annual global means and counts
+		cell <lat> <lon> [from [to]]	the grid cell's monthly means
+		station <search>				stations by ID, name or country,
+										falling back to fuzzy matching
+		average station <id> <from> <to>
+		average cell <lat> <lon> <from> <to>
+										mean of the valid months in range
+		help
+		quit							closes the connection
+		shutdown						stops the daemon
+
+	Temperatures are in the daemon's output scale, missing values null.
+
+	Connections are handed to a pool of worker threads, each serving its
+	connection's requests in order.  Everything the workers read is built
+	before the first connection is accepted - range prefix sums included -
+	and never changes afterwards, so they need no locks between them.
+
+		EMQueryServer server(StationList, pyramid, Celsius);
+		server.SetGlobalSeries(years, averages, counts);
+		server.Run("daemon");	// until a shutdown request
+*/
+
+#define	QUERY_SOCKET_DEFAULT	"daemon"
+#define	QUERY_MAX_STATIONS		100		// per station search
+#define	QUERY_MAX_LINE			4096
+
+
+class	EMQueryServer {
+public:
+								EMQueryServer(
+									const std::vector<Station*>&,
+									const EMGridPyramid&,
+									TScale scale = Celsius);
+	virtual						~EMQueryServer();
+
+			// already in the output scale
+			void				SetGlobalSeries(
+									const std::vector<uint32>& years,
+									const std::vector<double>& means,
+									const std::vector<uint32>& counts);
+
+			// Serves until a shutdown request.  Returns false if the
+			// socket can't be set up.
+			bool				Run			(const std::string& name
+												= QUERY_SOCKET_DEFAULT,
+											int32 workers = 0);
+
+			// one request line in, one JSON line out (no newline)
+			std::string			Answer		(const std::string& request)
+												const;
+
+			int64				RequestCount() const;
+
+private:
+			void				_Worker		();
+			void				_Serve		(int fd);
+			void				_Stop		();
+
+			std::string			_Global		(const LStringList&) const;
+			std::string			_Cell		(const LStringList&) const;
+			std::string			_Station	(const LStringList&) const;
+			std::string			_Average	(const LStringList&) const;
+
+			int32				_CellFor	(const std::string& lat,
+											const std::string& lon) const;
+
+		std::vector<Station*>	fStations;
+		std::map<uint32, Station*>
+								fByID;
+		EMStationSearch			fSearch;
+		const EMGridPyramid&	fPyramid;
+		TScale					fScale;
+
+		std::vector<uint32>		fYears;
+		std::vector<double>		fMeans;
+		std::vector<uint32>		fCounts;
+
+		int						fListener;
+		std::atomic<bool>		fRunning;
+		std::mutex				fLock;
+		std::condition_variable	fWaiting;
+		std::queue<int>			fConnections;
+		std::atomic<int64>		fRequests;
+};
+
+
+#endif // EM_QUERY_SERVER_H
@@ -0,0 +1,250 @@
+#include <algorithm>
+
+#include "Parallel.h"
+
+#include "SeriesTable.h"
+
+
+EMSeriesTable	::	EMSeriesTable()
+	:
+	fFirstYear(0),
+	fMonthCount(0),
+	fStride(0)
+{
+}
+
+
+EMSeriesTable	::	~EMSeriesTable()
+{
+}
+
+
+void
+EMSeriesTable	::	Build	(const std::vector<Station*>& stations)
+{
+	fStations = stations;
+
+	int32 firstYear = INT32_MAX, endYear = INT32_MIN;
+	for (const auto* station : stations) {
+		firstYear = std::min(firstYear, station->STARTYEAR);
+		endYear = std::max(endYear, station->ENDYEAR);
+	}
+
+	if (stations.empty() || endYear <= firstYear) {
+		firstYear = 0;
+		endYear = 0;
+	}
+
+	fFirstYear = firstYear;
+	fMonthCount = (endYear - firstYear) * 12;
+	fStride = (fMonthCount + 15) & ~15;	// 64 byte rows
+
+	size_t cells = (size_t)fStride * stations.size();
+	fAnomalies.assign(cells, 0.0f);
+	fMask.assign(cells, 0.0f);
+	fProvenance.assign(cells, PROVENANCE_ORIGINAL);
+	fClimatology.assign(stations.size() * 12, 0.0f);
+	fFirstMonth.assign(stations.size(), 0);
+	fEndMonth.assign(stations.size(), 0);
+
+	LParallelFor(stations.size(), [this](int32 begin, int32 end, int32) {
+		for (int32 i = begin; i < end; ++i) {
+			const Station* station = fStations[i];
+			int32 years = station->ENDYEAR - station->STARTYEAR,
+				offset = (station->STARTYEAR - fFirstYear) * 12;
+
+			float*	anomalies = _Row(fAnomalies, i);
+			float*	mask = _Row(fMask, i);
+			float*	climatology = &fClimatology[i * 12];
+
+			double	accum[12] = {};
+			int32	count[12] = {};
+
+			for (int32 y = 0; y < years && station->DATA != nullptr; ++y) {
+				const YearData& yd = station->DATA[y];
+				if (!yd.VALID)
+					continue;
+
+				for (int16 m = 0; m < 12; ++m) {
+					float value = yd.MonthValue(m + 1);
+					if (value > -99) {
+						anomalies[offset + y * 12 + m] = value;
+						mask[offset + y * 12 + m] = 1.0f;
+						accum[m] += value;
+						count[m]++;
+					}
+				}
+			}
+
+			for (int16 m = 0; m < 12; ++m)
+				climatology[m] = count[m] > 0 ? accum[m] / count[m] : 0.0;
+
+			int32 first = fMonthCount, last = 0;
+			for (int32 m = offset; m < offset + years * 12; ++m) {
+				if (mask[m] == 0.0f)
+					continue;
+
+				anomalies[m] -= climatology[m % 12];
+				first = std::min(first, m);
+				last = m + 1;
+			}
+
+			fFirstMonth[i] = first < last ? first : 0;
+			fEndMonth[i] = last;
+		}
+	});
+}
+
+
+int32
+EMSeriesTable	::	StationCount() const
+{
+	return fStations.size();
+}
+
+
+int32
+EMSeriesTable	::	MonthCount	() const
+{
+	return fMonthCount;
+}
+
+
+int32
+EMSeriesTable	::	Stride		() const
+{
+	return fStride;
+}
+
+
+int32
+EMSeriesTable	::	FirstYear	() const
+{
+	return fFirstYear;
+}
+
+
+Station*
+EMSeriesTable	::	StationAt	(int32 station) const
+{
+	return fStations.at(station);
+}
+
+
+int32
+EMSeriesTable	::	MonthIndex	(int32 year, int16 month) const
+{
+	return (year - fFirstYear) * 12 + month - 1;
+}
+
+
+int32
+EMSeriesTable	::	MonthIndex	(EMMonthIndex month) const
+{
+	return month - EMMonthIndex(fFirstYear, 1);
+}
+
+
+const float*
+EMSeriesTable	::	Anomalies	(int32 station) const
+{
+	return &fAnomalies[(size_t)station * fStride];
+}
+
+
+const float*
+EMSeriesTable	::	Mask		(int32 station) const
+{
+	return &fMask[(size_t)station * fStride];
+}
+
+
+bool
+EMSeriesTable	::	IsValid		(int32 station, int32 month) const
+{
+	if (month < 0 || month >= fMonthCount)
+		return false;
+
+	return Mask(station)[month] != 0.0f;
+}
+
+
+float
+EMSeriesTable	::	Anomaly		(int32 station, int32 month) const
+{
+	if (month < 0 || month >= fMonthCount)
+		return 0.0f;
+
+	return Anomalies(station)[month];
+}
+
+
+float
+EMSeriesTable	::	Climatology	(int32 station, int16 month) const
+{
+	return fClimatology[station * 12 + (month - 1)];
+}
+
+
+float
+EMSeriesTable	::	Value		(int32 station, int32 month) const
+{
+	if (!IsValid(station, month))
+		return SERIES_MISSING;
+
+	return Anomalies(station)[month] + fClimatology[station * 12 + month % 12];
+}
+
+
+int32
+EMSeriesTable	::	FirstMonth	(int32 station) const
+{
+	return fFirstMonth[station];
+}
+
+
+int32
+EMSeriesTable	::	EndMonth	(int32 station) const
+{
+	return fEndMonth[station];
+}
+
+
+const uint8*
+EMSeriesTable	::	Provenance	(int32 station) const
+{
+	return &fProvenance[(size_t)station * fStride];
+}
+
+
+bool
+EMSeriesTable	::	IsInfilled	(int32 station, int32 month) const
+{
+	if (month < 0 || month >= fMonthCount)
+		return false;
+
+	return Provenance(station)[month] == PROVENANCE_INFILLED;
+}
+
+
+void
+EMSeriesTable	::	SetInfilled	(int32 station, int32 month, float anomaly)
+{
+	if (month < 0 || month >= fMonthCount)
+		return;
+
+	size_t cell = (size_t)station * fStride + month;
+	fAnomalies[cell] = anomaly;
+	fMask[cell] = 1.0f;
+	fProvenance[cell] = PROVENANCE_INFILLED;
+}
+
+
+//#pragma mark protected
+
+
+float*
+EMSeriesTable	::	_Row	(std::vector<float>& data, int32 station)
+{
+	return &data[(size_t)station * fStride];
+}
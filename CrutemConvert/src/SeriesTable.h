@@ -0,0 +1,97 @@
+#ifndef EM_SERIES_TABLE_H
+#define EM_SERIES_TABLE_H
+
+#include <vector>
+
+#include "DateIndex.h"
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+
+/*
+	Every station's monthly data laid out on one shared month axis, ready
+	for the passes which compare stations with each other.
+
+	Values are stored as anomalies from the station's own climatology for
+	that calendar month.  Missing months hold an anomaly of zero and a mask
+	of zero, valid months a mask of one, so sums over a row can multiply by
+	the mask instead of branching:
+
+		const float* x = table.Anomalies(i);
+		const float* valid = table.Mask(j);
+		for (int32 m = 0; m < table.MonthCount(); ++m)
+			sum += x[m] * valid[m];	// i's anomalies where j has data
+
+	Month 0 is January of FirstYear().  Rows are padded out to Stride()
+	floats so every row starts on the same alignment.  The table is a
+	snapshot: changes to the stations after Build() are not seen.
+
+	Passes which estimate missing months (infill) record them with
+	SetInfilled(), which marks the month valid and flags it in the
+	row's provenance mask, so later output can tell measured months
+	from estimated ones.
+*/
+
+#define SERIES_MISSING		-99.9
+
+enum EMProvenance {
+	PROVENANCE_ORIGINAL = 0,
+	PROVENANCE_INFILLED
+};
+
+class	EMSeriesTable {
+public:
+								EMSeriesTable();
+	virtual						~EMSeriesTable();
+
+			void				Build		(const std::vector<Station*>&);
+
+			int32				StationCount() const;
+			int32				MonthCount	() const;
+			int32				Stride		() const;
+			int32				FirstYear	() const;
+
+			Station*			StationAt	(int32 station) const;
+
+			// month axis index for a year and month (1 - 12)
+			int32				MonthIndex	(int32 year, int16 month) const;
+			int32				MonthIndex	(EMMonthIndex) const;
+
+			const float*		Anomalies	(int32 station) const;
+			const float*		Mask		(int32 station) const;
+
+			bool				IsValid		(int32 station, int32 month) const;
+			float				Anomaly		(int32 station, int32 month) const;
+			float				Climatology	(int32 station, int16 month) const;
+
+			// climatology + anomaly, or SERIES_MISSING
+			float				Value		(int32 station, int32 month) const;
+
+			// valid data lies within [FirstMonth, EndMonth)
+			int32				FirstMonth	(int32 station) const;
+			int32				EndMonth	(int32 station) const;
+
+			const uint8*		Provenance	(int32 station) const;
+			bool				IsInfilled	(int32 station, int32 month) const;
+			void				SetInfilled	(int32 station, int32 month,
+											float anomaly);
+
+protected:
+			float*				_Row		(std::vector<float>&, int32);
+
+		std::vector<Station*>	fStations;
+
+		int32					fFirstYear;
+		int32					fMonthCount;
+		int32					fStride;
+
+		std::vector<float>		fAnomalies;
+		std::vector<float>		fMask;
+		std::vector<float>		fClimatology;	// 12 per station
+		std::vector<uint8>		fProvenance;
+
+		std::vector<int32>		fFirstMonth;
+		std::vector<int32>		fEndMonth;
+};
+
+
+#endif // EM_SERIES_TABLE_H
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <fcntl.h>
+#include <limits>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Parallel.h"
+
+#include "SharedDataset.h"
+
+
+static uint64_t
+_Align(uint64_t offset)
+{
+	return (offset + SHARED_ALIGNMENT - 1) / SHARED_ALIGNMENT
+		* SHARED_ALIGNMENT;
+}
+
+
+static std::string
+_SegmentName(const std::string& name)
+{	// POSIX wants exactly one leading slash
+	return name.size() > 0 && name[0] == '/' ? name : "/" + name;
+}
+
+
+EMSharedDataset	::	EMSharedDataset()
+	:
+	fAddress(nullptr),
+	fSize(0)
+{
+}
+
+
+EMSharedDataset	::	~EMSharedDataset()
+{
+	Detach();
+}
+
+
+bool
+EMSharedDataset	::	Publish	(const std::vector<Station*>& stations,
+								const std::string& name)
+{
+	Detach();
+
+	std::string segment = _SegmentName(name);
+
+	// the month axis covers every station
+	int32	firstYear = 0,
+			endYear = 0;
+	for (const Station* station : stations) {
+		if (station->ENDYEAR <= station->STARTYEAR)
+			continue;
+		if (endYear == 0 || station->STARTYEAR < firstYear)
+			firstYear = station->STARTYEAR;
+		endYear = std::max<int32>(endYear, station->ENDYEAR);
+	}
+
+	const uint32_t	count = stations.size(),
+					months = (endYear - firstYear) * 12,
+					stride = _Align(months * sizeof(float)) / sizeof(float);
+
+	EMSharedHeader header;
+	memset(&header, 0, sizeof(header));
+	header.version = SHARED_LAYOUT_VERSION;
+	header.stationCount = count;
+	header.stationSize = sizeof(EMSharedStation);
+	header.firstYear = firstYear;
+	header.monthCount = months;
+	header.stride = stride;
+	header.stationsOffset = _Align(sizeof(EMSharedHeader));
+	header.seriesOffset = _Align(header.stationsOffset
+		+ (uint64_t)count * sizeof(EMSharedStation));
+	header.size = header.seriesOffset
+		+ (uint64_t)count * stride * sizeof(float);
+
+	// a fresh segment, so anyone on the old one keeps a consistent copy
+	shm_unlink(segment.c_str());
+	int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+	if (fd < 0)
+		return false;
+
+	if (ftruncate(fd, header.size) != 0 || !_Map(fd, header.size, true)) {
+		close(fd);
+		shm_unlink(segment.c_str());
+		return false;
+	}
+	close(fd);
+
+	char* base = (char*)fAddress;
+	memcpy(base, &header, sizeof(header));
+
+	EMSharedStation* table = (EMSharedStation*)(base + header.stationsOffset);
+	float* series = (float*)(base + header.seriesOffset);
+	const float nan = std::numeric_limits<float>::quiet_NaN();
+
+	LParallelFor(count, [&](int32 begin, int32 end, int32) {
+		for (int32 i = begin; i < end; ++i) {
+			const Station& station = *stations[i];
+			EMSharedStation& entry = table[i];
+
+			memset(&entry, 0, sizeof(entry));
+			entry.id = station.ID;
+			entry.lat = station.LAT;
+			entry.lon = station.LON;
+			entry.elevation = station.ELEV;
+			entry.startYear = station.STARTYEAR;
+			entry.endYear = station.ENDYEAR;
+			entry.quality = station.QUALITY;
+			memcpy(entry.name, station.NAME,
+				strnlen(station.NAME, sizeof(entry.name) - 1));
+			memcpy(entry.country, station.COUNTRY,
+				strnlen(station.COUNTRY, sizeof(entry.country) - 1));
+
+			float* row = series + (size_t)i * stride;
+			std::fill(row, row + stride, nan);
+
+			int32 years = station.ENDYEAR - station.STARTYEAR;
+			if (years <= 0 || station.DATA == nullptr)
+				continue;
+
+			float* out = row + (station.STARTYEAR - firstYear) * 12;
+			for (int32 y = 0; y < years; ++y) {
+				const YearData& yd = station.DATA[y];
+				for (int16 m = 0; m < 12; ++m) {
+					float value = yd.VALID ? yd.MonthValue(m + 1) : nan;
+					out[y * 12 + m] = value > -99 ? value : nan;
+				}
+			}
+		}
+	}, 16);
+
+	// readers take the magic to mean the rest is there
+	__atomic_store_n(&((EMSharedHeader*)base)->magic, SHARED_MAGIC,
+		__ATOMIC_RELEASE);
+	return true;
+}
+
+
+bool
+EMSharedDataset	::	Attach	(const std::string& name)
+{
+	Detach();
+
+	int fd = shm_open(_SegmentName(name).c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	bool mapped = fstat(fd, &info) == 0
+		&& (size_t)info.st_size >= sizeof(EMSharedHeader)
+		&& _Map(fd, info.st_size, false);
+	close(fd);
+	if (!mapped)
+		return false;
+
+	// the magic first: once it reads as published, so does the rest
+	const EMSharedHeader* header = Header();
+	if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SHARED_MAGIC) {
+		Detach();
+		return false;
+	}
+
+	if (header->version != SHARED_LAYOUT_VERSION
+		|| header->stationSize != sizeof(EMSharedStation)
+		|| header->size > fSize
+		|| header->stationsOffset + (uint64_t)header->stationCount
+			* sizeof(EMSharedStation) > header->size
+		|| header->seriesOffset + (uint64_t)header->stationCount
+			* header->stride * sizeof(float) > header->size
+		|| header->stride < header->monthCount) {
+		Detach();
+		return false;
+	}
+
+	return true;
+}
+
+
+void
+EMSharedDataset	::	Detach	()
+{
+	if (fAddress != nullptr)
+		munmap(fAddress, fSize);
+
+	fAddress = nullptr;
+	fSize = 0;
+}
+
+
+bool
+EMSharedDataset	::	Unlink	(const std::string& name)
+{
+	return shm_unlink(_SegmentName(name).c_str()) == 0;
+}
+
+
+bool
+EMSharedDataset	::	IsMapped() const
+{
+	return fAddress != nullptr;
+}
+
+
+size_t
+EMSharedDataset	::	Size	() const
+{
+	return fSize;
+}
+
+
+const EMSharedHeader*
+EMSharedDataset	::	Header	() const
+{
+	return (const EMSharedHeader*)fAddress;
+}
+
+
+int32
+EMSharedDataset	::	StationCount() const
+{
+	return fAddress != nullptr ? Header()->stationCount : 0;
+}
+
+
+int32
+EMSharedDataset	::	FirstYear() const
+{
+	return fAddress != nullptr ? Header()->firstYear : 0;
+}
+
+
+int32
+EMSharedDataset	::	MonthCount() const
+{
+	return fAddress != nullptr ? Header()->monthCount : 0;
+}
+
+
+const EMSharedStation*
+EMSharedDataset	::	StationAt(int32 station) const
+{
+	if (station < 0 || station >= StationCount())
+		return nullptr;
+
+	return (const EMSharedStation*)((const char*)fAddress
+		+ Header()->stationsOffset) + station;
+}
+
+
+const float*
+EMSharedDataset	::	Series	(int32 station) const
+{
+	if (station < 0 || station >= StationCount())
+		return nullptr;
+
+	return (const float*)((const char*)fAddress + Header()->seriesOffset)
+		+ (size_t)station * Header()->stride;
+}
+
+
+//#pragma mark private
+
+
+bool
+EMSharedDataset	::	_Map	(int fd, size_t size, bool write)
+{
+	void* address = mmap(nullptr, size, write ? PROT_READ | PROT_WRITE
+		: PROT_READ, MAP_SHARED, fd, 0);
+	if (address == MAP_FAILED)
+		return false;
+
+	fAddress = address;
+	fSize = size;
+	return true;
+}
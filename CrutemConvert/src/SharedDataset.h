@@ -0,0 +1,113 @@
+#ifndef EM_SHARED_DATASET_H
+#define EM_SHARED_DATASET_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+
+/*
+	The loaded stations, published once per host in a named POSIX shared
+	memory segment - a first step towards the EarthModel shared memory
+	area.  Any number of processes map the segment read-only and start on
+	the data straight away, sharing the one copy in RAM.
+
+	The layout is plain data at fixed offsets, with no pointers, so it
+	reads the same wherever it is mapped:
+
+		EMSharedHeader		at 0
+		EMSharedStation		stationCount of them, at stationsOffset
+		series				stationCount rows of stride floats, at
+							seriesOffset: the station's monthly values
+							(Celsius) from January of firstYear, NaN
+							where missing
+
+	Every section starts on a 64 byte boundary, as does every series row.
+	Readers must check magic, version and size before anything else; the
+	publisher writes the magic last, so a segment still being filled is
+	never taken for a finished one.  A newer publication replaces the name,
+	while processes which mapped the old one keep it until they detach.
+
+		EMSharedDataset shared;
+		if (shared.Attach(SHARED_DEFAULT_NAME)) {
+			const float* series = shared.Series(0);
+			...
+		}
+*/
+
+#define	SHARED_DEFAULT_NAME		"/crucon"
+#define	SHARED_MAGIC			0x44534D45	// "EMSD"
+#define	SHARED_LAYOUT_VERSION	1
+#define	SHARED_ALIGNMENT		64
+
+
+struct EMSharedHeader {
+	uint32_t			magic;
+	uint32_t			version;
+	uint64_t			size;			// the whole segment, in bytes
+
+	uint32_t			stationCount;
+	uint32_t			stationSize;	// sizeof(EMSharedStation)
+	int32_t				firstYear;
+	uint32_t			monthCount;
+	uint32_t			stride;			// floats per series row
+	uint32_t			reserved;
+
+	uint64_t			stationsOffset;
+	uint64_t			seriesOffset;
+};
+
+
+struct EMSharedStation {
+	uint32_t			id;
+	float				lat;
+	float				lon;
+	int32_t				elevation;
+	int32_t				startYear;
+	int32_t				endYear;		// exclusive, as in Station
+	float				quality;
+	uint32_t			reserved;
+	char				name[128];
+	char				country[64];
+};
+
+
+class	EMSharedDataset {
+public:
+								EMSharedDataset();
+	virtual						~EMSharedDataset();
+
+			// Creates (or replaces) the named segment and fills it.  The
+			// segment outlives this process; Unlink() removes the name.
+			bool				Publish		(const std::vector<Station*>&,
+											const std::string& name
+												= SHARED_DEFAULT_NAME);
+			// Maps an existing segment read-only.
+			bool				Attach		(const std::string& name
+												= SHARED_DEFAULT_NAME);
+			void				Detach		();
+	static	bool				Unlink		(const std::string& name
+												= SHARED_DEFAULT_NAME);
+
+			bool				IsMapped	() const;
+			size_t				Size		() const;
+
+			const EMSharedHeader*	Header	() const;
+			int32				StationCount() const;
+			int32				FirstYear	() const;
+			int32				MonthCount	() const;
+
+			const EMSharedStation*	StationAt(int32 station) const;
+			const float*		Series		(int32 station) const;
+
+private:
+			bool				_Map		(int fd, size_t size, bool write);
+
+		void*					fAddress;
+		size_t					fSize;
+};
+
+
+#endif // EM_SHARED_DATASET_H
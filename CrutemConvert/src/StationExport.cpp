@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <atomic>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "OutputWriter.h"
+#include "Parallel.h"
+#include "SeriesTable.h"
+
+#include "StationExport.h"
+
+
+#define EXPORT_BATCH_PER_THREAD	16
+
+
+EMStationExport	::	EMStationExport(TScale scale)
+	:
+	fScale(scale),
+	fStations(0)
+{
+}
+
+
+EMStationExport	::	~EMStationExport()
+{
+}
+
+
+TScale
+EMStationExport	::	Scale	() const
+{
+	return fScale;
+}
+
+
+void
+EMStationExport	::	SetFilter	(std::function<bool(const Station&)> filter)
+{
+	fFilter = filter;
+}
+
+
+bool
+EMStationExport	::	Accepts	(const Station& station) const
+{
+	return !fFilter || fFilter(station);
+}
+
+
+int64
+EMStationExport	::	WriteCSV	(const std::vector<Station*>& stations,
+									const std::string& path)
+{
+	fStations = 0;
+
+	EMOutputWriter file;
+	if (!file.Open(path))
+		return -1;
+
+	file.Write("STATION,YEAR,MONTH,TEMP,INFILLED\n");
+
+	std::vector<Station*> accepted;
+	for (Station* station : stations) {
+		if (Accepts(*station))
+			accepted.push_back(station);
+	}
+
+	// Render a batch of stations in parallel, then write the batch out in
+	// order before starting the next.
+	int32 batch = LThreadCount() * EXPORT_BATCH_PER_THREAD;
+	std::vector<std::string> text(batch);
+	std::vector<std::vector<float> > scratch(LThreadCount());
+	int64 written = 0;
+
+	for (size_t first = 0; first < accepted.size(); first += batch) {
+		int32 count = std::min<size_t>(batch, accepted.size() - first);
+		std::vector<int32> produced(count, 0);
+
+		LParallelFor(count, [&](int32 begin, int32 end, int32 thread) {
+			for (int32 i = begin; i < end; ++i) {
+				text[i].clear();
+				produced[i] = _Render(*accepted[first + i], true,
+					scratch[thread], text[i]);
+			}
+		}, 1);
+
+		for (int32 i = 0; i < count; ++i) {
+			file.Write(text[i]);
+			written += produced[i];
+			if (produced[i] > 0)
+				++fStations;
+		}
+	}
+
+	return file.Close() ? written : -1;
+}
+
+
+int64
+EMStationExport	::	WriteFiles	(const std::vector<Station*>& stations,
+									const std::string& directory)
+{
+	fStations = 0;
+
+	if (mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+		return -1;
+
+	std::vector<Station*> accepted;
+	for (Station* station : stations) {
+		if (Accepts(*station))
+			accepted.push_back(station);
+	}
+
+	std::vector<std::string> text(LThreadCount());
+	std::vector<std::vector<float> > scratch(LThreadCount());
+	std::atomic<int64> written(0);
+	std::atomic<int32> files(0);
+	std::atomic<bool> failed(false);
+
+	LParallelFor(accepted.size(), [&](int32 begin, int32 end, int32 thread) {
+		std::string& out = text[thread];
+
+		for (int32 i = begin; i < end && !failed; ++i) {
+			const Station& station = *accepted[i];
+
+			out.assign("YEAR,MONTH,TEMP,INFILLED\n");
+			int32 produced = _Render(station, false, scratch[thread], out);
+			if (produced == 0)
+				continue;
+
+			char name[LFORMAT_MAX + 5];
+			*std::copy(".csv", ".csv" + 4, LFormatInt(name, station.ID)) = 0;
+			std::string path = directory + "/" + name;
+
+			FILE* file = fopen(path.c_str(), "wb");
+			if (file == NULL) {
+				failed = true;
+				break;
+			}
+
+			bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+			if (fclose(file) != 0 || !ok) {
+				failed = true;
+				break;
+			}
+
+			written += produced;
+			files++;
+		}
+	}, 4);
+
+	fStations = files;
+	return failed ? -1 : (int64)written;
+}
+
+
+int32
+EMStationExport	::	StationsWritten() const
+{
+	return fStations;
+}
+
+
+//#pragma mark private
+
+
+int32
+EMStationExport	::	_Render		(const Station& station, bool withID,
+									std::vector<float>& scratch,
+									std::string& out) const
+{	// Appends the station's valid months to out, one line each.
+	int32 years = station.ENDYEAR - station.STARTYEAR;
+	if (years <= 0 || station.DATA == nullptr)
+		return 0;
+
+	// Celsius in the first half, the output scale in the second; which
+	// months are missing is read from the Celsius side.
+	int32 months = years * 12;
+	scratch.resize(months * 2);
+	float*	celsius = scratch.data();
+	float*	value = celsius + months;
+
+	for (int32 y = 0; y < years; ++y) {
+		const YearData& yd = station.DATA[y];
+		for (int16 m = 0; m < 12; ++m)
+			celsius[y * 12 + m] = yd.VALID ? yd.MonthValue(m + 1)
+				: SERIES_MISSING;
+	}
+	LConvertTemperatures(Celsius, fScale, celsius, value, months);
+
+	char prefix[LFORMAT_MAX];
+	char* prefixEnd = prefix;
+	if (withID) {
+		prefixEnd = LFormatInt(prefix, station.ID);
+		*prefixEnd++ = ',';
+	}
+	int32 prefixLength = prefixEnd - prefix;
+
+	size_t start = out.size();
+	out.resize(start + months * (prefixLength + 12 + LFORMAT_MAX));
+
+	char* cursor = &out[start];
+	int32 produced = 0;
+	for (int32 k = 0; k < months; ++k) {
+		if (!(celsius[k] > -99))
+			continue;
+
+		cursor = std::copy(prefix, prefix + prefixLength, cursor);
+		cursor = LFormatInt(cursor, station.STARTYEAR + k / 12);
+		*cursor++ = ',';
+		cursor = LFormatInt(cursor, k % 12 + 1);
+		*cursor++ = ',';
+		cursor = LFormatFixed(cursor, value[k], 2);
+		*cursor++ = ',';
+		*cursor++ = station.DATA[k / 12].IsInfilled(k % 12 + 1) ? '1' : '0';
+		*cursor++ = '\n';
+		++produced;
+	}
+	out.resize(cursor - out.data());
+
+	return produced;
+}
@@ -0,0 +1,69 @@
+#ifndef EM_STATION_EXPORT_H
+#define EM_STATION_EXPORT_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+#include "Temperature.h"
+
+/*
+	Writes stations' full monthly series out as CSV, either all into one
+	long-format file:
+
+		STATION,YEAR,MONTH,TEMP,INFILLED
+
+	or as one file per station, "<directory>/<ID>.csv", each holding
+	YEAR,MONTH,TEMP,INFILLED.  INFILLED is 1 for months -infill estimated
+	and 0 for measured ones.  Missing months are left out.
+
+	Stations are rendered on the worker threads, each into its own buffer
+	with the allocation-free formatters, so the CPU keeps ahead of the
+	disk.  A single file is written from the buffers in list order, a batch
+	at a time so memory stays bounded; per-station files are each written
+	whole, with one call, by the thread that rendered them.
+
+		EMStationExport exporter(Fahrenheit);
+		exporter.SetFilter([](const Station& station) {
+			return strstr(station.COUNTRY, "NORWAY") != NULL;
+		});
+		exporter.WriteCSV(StationList, "data/stations.csv");
+*/
+
+class	EMStationExport {
+public:
+								EMStationExport(TScale scale = Celsius);
+	virtual						~EMStationExport();
+
+			TScale				Scale		() const;
+
+			// Only stations the filter accepts are written.  No filter
+			// (the default) writes them all.
+			void				SetFilter	(std::function<bool(const Station&)>);
+			bool				Accepts		(const Station&) const;
+
+			// Both return the number of values written, or -1 if a file
+			// can't be written.
+			int64				WriteCSV	(const std::vector<Station*>&,
+											const std::string& path);
+			int64				WriteFiles	(const std::vector<Station*>&,
+											const std::string& directory);
+
+			// by the last WriteCSV() or WriteFiles()
+			int32				StationsWritten() const;
+
+private:
+			int32				_Render		(const Station&, bool withID,
+											std::vector<float>& scratch,
+											std::string& out) const;
+
+		TScale					fScale;
+		std::function<bool(const Station&)>
+								fFilter;
+		int32					fStations;
+};
+
+
+#endif // EM_STATION_EXPORT_H
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cmath>
+
+#include "MathUtils.h"
+
+#include "StationIndex.h"
+
+
+EMStationIndex	::	EMStationIndex(float bandDegrees)
+	:
+	fBandDegrees(bandDegrees > 0 ? bandDegrees : 2.0),
+	fBandCount(0)
+{
+}
+
+
+EMStationIndex	::	~EMStationIndex()
+{
+}
+
+
+void
+EMStationIndex	::	Build	(const std::vector<Station*>& stations)
+{
+	std::vector<EMPoint> points;
+	points.reserve(stations.size());
+
+	for (const auto* station : stations)
+		points.push_back(EMPoint(station->LON, station->LAT));
+
+	_Bucket(points);
+	fStations = stations;
+}
+
+
+void
+EMStationIndex	::	Build	(const std::vector<EMPoint>& points)
+{
+	_Bucket(points);
+	fStations.clear();
+}
+
+
+int32
+EMStationIndex	::	Count	() const
+{
+	return fPoints.size();
+}
+
+
+Station*
+EMStationIndex	::	StationAt	(int32 index) const
+{
+	if (index < 0 || index >= (int32)fStations.size())
+		return nullptr;
+
+	return fStations[index];
+}
+
+
+EMPoint
+EMStationIndex	::	PointAt		(int32 index) const
+{
+	return fPoints.at(index);
+}
+
+
+int32
+EMStationIndex	::	Radius	(const EMPoint& center, float km,
+							std::vector<EMStationHit>& out,
+							int32 exclude) const
+{
+	out.clear();
+	if (fPoints.empty() || km < 0)
+		return 0;
+
+	_Gather(center, km / EARTH_RADIUS_KM, out, exclude);
+
+	for (auto& hit : out)
+		hit.distance = _ChordToKm(hit.distance);
+
+	return out.size();
+}
+
+
+int32
+EMStationIndex	::	KNearest	(const EMPoint& center, int32 k,
+								std::vector<EMStationHit>& out,
+								int32 exclude) const
+{
+	out.clear();
+	if (k <= 0 || fPoints.empty())
+		return 0;
+
+	int32 available = fPoints.size();
+	if (exclude >= 0 && exclude < available)
+		--available;
+
+	k = std::min(k, available);
+	if (k <= 0)
+		return 0;
+
+	// Grow the search radius until it holds k entries.  Everything within
+	// the radius is found, so the k closest hits are the true k nearest.
+	// Stations cluster heavily, so start well below the cap that would
+	// hold k entries at average density and double from there.
+	double theta = 0.5 * sqrt((double)k / fPoints.size());
+
+	while (true) {
+		_Gather(center, theta, out, exclude);
+		if ((int32)out.size() >= k || theta >= M_PI)
+			break;
+		theta = std::min(theta * 2.0, M_PI);
+	}
+
+	// hits still hold squared chords here, which sort the same as distance
+	auto nearer = [](const EMStationHit& one, const EMStationHit& two) {
+		return one.distance < two.distance
+			|| (one.distance == two.distance && one.index < two.index);
+	};
+
+	std::partial_sort(out.begin(), out.begin() + k, out.end(), nearer);
+	out.resize(k);
+
+	for (auto& hit : out)
+		hit.distance = _ChordToKm(hit.distance);
+
+	return out.size();
+}
+
+
+//#pragma mark private
+
+
+void
+EMStationIndex	::	_Gather	(const EMPoint& center, double theta,
+							std::vector<EMStationHit>& out,
+							int32 exclude) const
+{	// Collects the entries within `theta` radians, leaving the squared
+	// chord length in each hit's distance.
+	out.clear();
+
+	if (theta > M_PI)
+		theta = M_PI;
+
+	// inside the cap when the chord is shorter than 2 sin(theta/2)
+	double	halfChord = sin(theta / 2.0),
+			lat = LRadians(center.y),
+			lon = LRadians(center.x),
+			cosLat = cos(lat);
+	float	maxChordSq = 4.0 * halfChord * halfChord;
+
+	float	cx = cosLat * cos(lon),
+			cy = cosLat * sin(lon),
+			cz = sin(lat);
+
+	// longitude reach of the cap, the same for every band it touches
+	double	thetaDeg = LDegrees(theta),
+			lonReach = 180.0;
+
+	if (fabs(center.y) + thetaDeg < 90.0) {
+		double ratio = sin(theta) / cosLat;
+		if (ratio < 1.0)
+			lonReach = LDegrees(asin(ratio));
+	}
+
+	int32	firstBand = _BandFor(center.y - thetaDeg),
+			lastBand = _BandFor(center.y + thetaDeg);
+
+	for (int32 band = firstBand; band <= lastBand; ++band) {
+		int32	buckets = fBandBuckets[band],
+				start = fBandStart[band];
+		double	perDegree = buckets / 360.0;
+
+		int32	lo = 0,
+				hi = buckets - 1;
+
+		if (lonReach < 180.0) {
+			lo = (int32)floor((center.x - lonReach + 180.0) * perDegree);
+			hi = (int32)floor((center.x + lonReach + 180.0) * perDegree);
+			if (hi - lo + 1 >= buckets) {
+				lo = 0;
+				hi = buckets - 1;
+			}
+		}
+
+		for (int32 b = lo; b <= hi; ++b) {
+			// the query may wrap around the date line at either end
+			int32 bucket = b < 0 ? b + buckets : (b >= buckets ? b - buckets : b);
+			bucket += start;
+
+			int32	first = fBucketStart[bucket],
+					last = fBucketStart[bucket + 1];
+
+			for (int32 i = first; i < last; ++i) {
+				float	dx = fUnit.x[i] - cx,
+						dy = fUnit.y[i] - cy,
+						dz = fUnit.z[i] - cz,
+						chordSq = dx * dx + dy * dy + dz * dz;
+
+				if (chordSq > maxChordSq || fIndex[i] == exclude)
+					continue;
+
+				EMStationHit hit;
+				hit.index = fIndex[i];
+				hit.distance = chordSq;
+				out.push_back(hit);
+			}
+		}
+	}
+}
+
+
+float
+EMStationIndex	::	_ChordToKm	(float chordSq)
+{
+	return 2.0 * EARTH_RADIUS_KM * asin(std::min(1.0f, sqrtf(chordSq) / 2.0f));
+}
+
+
+void
+EMStationIndex	::	_Bucket	(const std::vector<EMPoint>& points)
+{
+	fPoints = points;
+
+	fBandCount = (int32)ceil(180.0 / fBandDegrees);
+	fBandStart.assign(fBandCount, 0);
+	fBandBuckets.assign(fBandCount, 1);
+
+	// keep the buckets about as wide as they are tall on the ground
+	int32 totalBuckets = 0;
+	for (int32 band = 0; band < fBandCount; ++band) {
+		double	south = -90.0 + band * fBandDegrees,
+				north = std::min(90.0, south + fBandDegrees),
+				widest = cos(LRadians(std::min(fabs(south), fabs(north))));
+
+		int32 buckets = (int32)ceil(360.0 * widest / fBandDegrees);
+		fBandBuckets[band] = std::max<int32>(1, buckets);
+		fBandStart[band] = totalBuckets;
+		totalBuckets += fBandBuckets[band];
+	}
+
+	// counting sort of the entries into their buckets
+	std::vector<int32> bucketOf(points.size());
+	fBucketStart.assign(totalBuckets + 1, 0);
+
+	for (size_t i = 0; i < points.size(); ++i) {
+		int32	band = _BandFor(points[i].y),
+				buckets = fBandBuckets[band];
+		double	lon = fmod(points[i].x + 180.0, 360.0);
+
+		if (lon < 0)
+			lon += 360.0;
+
+		int32 b = std::min(buckets - 1, (int32)(lon / (360.0 / buckets)));
+		bucketOf[i] = fBandStart[band] + b;
+		fBucketStart[bucketOf[i] + 1]++;
+	}
+
+	for (int32 b = 0; b < totalBuckets; ++b)
+		fBucketStart[b + 1] += fBucketStart[b];
+
+	std::vector<EMPoint> sorted(points.size());
+	fIndex.resize(points.size());
+
+	std::vector<int32> fill(fBucketStart.begin(), fBucketStart.end() - 1);
+	for (size_t i = 0; i < points.size(); ++i) {
+		int32 slot = fill[bucketOf[i]]++;
+		sorted[slot] = points[i];
+		fIndex[slot] = i;
+	}
+
+	LUnitVectors(sorted.data(), sorted.size(), fUnit);
+}
+
+
+int32
+EMStationIndex	::	_BandFor	(float lat) const
+{
+	int32 band = (int32)floor((lat + 90.0) / fBandDegrees);
+	return std::max<int32>(0, std::min(fBandCount - 1, band));
+}
@@ -0,0 +1,95 @@
+#ifndef EM_STATION_INDEX_H
+#define EM_STATION_INDEX_H
+
+#include <vector>
+
+#include "MathUtils.h"
+#include "Point.h"
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+
+/*
+	Answers "which stations lie within R km of this point" without walking
+	the whole station list.
+
+	Stations are bucketed into latitude bands of a fixed height, each band
+	being split into as many longitude buckets as keeps the buckets roughly
+	square on the ground (so polar bands hold only a handful of buckets).
+	Every entry is stored as a unit vector on the sphere, so the distance
+	test is a dot product against the query's chord length - no trig per
+	candidate.  Distances handed back are great circle kilometers, the same
+	as LDistance() reports.
+
+	Usage:
+
+		EMStationIndex index;
+		index.Build(StationList);
+
+		std::vector<EMStationHit> hits;
+		index.Radius(EMPoint(lon, lat), 500.0, hits);
+		index.KNearest(EMPoint(lon, lat), 8, hits);	// sorted by distance
+
+		for (const auto& hit : hits)
+			index.StationAt(hit.index)->PrintToStream();
+
+	The index refers to stations by their position in the list given to
+	Build().  It is read-only after Build(), so any number of threads may
+	query it concurrently.
+*/
+
+struct EMStationHit {
+	int32				index;
+	float				distance;	// km
+};
+
+
+class	EMStationIndex {
+public:
+								EMStationIndex(float bandDegrees = 2.0);
+	virtual						~EMStationIndex();
+
+			void				Build		(const std::vector<Station*>&);
+			void				Build		(const std::vector<EMPoint>&);
+
+			int32				Count		() const;
+			Station*			StationAt	(int32) const;
+			EMPoint				PointAt		(int32) const;
+
+			// Clears `out` and fills it with every entry within `km` of
+			// the point, in no particular order.  Returns the hit count.
+			int32				Radius		(const EMPoint&, float km,
+											std::vector<EMStationHit>& out,
+											int32 exclude = -1) const;
+
+			// The `k` closest entries, sorted nearest first.
+			int32				KNearest	(const EMPoint&, int32 k,
+											std::vector<EMStationHit>& out,
+											int32 exclude = -1) const;
+
+private:
+			void				_Bucket		(const std::vector<EMPoint>&);
+			void				_Gather		(const EMPoint&, double theta,
+											std::vector<EMStationHit>&,
+											int32 exclude) const;
+	static	float				_ChordToKm	(float chordSq);
+			int32				_BandFor	(float lat) const;
+
+		float					fBandDegrees;
+		int32					fBandCount;
+
+		// per band: first bucket and bucket count
+		std::vector<int32>		fBandStart;
+		std::vector<int32>		fBandBuckets;
+
+		// per bucket: first entry, entries sorted by bucket
+		std::vector<int32>		fBucketStart;
+
+		EMUnitVectors			fUnit;		// entries sorted by bucket
+		std::vector<int32>		fIndex;
+
+		std::vector<EMPoint>	fPoints;
+		std::vector<Station*>	fStations;
+};
+
+
+#endif // EM_STATION_INDEX_H
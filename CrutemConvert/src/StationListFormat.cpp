@@ -1,5 +1,6 @@
 #include "StationListFormat.h"
 
+#include <algorithm>
 #include <string>
 #include <stdio.h>
 
@@ -11,10 +12,67 @@
 YearData	::	YearData()
 	:
 	VALID(false),
-	AVG(0)
+	AVG(0),
+	INFILLED(0)
 {	}
 
 
+float
+YearData	::	MonthValue	(int16 month) const
+{
+	switch (month) {
+		case 1: return JAN;
+		case 2: return FEB;
+		case 3: return MAR;
+		case 4: return APR;
+		case 5: return MAY;
+		case 6: return JUN;
+		case 7: return JUL;
+		case 8: return AUG;
+		case 9: return SEP;
+		case 10: return OCT;
+		case 11: return NOV;
+		case 12: return DEC;
+	}
+	return -99.9;
+}
+
+
+void
+YearData	::	SetMonthValue(int16 month, float value)
+{
+	switch (month) {
+		case 1: JAN = value; break;
+		case 2: FEB = value; break;
+		case 3: MAR = value; break;
+		case 4: APR = value; break;
+		case 5: MAY = value; break;
+		case 6: JUN = value; break;
+		case 7: JUL = value; break;
+		case 8: AUG = value; break;
+		case 9: SEP = value; break;
+		case 10: OCT = value; break;
+		case 11: NOV = value; break;
+		case 12: DEC = value; break;
+	}
+}
+
+
+bool
+YearData	::	IsInfilled	(int16 month) const
+{
+	return month >= 1 && month <= 12 && (INFILLED & (1 << (month - 1))) != 0;
+}
+
+
+void
+YearData	::	SetInfilled	(int16 month)
+{
+	if (month >= 1 && month <= 12)
+		INFILLED |= 1 << (month - 1);
+}
+
+
 //#pragma mark Station
 
 
@@ -172,6 +230,13 @@ Station	::	AverageFor	(EMDate from, EMDate to, bool ignoreDays)
 
 	// This will call our sister function and accumulate the results.
 
+	// Whole months come straight from the prefix sums instead; a date
+	// without a month starts at January.
+	if (ignoreDays && from.IsYearValid() && to.IsYearValid())
+		return _RangeAverage(
+			EMMonthIndex(from.Year(), from.IsMonthValid() ? from.Month() : 1),
+			EMMonthIndex(to.Year(), to.IsMonthValid() ? to.Month() : 1));
+
 	EMDate scanResolution = 1_month;
 
 	if (!ignoreDays)
@@ -208,6 +273,96 @@ Station	::	AverageFor	(EMDate from, EMDate to, bool ignoreDays)
 }
 
 
+float
+Station	::	MonthValue	(EMMonthIndex month) const
+{	// -99.9 when missing
+	int32 year = month.Year();
+	if (!month.IsValid() || DATA == nullptr
+		|| year < STARTYEAR || year >= ENDYEAR)
+		return -99.9;
+
+	const YearData& yd = DATA[year - STARTYEAR];
+	if (!yd.VALID)
+		return -99.9;
+
+	return yd.MonthValue(month.Month());
+}
+
+
+EMTemperature
+Station	::	AverageFor	(EMMonthIndex month)
+{
+	float temp = MonthValue(month);
+	if (temp < -99.0)
+		return 0.0_kelvin;
+
+	return _celsius(temp);
+}
+
+
+EMTemperature
+Station	::	AverageFor	(EMMonthIndex from, EMMonthIndex to)
+{
+	return _RangeAverage(from, to);
+}
+
+
+void
+Station	::	PrepareRanges() const
+{
+	if (!fPrefixCount.empty())
+		return;
+
+	int32 months = (ENDYEAR - STARTYEAR) * 12;
+	if (months < 0 || DATA == nullptr)
+		months = 0;
+
+	fPrefixSum.assign(months + 1, 0.0);
+	fPrefixCount.assign(months + 1, 0);
+
+	for (int32 m = 0; m < months; ++m) {
+		const YearData& yd = DATA[m / 12];
+		float value = yd.VALID ? yd.MonthValue(m % 12 + 1) : -99.9;
+		bool valid = value > -99.0;
+
+		fPrefixSum[m + 1] = fPrefixSum[m] + (valid ? value : 0.0);
+		fPrefixCount[m + 1] = fPrefixCount[m] + (valid ? 1 : 0);
+	}
+}
+
+
+void
+Station	::	InvalidateRanges()
+{
+	fPrefixSum.clear();
+	fPrefixCount.clear();
+}
+
+
+//#pragma mark private
+
+
+EMTemperature
+Station	::	_RangeAverage(EMMonthIndex from, EMMonthIndex to) const
+{	// mean of the valid months in [from, to)
+	PrepareRanges();
+
+	int32	first = EMMonthIndex(STARTYEAR, 1).Value(),
+			last = first + (int32)fPrefixCount.size() - 1,
+			begin = std::max<int32>(from.Value(), first) - first,
+			end = std::min<int32>(to.Value(), last) - first;
+
+	if (!from.IsValid() || !to.IsValid() || end <= begin)
+		return 0.0_kelvin;
+
+	int32 count = fPrefixCount[end] - fPrefixCount[begin];
+	if (count == 0)
+		return 0.0_kelvin;
+
+	return _celsius((fPrefixSum[end] - fPrefixSum[begin]) / count);
+}
+
+
 // #pragma mark StationListHeader
 
 StationListHeader	::	StationListHeader()
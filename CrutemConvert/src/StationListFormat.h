@@ -3,12 +3,14 @@
 
 #include <future>
 #include <string>
+#include <vector>
 
 using namespace std;
 
 #include "StdTypedefs.h"
 #include "Temperature.h"
 #include "Date.h"
+#include "DateIndex.h"
 
 /*
 	These represent an intermediate step before the complete
@@ -22,6 +24,20 @@ using namespace std;
 	LEM will, however, be able to read this format and convert it to its
 	own, very complex, non-deterministic format, so we have to keep that
 	in mind here.
+
+	Range averages over whole months (AverageFor(EMMonthIndex, EMMonthIndex),
+	and AverageFor(EMDate, EMDate) with days ignored) are answered from
+	prefix sums of the station's monthly values and valid-month counts,
+	so any range costs the same.  The sums are built by the first range
+	query; that first build is not thread safe, so call PrepareRanges()
+	before querying one station from several threads, and
+	InvalidateRanges() after changing DATA.
+
+	Such a range is the mean of the measured months in [from, to): the
+	first year counts, years not VALID don't, months outside the station's
+	years aren't filled in from AVERAGES, and a range with none of them is
+	invalid.  Averaging AverageFor(EMDate) month by month, as the range did
+	once, differs on each of those.
 */
 
 struct YearData {
@@ -40,7 +56,14 @@ struct YearData {
 						NOV,
 						DEC,
 						AVG;
+	uint16				INFILLED;	// bit (month - 1), by EMInfill::Store()
 	YearData();
+
+			float				MonthValue	(int16 month) const;	// 1 - 12
+			void				SetMonthValue(int16 month, float);
+
+			bool				IsInfilled	(int16 month) const;	// 1 - 12
+			void				SetInfilled	(int16 month);
 };
 
 
@@ -70,7 +93,23 @@ public:
 			EMTemperature		AverageFor	(EMDate, bool ignoreDay = true);
 			EMTemperature		AverageFor	(EMDate, EMDate, bool = true);
 
+			// Monthly values by packed index; the range is [from, to).
+			float				MonthValue	(EMMonthIndex) const;
+			EMTemperature		AverageFor	(EMMonthIndex);
+			EMTemperature		AverageFor	(EMMonthIndex from,
+											EMMonthIndex to);
+
+			void				PrepareRanges() const;
+			void				InvalidateRanges();
+
 			void				for_each	(function<void(YearData&)>);
+
+private:
+			EMTemperature		_RangeAverage(EMMonthIndex from,
+											EMMonthIndex to) const;
+
+	mutable	vector<double>		fPrefixSum;		// months + 1 each
+	mutable	vector<int32>		fPrefixCount;
 };
 
 
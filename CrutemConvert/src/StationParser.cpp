@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "StationParser.h"
+#include "Stats.h"
+
+
+LStringList&	Split(const std::string& str, char delim, LStringList& out) {
+	using namespace std;
+	stringstream strstr(str);
+	string token;
+	while (getline(strstr, token, delim)) {
+		if (token.size() > 0)
+			out.push_back(token);
+	}
+
+	return out;
+}
+
+
+std::string	ParseFile(const char* path, LStringList& output)
+{
+	using namespace std;
+	EMPhaseTimer timer("read");
+	printf("Parsing %s: ", path);
+	fflush(stdout);
+
+	ifstream file(path);
+	if (file.fail()) {
+		printf("failed! FILE ERROR\n");
+		return "file error";
+	}
+
+	output.clear();		// start with an empty list
+	string line;
+	int64 bytes = 0, lines = 0;
+	while (getline(file, line)) {
+		bytes += line.size() + 1;
+		++lines;
+		if (line != "")
+			output.push_back(line);
+	}
+
+	LStatsAdd(STAT_BYTES_READ, bytes);
+	LStatsAdd(STAT_LINES_READ, lines);
+
+	printf("complete (%li lines)\n", output.size());
+	return "";
+}
+
+
+std::string	ParseStation(const LString& header, const LStringList& data,
+						Station& output, int32& dataIndex)
+{
+	using namespace std;
+	LStringList split;
+	Split(header, ' ', split);
+
+	LString stationID = split[0];
+	for (int32 i = dataIndex; i < data.size(); ++i) {
+		if (data[i].find(stationID.c_str()) != std::string::npos) {
+			dataIndex = i;	// so we don't keep scanning the whole document...
+			/*
+				data holds the lines of the actual data, which begins with
+				the station header.  We have identified that the header is ours
+				and it is data[i].
+				This means the next lines which begin with a year (four char #)
+				is our year data.
+
+				We need to extract, from our header, our start and end year,
+				which is held as a 8 char string in index 6 of our header, except
+				when the station name or nation has spaces!!
+
+				The easy solution is to go from the right..., and back off 4
+			*/
+			int32 pos = split.size() - 4;
+			LString tmp1 = split[pos].c_str(),
+					tmp2;
+
+			tmp2 = tmp1.substr(4, 4);
+			tmp1.resize(4);
+
+			output.STARTYEAR = atoi(tmp1.c_str());
+			output.ENDYEAR = atoi(tmp2.c_str());
+
+			int32 yearCount = output.ENDYEAR - output.STARTYEAR;
+			if (yearCount > 400
+				|| yearCount <= 0)
+				return "Bad year count for station";
+
+			output.ID = atoi(stationID.c_str());
+			output.LAT = atof(split[1].c_str())/10.0;
+			output.LON = -1 * (atof(split[2].c_str())/10.0);
+			output.ELEV = atoi(split[3].c_str());
+
+
+			// strings between 4 and pos are the station name and the nation
+			// The formatting doesn't provide any clues, but it seems most nations
+			// in the list don't contain spaces, so we'll work with that since...
+			// Names don't matter anyway...
+			tmp1 = split[4];
+
+			//output.NAME = split[4];
+			for (int32 j = 5; j < pos -1 ; ++j) {
+				tmp1 += string(" ");
+				tmp1 += split[j].c_str();
+			}
+
+			tmp1.erase(std::remove(tmp1.begin(), tmp1.end(), '-'), tmp1.end());
+			int32 lastIndex = tmp1.size();
+			if (lastIndex > 126)
+				lastIndex = 126;
+
+			for (int32 j = 0; j != lastIndex; ++j)
+				output.NAME[j] = tmp1[j];
+
+			output.NAME[lastIndex] = '\0';
+
+			tmp1 = split[pos-1];
+			tmp1.erase(std::remove(tmp1.begin(), tmp1.end(), '-'), tmp1.end());
+
+			lastIndex = tmp1.size();
+			if (lastIndex > 62)
+				lastIndex = 62;
+
+			for (int32 j = 0; j != lastIndex; ++j)
+				output.COUNTRY[j] = tmp1[j];
+
+			output.COUNTRY[lastIndex] = '\0';
+
+			/*
+				FINALLY!  On to the actual data!
+			*/
+
+			output.DATA = new YearData[yearCount];
+
+			pos = 1;
+			int32 yearIndex = 0;
+			LStringList splitYear;
+			for (int32 year = output.STARTYEAR; year < output.ENDYEAR; ++year) {
+				// data[i] holds the header data
+				// i + pos is the next string for the next year
+				splitYear.clear();
+
+				tmp1.clear();
+				tmp1 = ::to_string(year);
+				Split(data[i + pos], ' ', splitYear);
+
+				if (tmp1 != splitYear[0].c_str()) {
+					printf("\n\nERROR! %s != %s\n\n",
+						tmp1.c_str(),
+						splitYear[0].c_str());
+						snooze(1300000);	// to make the error stand out!!
+				} else {
+					// Success!
+					// Each year has the following format:
+
+					//   0   1   2   3   4   5   6   7   8   9   10  11  12  13
+					// YEAR JAN FEB MAR APR MAY JUN JUL AUG SEP OCT NOV DEC AVG
+					YearData& yd = output.DATA[yearIndex];
+
+					yd.YEAR = year;
+					yd.JAN = atof(splitYear[1].c_str()) / 10.0;
+					yd.FEB = atof(splitYear[2].c_str()) / 10.0;
+					yd.MAR = atof(splitYear[3].c_str()) / 10.0;
+					yd.APR = atof(splitYear[4].c_str()) / 10.0;
+					yd.MAY = atof(splitYear[5].c_str()) / 10.0;
+					yd.JUN = atof(splitYear[6].c_str()) / 10.0;
+					yd.JUL = atof(splitYear[7].c_str()) / 10.0;
+					yd.AUG = atof(splitYear[8].c_str()) / 10.0;
+					yd.SEP = atof(splitYear[9].c_str()) / 10.0;
+					yd.OCT = atof(splitYear[10].c_str()) / 10.0;
+					yd.NOV = atof(splitYear[11].c_str()) / 10.0;
+					yd.DEC = atof(splitYear[12].c_str()) / 10.0;
+					yd.AVG = 0;
+
+					yd.VALID = true;
+				}
+
+				++yearIndex;
+				++pos;
+			}
+
+			return "";
+		}// found station ID
+	} // end data loop
+
+	// fall-through is failure
+	return "Unable to find data for station";
+}
@@ -0,0 +1,34 @@
+#ifndef EM_STATION_PARSER_H
+#define EM_STATION_PARSER_H
+
+#include <string>
+
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+
+/*
+	Reading the CRUTEM station files.
+
+	ParseFile() reads a file into its non-empty lines.  ParseStation() takes
+	one header line, such as:
+
+		"10010 709   87   10 Jan Mayen   NORWAY   19212011  541921    1  287"
+
+	finds the station's block in the data lines, from dataIndex on, and
+	fills in the station and its yearly data.  dataIndex is left on the
+	block found, so going through the header in order scans the data once.
+
+	Both return an empty string on success, or what went wrong.  Split()
+	leaves out empty tokens, so runs of the delimiter count as one.
+*/
+
+
+LStringList&	Split		(const std::string& str, char delim,
+							LStringList& out);
+
+std::string		ParseFile	(const char* path, LStringList& output);
+std::string		ParseStation(const LString& header, const LStringList& data,
+							Station& output, int32& dataIndex);
+
+
+#endif // EM_STATION_PARSER_H
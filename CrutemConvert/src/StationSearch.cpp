@@ -0,0 +1,273 @@
+#include <algorithm>
+#include <ctype.h>
+#include <iterator>
+
+#include "Parallel.h"
+
+#include "StationSearch.h"
+
+
+bool
+EMStationSearch::_Key	::	operator <	(const _Key& other) const
+{
+	int compare = text.compare(other.text);
+	return compare < 0 || (compare == 0 && station < other.station);
+}
+
+
+EMStationSearch	::	EMStationSearch()
+{
+}
+
+
+EMStationSearch	::	~EMStationSearch()
+{
+}
+
+
+void
+EMStationSearch	::	Build	(const std::vector<Station*>& stations)
+{
+	fStations = stations;
+	fIDs.clear();
+	fWords.clear();
+
+	const int32 count = fStations.size();
+	std::vector<std::pair<uint32_t, int32> > trigrams;
+	std::vector<uint32_t> scratch;
+	fTrigramCount.assign(count, 0);
+
+	for (int32 i = 0; i < count; ++i) {
+		const Station& station = *fStations[i];
+
+		_Key id = { to_string(station.ID), i };
+		fIDs.push_back(id);
+
+		std::string name = Normalize(station.NAME);
+		std::vector<std::string> words;
+		std::string text = name + " " + Normalize(station.COUNTRY);
+		for (size_t start = 0; start < text.size(); ) {
+			size_t end = text.find(' ', start);
+			if (end == std::string::npos)
+				end = text.size();
+			if (end > start)
+				words.push_back(text.substr(start, end - start));
+			start = end + 1;
+		}
+
+		std::sort(words.begin(), words.end());
+		words.erase(std::unique(words.begin(), words.end()), words.end());
+		for (const auto& word : words) {
+			_Key key = { word, i };
+			fWords.push_back(key);
+		}
+
+		_Trigrams(name, scratch);
+		fTrigramCount[i] = scratch.size();
+		for (uint32_t trigram : scratch)
+			trigrams.push_back(std::make_pair(trigram, i));
+	}
+
+	std::sort(fIDs.begin(), fIDs.end());
+	std::sort(fWords.begin(), fWords.end());
+	std::sort(trigrams.begin(), trigrams.end());
+
+	fTrigrams.clear();
+	fPostingStart.clear();
+	fPostings.resize(trigrams.size());
+	for (size_t i = 0; i < trigrams.size(); ++i) {
+		if (i == 0 || trigrams[i].first != trigrams[i - 1].first) {
+			fTrigrams.push_back(trigrams[i].first);
+			fPostingStart.push_back(i);
+		}
+		fPostings[i] = trigrams[i].second;
+	}
+	fPostingStart.push_back(trigrams.size());
+}
+
+
+int32
+EMStationSearch	::	StationCount() const
+{
+	return fStations.size();
+}
+
+
+Station*
+EMStationSearch	::	StationAt	(int32 index) const
+{
+	return fStations.at(index);
+}
+
+
+int32
+EMStationSearch	::	Find	(const std::string& query,
+								std::vector<int32>& out, bool fuzzy,
+								int32 maxResults) const
+{
+	out.clear();
+
+	std::string normalized = Normalize(query.c_str());
+	if (normalized.empty())
+		return 0;
+
+	bool digits = true;
+	for (char c : normalized)
+		digits &= isdigit((unsigned char)c) != 0;
+
+	if (digits)
+		_Prefix(fIDs, normalized, out);
+	else {
+		// every word must start one of the station's words
+		std::vector<int32> matches, both;
+		size_t start = 0;
+		bool first = true;
+
+		while (start < normalized.size()) {
+			size_t end = normalized.find(' ', start);
+			if (end == std::string::npos)
+				end = normalized.size();
+
+			_Prefix(fWords, normalized.substr(start, end - start), matches);
+			if (first)
+				out.swap(matches);
+			else {
+				both.clear();
+				std::set_intersection(out.begin(), out.end(), matches.begin(),
+					matches.end(), std::back_inserter(both));
+				out.swap(both);
+			}
+
+			first = false;
+			start = end + 1;
+		}
+	}
+
+	if (out.empty() && fuzzy)
+		return _Fuzzy(normalized, out, maxResults);
+
+	if ((int32)out.size() > maxResults)
+		out.resize(maxResults);
+
+	return out.size();
+}
+
+
+void
+EMStationSearch	::	FindAll	(const std::vector<std::string>& queries,
+								std::vector<std::vector<int32> >& out,
+								bool fuzzy, int32 maxResults) const
+{
+	out.resize(queries.size());
+
+	LParallelFor(queries.size(), [&](int32 begin, int32 end, int32) {
+		for (int32 i = begin; i < end; ++i)
+			Find(queries[i], out[i], fuzzy, maxResults);
+	});
+}
+
+
+std::string
+EMStationSearch	::	Normalize	(const char* text)
+{	// lower case letters and digits, single spaces between words
+	std::string out;
+	bool space = false;
+
+	for (; *text != 0; ++text) {
+		unsigned char c = *text;
+		if (!isalnum(c)) {
+			space = !out.empty();
+			continue;
+		}
+
+		if (space)
+			out += ' ';
+		out += tolower(c);
+		space = false;
+	}
+
+	return out;
+}
+
+
+//#pragma mark private
+
+
+void
+EMStationSearch	::	_Prefix	(const std::vector<_Key>& keys,
+								const std::string& prefix,
+								std::vector<int32>& out) const
+{	// the stations of every key starting with prefix, sorted, once each
+	out.clear();
+
+	_Key start = { prefix, -1 };
+	for (auto key = std::lower_bound(keys.begin(), keys.end(), start);
+		key != keys.end() && key->text.compare(0, prefix.size(), prefix) == 0;
+		++key)
+		out.push_back(key->station);
+
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
+
+
+int32
+EMStationSearch	::	_Fuzzy	(const std::string& normalized,
+								std::vector<int32>& out,
+								int32 maxResults) const
+{
+	std::vector<uint32_t> query;
+	_Trigrams(normalized, query);
+	if (query.empty())
+		return 0;
+
+	// shared trigrams, for the stations which have any
+	std::vector<int32> shared(fStations.size(), 0), touched;
+	for (uint32_t trigram : query) {
+		auto found = std::lower_bound(fTrigrams.begin(), fTrigrams.end(),
+			trigram);
+		if (found == fTrigrams.end() || *found != trigram)
+			continue;
+
+		int32 t = found - fTrigrams.begin();
+		for (int32 p = fPostingStart[t]; p < fPostingStart[t + 1]; ++p) {
+			if (shared[fPostings[p]]++ == 0)
+				touched.push_back(fPostings[p]);
+		}
+	}
+
+	std::vector<std::pair<float, int32> > scored;
+	for (int32 station : touched) {
+		float score = 2.0f * shared[station]
+			/ (query.size() + fTrigramCount[station]);
+		if (score >= SEARCH_FUZZY_MIN_SCORE)
+			scored.push_back(std::make_pair(-score, station));
+	}
+
+	std::sort(scored.begin(), scored.end());
+	for (const auto& entry : scored) {
+		if ((int32)out.size() == maxResults)
+			break;
+		out.push_back(entry.second);
+	}
+
+	return out.size();
+}
+
+
+void
+EMStationSearch	::	_Trigrams	(const std::string& normalized,
+									std::vector<uint32_t>& out)
+{	// with a space either side, so the ends of words count too
+	out.clear();
+
+	std::string padded = " " + normalized + " ";
+	for (size_t i = 0; i + 3 <= padded.size(); ++i) {
+		out.push_back((uint32_t)(unsigned char)padded[i] << 16
+			| (uint32_t)(unsigned char)padded[i + 1] << 8
+			| (unsigned char)padded[i + 2]);
+	}
+
+	std::sort(out.begin(), out.end());
+	out.erase(std::unique(out.begin(), out.end()), out.end());
+}
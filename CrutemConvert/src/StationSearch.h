@@ -0,0 +1,104 @@
+#ifndef EM_STATION_SEARCH_H
+#define EM_STATION_SEARCH_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "StationListFormat.h"
+#include "StdTypedefs.h"
+
+/*
+	Finds stations by ID, name or country without going through every
+	station's NAME and COUNTRY.
+
+	Names and countries are normalized once - folded to lower case, with
+	anything but letters and digits treated as a space - and split into
+	words.  Build() sorts every word, and every station's ID as digits,
+	together with the station it came from, so a lookup is a binary search
+	and a walk over the matches:
+
+		digits			stations whose ID starts with them
+		words			stations with, for each word given, a name or
+						country word starting with it: "jan may",
+						"mayen", "norway" all find Jan Mayen
+
+	With fuzzy matching on, a query finding nothing is tried again by
+	trigrams: each name's three letter runs are kept in posting lists, and
+	the stations sharing the most with the query (at least
+	SEARCH_FUZZY_MIN_SCORE of them, Dice coefficient) come back best
+	first.  This catches misspellings - "jan meyen".
+
+		EMStationSearch search;
+		search.Build(StationList);
+
+		std::vector<int32> found;
+		search.Find("mayen", found);	// indices into StationList
+
+	Find() keeps no state between calls, so any number of threads can
+	search at once; FindAll() answers a batch of queries in parallel.
+*/
+
+#define	SEARCH_FUZZY_MIN_SCORE	0.5
+#define	SEARCH_MAX_RESULTS		1000
+
+
+class	EMStationSearch {
+public:
+								EMStationSearch();
+	virtual						~EMStationSearch();
+
+			void				Build		(const std::vector<Station*>&);
+
+			int32				StationCount() const;
+			Station*			StationAt	(int32 index) const;
+
+			// Station indices, in list order (best first when fuzzy).
+			// Returns how many were found.
+			int32				Find		(const std::string& query,
+											std::vector<int32>& out,
+											bool fuzzy = false,
+											int32 maxResults
+												= SEARCH_MAX_RESULTS) const;
+			void				FindAll		(
+									const std::vector<std::string>& queries,
+									std::vector<std::vector<int32> >& out,
+									bool fuzzy = false,
+									int32 maxResults
+										= SEARCH_MAX_RESULTS) const;
+
+	static	std::string			Normalize	(const char* text);
+
+private:
+		struct _Key {
+			std::string			text;
+			int32				station;
+
+			bool				operator <	(const _Key& other) const;
+		};
+
+			void				_Prefix		(const std::vector<_Key>&,
+											const std::string& prefix,
+											std::vector<int32>& out) const;
+			int32				_Fuzzy		(const std::string& normalized,
+											std::vector<int32>& out,
+											int32 maxResults) const;
+
+	static	void				_Trigrams	(const std::string& normalized,
+											std::vector<uint32_t>& out);
+
+		std::vector<Station*>	fStations;
+
+		std::vector<_Key>		fIDs;
+		std::vector<_Key>		fWords;
+
+		// trigram -> stations, as sorted trigrams and offsets into one
+		// array of station indices
+		std::vector<uint32_t>	fTrigrams;
+		std::vector<int32>		fPostingStart;	// trigrams + 1
+		std::vector<int32>		fPostings;
+		std::vector<int32>		fTrigramCount;	// per station
+};
+
+
+#endif // EM_STATION_SEARCH_H
@@ -0,0 +1,284 @@
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "OutputWriter.h"
+
+#include "Stats.h"
+
+
+static const char* kCounterNames[STAT_COUNTER_COUNT] = {
+	"bytes read", "lines read", "stations parsed", "stations rejected",
+	"stations ignored", "values", "values missing"
+};
+
+static const char* kCounterKeys[STAT_COUNTER_COUNT] = {
+	"bytesRead", "linesRead", "stationsParsed", "stationsRejected",
+	"stationsIgnored", "values", "valuesMissing"
+};
+
+
+struct _Phase {
+	std::string		name;
+	double			wall;
+	double			cpu;
+	int64			calls;
+};
+
+
+static std::atomic<bool>	sEnabled(false);
+static std::atomic<int64>	sCounters[STAT_COUNTER_COUNT];
+static std::atomic<int64>	sThreadNanos[STATS_MAX_THREADS];
+
+static std::mutex			sLock;		// for everything below
+static std::vector<_Phase>	sPhases;
+static std::vector<std::pair<std::string, std::string> >	sNotes;
+static std::chrono::steady_clock::time_point	sStart;
+static double				sCPUStart = 0;
+
+
+static double
+_CPUTime()
+{	// the whole process's, all threads
+	return std::clock() / (double)CLOCKS_PER_SEC;
+}
+
+
+static double
+_Elapsed()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now()
+		- sStart).count();
+}
+
+
+static void
+_String(EMOutputWriter& out, const std::string& text)
+{
+	out.Write('"');
+	for (unsigned char c : text) {
+		if (c == '"' || c == '\\') {
+			out.Write('\\').Write((char)c);
+		} else if (c < 0x20) {
+			char escape[8];
+			snprintf(escape, sizeof(escape), "\\u%04x", c);
+			out.Write(escape);
+		} else
+			out.Write((char)c);
+	}
+	out.Write('"');
+}
+
+
+void	LStatsEnable(bool enable)
+{
+	std::lock_guard<std::mutex> lock(sLock);
+
+	if (enable && !sEnabled) {
+		sStart = std::chrono::steady_clock::now();
+		sCPUStart = _CPUTime();
+
+		char started[32];
+		time_t now = time(NULL);
+		struct tm utc;
+		gmtime_r(&now, &utc);
+		strftime(started, sizeof(started), "%Y-%m-%dT%H:%M:%SZ", &utc);
+		sNotes.push_back(std::make_pair("started", std::string(started)));
+	}
+
+	sEnabled = enable;
+}
+
+
+bool	LStatsEnabled()
+{
+	return sEnabled.load(std::memory_order_relaxed);
+}
+
+
+void	LStatsAdd(EMStatCounter counter, int64 amount)
+{
+	if (LStatsEnabled())
+		sCounters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+
+int64	LStatsCounter(EMStatCounter counter)
+{
+	return sCounters[counter].load(std::memory_order_relaxed);
+}
+
+
+void	LStatsAddPhase(const char* name, double wallSeconds, double cpuSeconds)
+{
+	if (!LStatsEnabled())
+		return;
+
+	std::lock_guard<std::mutex> lock(sLock);
+
+	for (auto& phase : sPhases) {
+		if (phase.name == name) {
+			phase.wall += wallSeconds;
+			phase.cpu += cpuSeconds;
+			++phase.calls;
+			return;
+		}
+	}
+
+	if (sPhases.size() < STATS_MAX_PHASES) {
+		_Phase phase = { name, wallSeconds, cpuSeconds, 1 };
+		sPhases.push_back(phase);
+	}
+}
+
+
+void	LStatsAddThreadTime(int32 thread, double seconds)
+{
+	if (LStatsEnabled() && thread >= 0 && thread < STATS_MAX_THREADS) {
+		sThreadNanos[thread].fetch_add(seconds * 1e9,
+			std::memory_order_relaxed);
+	}
+}
+
+
+void	LStatsNote(const std::string& key, const std::string& value)
+{
+	std::lock_guard<std::mutex> lock(sLock);
+	sNotes.push_back(std::make_pair(key, value));
+}
+
+
+void	LStatsPrint()
+{
+	std::lock_guard<std::mutex> lock(sLock);
+
+	double wall = _Elapsed(),
+		cpu = _CPUTime() - sCPUStart,
+		timed = 0;
+
+	printf("Run statistics:\n");
+	printf("\t%-20s %10s %10s %8s %7s\n", "PHASE", "WALL s", "CPU s", "CALLS",
+		"SHARE");
+	for (const auto& phase : sPhases) {
+		printf("\t%-20s %10.3f %10.3f %8lli %6.1f%%\n", phase.name.c_str(),
+			phase.wall, phase.cpu, phase.calls,
+			wall > 0 ? 100 * phase.wall / wall : 0.0);
+		timed += phase.wall;
+	}
+	printf("\t%-20s %10.3f\n", "(not in a phase)", std::max(wall - timed, 0.0));
+	printf("\t%-20s %10.3f %10.3f\n\n", "total", wall, cpu);
+
+	printf("\t%-20s %21s\n", "COUNTER", "VALUE");
+	for (int32 i = 0; i < STAT_COUNTER_COUNT; ++i) {
+		printf("\t%-20s %21lli\n", kCounterNames[i],
+			LStatsCounter((EMStatCounter)i));
+	}
+
+	bool header = false;
+	for (int32 i = 0; i < STATS_MAX_THREADS; ++i) {
+		int64 nanos = sThreadNanos[i].load(std::memory_order_relaxed);
+		if (nanos == 0)
+			continue;
+
+		if (!header) {
+			printf("\n\t%-20s %10s\n", "THREAD", "BUSY s");
+			header = true;
+		}
+		printf("\t%-20li %10.3f\n", i, nanos / 1e9);
+	}
+}
+
+
+bool	LStatsWriteJSON(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(sLock);
+
+	EMOutputWriter file;
+	if (!file.Open(path))
+		return false;
+
+	file.Write("{\n");
+	file.Write("\t\"version\": ").WriteInt(STATS_JSON_VERSION).Write(",\n");
+
+	file.Write("\t\"run\": {");
+	for (size_t i = 0; i < sNotes.size(); ++i) {
+		file.Write(i == 0 ? "\n\t\t" : ",\n\t\t");
+		_String(file, sNotes[i].first);
+		file.Write(": ");
+		_String(file, sNotes[i].second);
+	}
+	file.Write("\n\t},\n");
+
+	file.Write("\t\"wall\": ").WriteFixed(_Elapsed(), 6).Write(",\n");
+	file.Write("\t\"cpu\": ").WriteFixed(_CPUTime() - sCPUStart, 6)
+		.Write(",\n");
+
+	file.Write("\t\"phases\": [");
+	for (size_t i = 0; i < sPhases.size(); ++i) {
+		file.Write(i == 0 ? "\n\t\t{ \"name\": " : ",\n\t\t{ \"name\": ");
+		_String(file, sPhases[i].name);
+		file.Write(", \"wall\": ").WriteFixed(sPhases[i].wall, 6)
+			.Write(", \"cpu\": ").WriteFixed(sPhases[i].cpu, 6)
+			.Write(", \"calls\": ").WriteInt(sPhases[i].calls).Write(" }");
+	}
+	file.Write("\n\t],\n");
+
+	file.Write("\t\"counters\": {");
+	for (int32 i = 0; i < STAT_COUNTER_COUNT; ++i) {
+		file.Write(i == 0 ? "\n\t\t\"" : ",\n\t\t\"").Write(kCounterKeys[i])
+			.Write("\": ").WriteInt(LStatsCounter((EMStatCounter)i));
+	}
+	file.Write("\n\t},\n");
+
+	// busy seconds per worker slot, up to the last one used
+	int32 used = 0;
+	for (int32 i = 0; i < STATS_MAX_THREADS; ++i) {
+		if (sThreadNanos[i].load(std::memory_order_relaxed) != 0)
+			used = i + 1;
+	}
+
+	file.Write("\t\"threads\": [");
+	for (int32 i = 0; i < used; ++i) {
+		file.Write(i == 0 ? "" : ", ").WriteFixed(
+			sThreadNanos[i].load(std::memory_order_relaxed) / 1e9, 6);
+	}
+	file.Write("]\n");
+	file.Write("}\n");
+
+	return file.Close();
+}
+
+
+EMPhaseTimer	::	EMPhaseTimer(const char* name)
+	:
+	fName(name),
+	fRunning(LStatsEnabled()),
+	fCPUStart(0)
+{
+	if (fRunning) {
+		fStart = _Clock::now();
+		fCPUStart = _CPUTime();
+	}
+}
+
+
+EMPhaseTimer	::	~EMPhaseTimer()
+{
+	Stop();
+}
+
+
+void
+EMPhaseTimer	::	Stop()
+{
+	if (!fRunning)
+		return;
+
+	fRunning = false;
+	LStatsAddPhase(fName, std::chrono::duration<double>(_Clock::now()
+		- fStart).count(), _CPUTime() - fCPUStart);
+}
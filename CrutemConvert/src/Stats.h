@@ -0,0 +1,91 @@
+#ifndef L_STATS_H
+#define L_STATS_H
+
+#include <chrono>
+#include <string>
+
+#include "StdTypedefs.h"
+
+/*
+	Where a run's time goes, for -stats.
+
+	Phases are timed by scope, or up to Stop().  Entering a phase again adds
+	to its total:
+
+		{
+			EMPhaseTimer timer("read");
+			ParseFile(path, lines);
+		}
+
+	Each phase keeps its wall time, the process CPU time spent in it (more
+	than the wall time where LParallelFor() had threads working) and how
+	often it was entered.  Phases are reported in the order first entered.
+
+	Counters are added to in bulk - per file, per station - never per
+	value:
+
+		LStatsAdd(STAT_STATIONS_PARSED);
+
+	LParallelFor() adds the time each worker spent in its chunks to that
+	worker's slot, so uneven splitting shows up as uneven thread times.
+
+	Nothing is kept until LStatsEnable(): timers don't read the clock and
+	the adds return straight away.  LStatsPrint() writes a table to stdout;
+	LStatsWriteJSON() writes the same, plus any LStatsNote()s about the
+	run, for comparing runs against each other.
+*/
+
+enum EMStatCounter {
+	STAT_BYTES_READ = 0,
+	STAT_LINES_READ,
+	STAT_STATIONS_PARSED,
+	STAT_STATIONS_REJECTED,		// found wanting by ParseStation()
+	STAT_STATIONS_IGNORED,		// on the ignore list
+	STAT_VALUES,				// monthly values, missing included
+	STAT_VALUES_MISSING,
+
+	STAT_COUNTER_COUNT
+};
+
+
+#define	STATS_MAX_THREADS		256
+#define	STATS_MAX_PHASES		64
+#define	STATS_JSON_VERSION		1
+
+
+void	LStatsEnable			(bool enable = true);
+bool	LStatsEnabled			();
+
+void	LStatsAdd				(EMStatCounter, int64 amount = 1);
+int64	LStatsCounter			(EMStatCounter);
+void	LStatsAddPhase			(const char* name, double wallSeconds,
+									double cpuSeconds);
+void	LStatsAddThreadTime		(int32 thread, double seconds);
+
+// "key": "value" pairs describing the run, for the JSON
+void	LStatsNote				(const std::string& key,
+									const std::string& value);
+
+void	LStatsPrint				();
+bool	LStatsWriteJSON			(const std::string& path);
+
+
+class	EMPhaseTimer {
+public:
+	explicit					EMPhaseTimer(const char* name);
+								~EMPhaseTimer();
+
+			// ends the phase before the scope does
+			void				Stop		();
+
+private:
+		typedef std::chrono::steady_clock	_Clock;
+
+		const char*				fName;
+		bool					fRunning;
+		_Clock::time_point		fStart;
+		double					fCPUStart;
+};
+
+
+#endif // L_STATS_H
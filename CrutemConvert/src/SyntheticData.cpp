@@ -0,0 +1,401 @@
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "OutputWriter.h"
+#include "Parallel.h"
+
+#include "SyntheticData.h"
+
+
+#define	SYNTHETIC_BATCH_PER_THREAD	64
+#define	SYNTHETIC_DATA_LINE			65		// "YEAR" + 12 * "%5li" + '\n'
+#define	SYNTHETIC_MISSING			-999
+#define	SYNTHETIC_MAX_VALUE			9999
+#define	SYNTHETIC_FIELDS			(SYNTHETIC_MAX_VALUE - SYNTHETIC_MISSING + 1)
+#define	SYNTHETIC_NOISE				24		// tenths, triangular: sigma 1.0 C
+#define	SYNTHETIC_WAVE_MIN			3.0		// radians per radian: 13000 km
+#define	SYNTHETIC_WAVE_MAX			6.0		// to 6700 km long
+#define	SYNTHETIC_COUNT(array)		(sizeof(array) / sizeof(array[0]))
+
+
+static const char* kSyllables[] = {
+	"KA", "RA", "VEN", "TO", "MIR", "SO", "LA", "BE", "DUN", "O", "RIN", "TA",
+	"HOL", "MA", "KE", "STA", "NOR", "VI", "GRA", "DE", "LU", "PA", "SKO", "E"
+};
+
+static const char* kSuffixes[] = {
+	"BAY", "HILL", "AIRPORT", "NORTH", "SOUTH", "FYR", "CITY", "OBS"
+};
+
+static const char* kCountries[] = {
+	"ORVANIA", "KESTRIA", "DUNMARK", "SOLAND", "MIRAVIA", "TALOR", "HOLMIA",
+	"BEVARIA", "GRANTIS", "LUNESIA", "PARDOR", "SKOVIA", "VIDENIA",
+	"NORMAR", "ESTAVIA", "RINLAND", "KARELIS", "DESOLA", "MAKEVIA", "TOVARI"
+};
+
+
+static inline uint64_t
+_Next(uint64_t& state)
+{	// splitmix64
+	uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+
+static inline double
+_Uniform(uint64_t& state)
+{	// [0, 1)
+	return (_Next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
+static double
+_Normal(uint64_t& state)
+{	// near enough for placing stations: four uniforms, sigma 1
+	double sum = _Uniform(state) + _Uniform(state) + _Uniform(state)
+		+ _Uniform(state);
+	return (sum - 2.0) * 1.7320508075688772;
+}
+
+
+static const char*
+_MonthFields()
+{	// every monthly value there can be, as its "%5li", -999 first
+	static const std::vector<char> fields = [] {
+		std::vector<char> text(SYNTHETIC_FIELDS * 5 + 1);
+		for (int32 i = 0; i < SYNTHETIC_FIELDS; ++i)
+			snprintf(&text[i * 5], 6, "%5li", i + SYNTHETIC_MISSING);
+		return text;
+	}();
+
+	return fields.data();
+}
+
+
+static inline char*
+_Field(char* out, int32 value, int32 width)
+{	// as "%*li" would, without going through printf
+	char digits[12];
+	bool negative = value < 0;
+	uint32_t magnitude = negative ? -value : value;
+	int32 length = 0;
+
+	do {
+		digits[length++] = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude != 0);
+
+	if (negative)
+		digits[length++] = '-';
+
+	for (int32 pad = width - length; pad > 0; --pad)
+		*out++ = ' ';
+	while (length > 0)
+		*out++ = digits[--length];
+
+	return out;
+}
+
+
+EMSyntheticData	::	EMSyntheticData(int32 stations, uint64_t seed)
+	:
+	fStations(std::max((int32)0,
+		std::min(stations, (int32)SYNTHETIC_MAX_STATIONS))),
+	fSeed(seed),
+	fFirstYear(1750),
+	fLastYear(2011),
+	fMinSpan(20),
+	fMaxSpan(160),
+	fMissingRate(0.05),
+	fLayout(SYNTHETIC_UNIFORM)
+{
+}
+
+
+EMSyntheticData	::	~EMSyntheticData()
+{
+}
+
+
+int32
+EMSyntheticData	::	StationCount() const
+{
+	return fStations;
+}
+
+
+void
+EMSyntheticData	::	SetYears	(int32 first, int32 last)
+{
+	if (last - first < 2)
+		return;
+
+	fFirstYear = first;
+	fLastYear = last;
+}
+
+
+void
+EMSyntheticData	::	SetSpan	(int32 minYears, int32 maxYears)
+{	// ParseStation() takes 2 to 400 years
+	fMinSpan = std::max((int32)2, std::min(minYears, (int32)400));
+	fMaxSpan = std::max(fMinSpan, std::min(maxYears, (int32)400));
+}
+
+
+void
+EMSyntheticData	::	SetMissingRate	(double rate)
+{
+	fMissingRate = std::max(0.0, std::min(rate, 1.0));
+}
+
+
+void
+EMSyntheticData	::	SetLayout	(EMSyntheticLayout layout)
+{
+	fLayout = layout;
+	if (layout != SYNTHETIC_CLUSTERED)
+		return;
+
+	// the centres come from the seed too
+	uint64_t random = fSeed ^ 0x5851F42D4C957F2DULL;
+	fCenters.clear();
+	for (int32 i = 0; i < SYNTHETIC_CLUSTERS; ++i) {
+		double lat = asin(2 * _Uniform(random) - 1) * 180 / M_PI,
+			lon = _Uniform(random) * 360 - 180;
+		fCenters.push_back(EMPoint(lon, lat));
+	}
+}
+
+
+void
+EMSyntheticData	::	SetCenters	(const std::vector<EMPoint>& centers)
+{
+	fCenters = centers;
+	fLayout = SYNTHETIC_AROUND;
+}
+
+
+int64
+EMSyntheticData	::	Write	(const std::string& headerPath,
+								const std::string& dataPath) const
+{
+	EMOutputWriter header, data;
+	if (!header.Open(headerPath) || !data.Open(dataPath))
+		return -1;
+
+	std::vector<_Mode> modes;
+	std::vector<float> amplitudes;
+	_Regional(modes, amplitudes);
+
+	// Render a batch of stations in parallel, then write the batch out in
+	// order before starting the next.
+	int32 batch = LThreadCount() * SYNTHETIC_BATCH_PER_THREAD;
+	std::vector<std::string> headers(batch), blocks(batch);
+	int64 written = 0;
+
+	for (int32 first = 0; first < fStations; first += batch) {
+		int32 count = std::min(batch, fStations - first);
+
+		LParallelFor(count, [&](int32 begin, int32 end, int32) {
+			for (int32 i = begin; i < end; ++i)
+				_Render(first + i, modes, amplitudes, headers[i], blocks[i]);
+		}, 1);
+
+		for (int32 i = 0; i < count; ++i) {
+			header.Write(headers[i]);
+			data.Write(blocks[i]);
+			written += headers[i].size() + blocks[i].size();
+		}
+	}
+
+	bool headerClosed = header.Close();
+	return data.Close() && headerClosed ? written : -1;
+}
+
+
+//#pragma mark private
+
+
+void
+EMSyntheticData	::	_Place	(int32 index, uint64_t& random,
+								_Station& station) const
+{
+	station.id = SYNTHETIC_FIRST_ID + index;
+
+	double lat, lon;
+	if (fLayout == SYNTHETIC_UNIFORM || fCenters.empty()) {
+		lat = asin(2 * _Uniform(random) - 1) * 180 / M_PI;
+		lon = _Uniform(random) * 360 - 180;
+	} else {
+		const EMPoint& center = fCenters[_Next(random) % fCenters.size()];
+		double spread = fLayout == SYNTHETIC_CLUSTERED
+			? SYNTHETIC_CLUSTER_SPREAD : SYNTHETIC_AROUND_SPREAD;
+
+		lat = std::max(-89.9, std::min(center.y + spread * _Normal(random),
+			89.9));
+		lon = center.x + spread * _Normal(random)
+			/ std::max(cos(lat * M_PI / 180), 0.1);
+		lon = fmod(fmod(lon + 180, 360) + 360, 360) - 180;
+	}
+
+	station.lat = lround(lat * 10);
+	station.lon = -lround(lon * 10);	// the files count west as positive
+	station.elevation = _Uniform(random) < 0.03 ? -999
+		: std::min(-log(1 - _Uniform(random)) * 400, 4500.0);
+
+	// most end with the data set, some a few years before
+	station.end = fLastYear
+		- (_Uniform(random) < 0.3 ? (int32)(_Next(random) % 4) : 0);
+	station.start = std::max(fFirstYear, station.end + 1 - fMinSpan
+		- (int32)(_Next(random) % (fMaxSpan - fMinSpan + 1)));
+	if (station.end - station.start < 2)
+		station.start = station.end - 2;
+
+	// the next station's ID must not turn up in this one's years
+	char years[24], next[24];
+	snprintf(next, sizeof(next), "%li", station.id + 1);
+	for (;;) {
+		snprintf(years, sizeof(years), "%4li%4li", station.start, station.end);
+		if (strstr(years, next) == NULL)
+			break;
+		station.start += station.end - station.start > 2 ? 1 : -1;
+	}
+
+	// two to four syllables, sometimes a second word; 20 characters at most
+	std::string name;
+	int32 syllables = 2 + _Next(random) % 3;
+	for (int32 i = 0; i < syllables; ++i)
+		name += kSyllables[_Next(random) % SYNTHETIC_COUNT(kSyllables)];
+	if (_Uniform(random) < 0.3) {
+		name += ' ';
+		name += kSuffixes[_Next(random) % SYNTHETIC_COUNT(kSuffixes)];
+	}
+	strcpy(station.name, name.c_str());
+
+	// neighbours share a country, 30 degree squares of them
+	int32 square = (int32)((lat + 90) / 30) * 12 + (int32)((lon + 180) / 30);
+	station.country = kCountries[square % SYNTHETIC_COUNT(kCountries)];
+}
+
+
+void
+EMSyntheticData	::	_Regional	(std::vector<_Mode>& modes,
+									std::vector<float>& amplitudes) const
+{	// from the seed alone, as the cluster centres are
+	uint64_t random = fSeed ^ 0x2545F4914F6CDD1DULL;
+
+	modes.resize(SYNTHETIC_MODES);
+	for (_Mode& mode : modes) {
+		double z = 2 * _Uniform(random) - 1,
+			around = _Uniform(random) * 2 * M_PI,
+			r = sqrt(1 - z * z);
+		mode.x = r * cos(around);
+		mode.y = r * sin(around);
+		mode.z = z;
+		mode.wave = SYNTHETIC_WAVE_MIN
+			+ (SYNTHETIC_WAVE_MAX - SYNTHETIC_WAVE_MIN) * _Uniform(random);
+		mode.phase = _Uniform(random) * 2 * M_PI;
+	}
+
+	// a wave averages 1/2 squared, so the modes together give the sigma
+	double sigma = SYNTHETIC_REGIONAL * sqrt(2.0 / SYNTHETIC_MODES);
+	amplitudes.resize((size_t)(fLastYear - fFirstYear + 1) * 12
+		* SYNTHETIC_MODES);
+	for (float& amplitude : amplitudes)
+		amplitude = sigma * _Normal(random);
+}
+
+
+void
+EMSyntheticData	::	_Render	(int32 index, const std::vector<_Mode>& modes,
+								const std::vector<float>& amplitudes,
+								std::string& header, std::string& data) const
+{
+	uint64_t random = fSeed + (uint64_t)index * 0xD1B54A32D192ED03ULL;
+	_Next(random);
+
+	_Station station;
+	_Place(index, random, station);
+
+	char line[128];
+	int32 length = snprintf(line, sizeof(line),
+		"%7li %3li %4li %4li %-20s %-13s %4li%4li%8li%5li%5li", station.id,
+		station.lat, station.lon, station.elevation, station.name,
+		station.country, station.start, station.end, station.id,
+		index % 10000, (int32)((station.lat + 900) / 50 * 72
+			+ (-station.lon + 1800) / 50) % 10000);
+
+	header.assign(line, length);
+	header += "\r\n";
+
+	// The climate, in tenths: colder towards the poles and with height,
+	// seasons growing with latitude, warming from 1900.  Only the regional
+	// anomaly and the noise change from month to month, the noise in
+	// integers.
+	double sinLat = sin(station.lat * M_PI / 1800),
+		mean = 270 - 450 * sinLat * sinLat
+			- (station.elevation > 0 ? 0.065 * station.elevation : 0),
+		amplitude = 2.0 * fabs(station.lat / 10.0) * (station.lat < 0 ? -1 : 1);
+	int32 season[12];
+	for (int32 month = 0; month < 12; ++month)
+		season[month] = lround(mean - amplitude * cos(month * M_PI / 6));
+
+	// each mode's wave where the station is
+	double	lat = station.lat * M_PI / 1800,
+			lon = -station.lon * M_PI / 1800,
+			weight[SYNTHETIC_MODES];
+	for (int32 k = 0; k < SYNTHETIC_MODES; ++k) {
+		const _Mode& mode = modes[k];
+		double along = cos(lat) * cos(lon) * mode.x
+			+ cos(lat) * sin(lon) * mode.y + sin(lat) * mode.z;
+		weight[k] = cos(mode.wave * along + mode.phase);
+	}
+
+	const uint64_t missing = fMissingRate * (1 << 21);
+	const int32 years = station.end - station.start + 1;
+	const char* fields = _MonthFields();
+
+	data.resize(length + 1 + (size_t)years * SYNTHETIC_DATA_LINE);
+	char* out = &data[0];
+	memcpy(out, line, length);
+	out += length;
+	*out++ = '\n';
+
+	for (int32 year = station.start; year <= station.end; ++year) {
+		int32 offset = lround((year > 1900 ? 0.08 * (year - 1900) : 0)
+			+ 5 * _Normal(random));
+
+		// the start year can be moved to just before fFirstYear
+		const float* shared = year >= fFirstYear
+			? &amplitudes[(size_t)(year - fFirstYear) * 12 * SYNTHETIC_MODES]
+			: NULL;
+
+		out = _Field(out, year, 4);
+		for (int32 month = 0; month < 12; ++month) {
+			// three 21 bit uniforms: two for the noise, one for missing
+			uint64_t bits = _Next(random);
+			int32 value = SYNTHETIC_MISSING;
+			if ((bits & 0x1FFFFF) >= missing) {
+				int64 noise = (int64)((bits >> 21 & 0x1FFFFF)
+					+ (bits >> 42 & 0x1FFFFF)) - (1 << 21);
+				double regional = 0;
+				for (int32 k = 0; shared != NULL && k < SYNTHETIC_MODES; ++k)
+					regional += shared[month * SYNTHETIC_MODES + k] * weight[k];
+
+				value = season[month] + offset + lround(regional)
+					+ (int32)(noise * SYNTHETIC_NOISE / (1 << 21));
+				value = std::max((int32)SYNTHETIC_MISSING + 1,
+					std::min(value, (int32)SYNTHETIC_MAX_VALUE));
+			}
+
+			memcpy(out, fields + (value - SYNTHETIC_MISSING) * 5, 5);
+			out += 5;
+		}
+		*out++ = '\n';
+	}
+}
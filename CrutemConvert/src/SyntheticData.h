@@ -0,0 +1,135 @@
+#ifndef EM_SYNTHETIC_DATA_H
+#define EM_SYNTHETIC_DATA_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "Point.h"
+#include "StdTypedefs.h"
+
+/*
+	Made up station files, in exactly the layout ParseStation() reads, for
+	trying crucon at many times the size of the real data set.
+
+	The header file has a line per station, as CRUTEM's does:
+
+		" 100000 709   87   10 KARAVEN              ORVANIA       19212011 ..."
+
+	and the data file the same line followed by one per year, the year and
+	twelve monthly values in tenths of a degree, -999 where missing.  Each
+	value is a climate for the latitude, season and elevation, a warming
+	trend from 1900, a regional anomaly and noise.  The regional anomaly
+	is SYNTHETIC_MODES waves 7000 to 13000 kilometres long, drawn across
+	the sphere with new amplitudes every month, so neighbours' anomalies
+	correlate as real stations' do and fall away with distance.
+
+	Stations are placed by the layout:
+
+		SYNTHETIC_UNIFORM		evenly over the sphere
+		SYNTHETIC_CLUSTERED		around SYNTHETIC_CLUSTERS random centres
+		SYNTHETIC_AROUND		around the points given to SetCenters(),
+								such as the real stations
+
+	Everything about a station comes from the seed and its index alone, so
+	the files are the same for the same settings on any machine and any
+	number of threads.  Stations are rendered in parallel batches and
+	written in order:
+
+		EMSyntheticData synthetic(480000);
+		synthetic.SetMissingRate(0.1);
+		synthetic.Write("big/header.txt", "big/data.txt");
+
+	IDs run up from SYNTHETIC_FIRST_ID, six digits as the format allows,
+	which caps the station count.  The parser finds a station by searching
+	the data for its ID from the station before, so a start year is moved
+	by one wherever the years would otherwise spell out the next ID.
+*/
+
+enum EMSyntheticLayout {
+	SYNTHETIC_UNIFORM = 0,
+	SYNTHETIC_CLUSTERED,
+	SYNTHETIC_AROUND
+};
+
+
+#define	SYNTHETIC_FIRST_ID			100000
+#define	SYNTHETIC_MAX_STATIONS		899999
+#define	SYNTHETIC_DEFAULT_SEED		20151
+#define	SYNTHETIC_CLUSTERS			250
+#define	SYNTHETIC_CLUSTER_SPREAD	4.0		// degrees, one sigma
+#define	SYNTHETIC_AROUND_SPREAD		0.5
+#define	SYNTHETIC_MODES				8
+#define	SYNTHETIC_REGIONAL			20		// tenths, one sigma of the field
+
+
+class	EMSyntheticData {
+public:
+								EMSyntheticData(int32 stations,
+									uint64_t seed = SYNTHETIC_DEFAULT_SEED);
+	virtual						~EMSyntheticData();
+
+			int32				StationCount() const;
+
+			// Stations end within a few years of `last` and start no
+			// earlier than `first`, covering minYears to maxYears.
+			void				SetYears	(int32 first, int32 last);
+			void				SetSpan		(int32 minYears, int32 maxYears);
+
+			// the chance of any one month being missing, 0 - 1
+			void				SetMissingRate(double);
+
+			void				SetLayout	(EMSyntheticLayout);
+			void				SetCenters	(const std::vector<EMPoint>&);
+
+			// Returns the bytes written, or -1.
+			int64				Write		(const std::string& headerPath,
+											const std::string& dataPath)
+												const;
+
+private:
+		struct _Station {
+			int32				id;
+			int32				lat;		// tenths of a degree
+			int32				lon;		// tenths, west positive
+			int32				elevation;
+			int32				start;
+			int32				end;
+			char				name[21];
+			const char*			country;
+		};
+
+		// the regional field: a plane wave along a unit vector
+		struct _Mode {
+			double				x, y, z;
+			double				wave;		// radians per radian along it
+			double				phase;
+		};
+
+			void				_Place		(int32 index, uint64_t& random,
+											_Station&) const;
+			// the modes, and their amplitudes in tenths for each month
+			// from fFirstYear, SYNTHETIC_MODES at a time
+			void				_Regional	(std::vector<_Mode>&,
+											std::vector<float>& amplitudes)
+												const;
+			void				_Render		(int32 index,
+											const std::vector<_Mode>&,
+											const std::vector<float>&
+												amplitudes,
+											std::string& header,
+											std::string& data) const;
+
+		int32					fStations;
+		uint64_t				fSeed;
+		int32					fFirstYear;
+		int32					fLastYear;
+		int32					fMinSpan;
+		int32					fMaxSpan;
+		double					fMissingRate;
+		EMSyntheticLayout		fLayout;
+		std::vector<EMPoint>	fCenters;
+};
+
+
+#endif // EM_SYNTHETIC_DATA_H
@@ -7,8 +7,19 @@
 */
 
 
+#include <string.h>
+#include <strings.h>
+
+#include "MathUtils.h"
+
 #include "Temperature.h"
 
+
+#define	TEMPERATURE_LANES		8
+#define	TEMPERATURE_MISSING		-99.9f			// as the station data
+#define	TEMPERATURE_MISSING_BITS	0xC2C7CCCDu		// -99.9f
+#define	TEMPERATURE_BELOW_BITS		0xC2C60000u		// -99.0f
+
 //namespace Temperature {
 
 // #pragma mark EMTemperature
@@ -120,6 +131,242 @@ EMTemperature operator - (const EMTemperature& t1, const EMTemperature& t2)
 }
 
 
+//#pragma mark Batch conversion
+
+
+static inline bool
+_Exact(TScale scale)
+{	// Fahrenheit goes below -99 on the Antarctic plateau, so there only the
+	// sentinel itself is missing; nothing real is that cold in the others
+	return scale == TScale::Fahrenheit;
+}
+
+
+static inline int32_t
+_Missing(float value, bool exact)
+{	// All ones where missing.  At or below -99: negative floats have the
+	// sign bit set, and their magnitude grows with the remaining bits.
+	uint32_t bits = LFloatBits(value);
+	return exact ? -(bits == TEMPERATURE_MISSING_BITS)
+		: -(bits >= TEMPERATURE_BELOW_BITS);
+}
+
+
+template<typename Function>
+static inline void
+_Blocks(const float* in, float* out, int32 count, Function function)
+{	// Whole blocks through local arrays, so the loop in `function` has a
+	// fixed length and nothing aliases (in may be out), then the rest.
+	float	block[TEMPERATURE_LANES] = {},
+			result[TEMPERATURE_LANES];
+	int32	i = 0;
+
+	for (; i + TEMPERATURE_LANES <= count; i += TEMPERATURE_LANES) {
+		memcpy(block, in + i, sizeof(block));
+		function(block, result);
+		memcpy(out + i, result, sizeof(result));
+	}
+
+	if (i < count) {
+		memcpy(block, in + i, (count - i) * sizeof(float));
+		function(block, result);
+		memcpy(out + i, result, (count - i) * sizeof(float));
+	}
+}
+
+
+static void
+_Affine(const float* in, float* out, int32 count, float factor, float offset,
+	TScale scale)
+{	// scale is in's, for telling what is missing
+	bool exact = _Exact(scale);
+
+	_Blocks(in, out, count, [factor, offset, exact](const float* block,
+		float* result) {
+		for (int32 k = 0; k < TEMPERATURE_LANES; ++k) {
+			result[k] = LSelect(_Missing(block[k], exact), block[k],
+				block[k] * factor + offset);
+		}
+	});
+}
+
+
+template<TScale From, TScale To>
+void	LConvertTemperatures	(const float* in, float* out, int32 count)
+{
+	if (From == To) {
+		if (in != out)
+			memmove(out, in, count * sizeof(float));
+		return;
+	}
+
+	_Affine(in, out, count, LScaleFactor(From, To), LScaleOffset(From, To),
+		From);
+}
+
+
+template<TScale From, TScale To>
+void	LConvertDifferences		(const float* in, float* out, int32 count)
+{
+	if (From == To || LScaleFactor(From, To) == 1.0) {
+		if (in != out)
+			memmove(out, in, count * sizeof(float));
+		return;
+	}
+
+	_Affine(in, out, count, LScaleFactor(From, To), 0.0f, From);
+}
+
+
+#define	TEMPERATURE_INSTANTIATE(FROM, TO)								\
+	template void LConvertTemperatures<FROM, TO>(const float*, float*,	\
+		int32);															\
+	template void LConvertDifferences<FROM, TO>(const float*, float*,	\
+		int32);
+
+TEMPERATURE_INSTANTIATE(Kelvin, Kelvin)
+TEMPERATURE_INSTANTIATE(Kelvin, Celsius)
+TEMPERATURE_INSTANTIATE(Kelvin, Fahrenheit)
+TEMPERATURE_INSTANTIATE(Celsius, Kelvin)
+TEMPERATURE_INSTANTIATE(Celsius, Celsius)
+TEMPERATURE_INSTANTIATE(Celsius, Fahrenheit)
+TEMPERATURE_INSTANTIATE(Fahrenheit, Kelvin)
+TEMPERATURE_INSTANTIATE(Fahrenheit, Celsius)
+TEMPERATURE_INSTANTIATE(Fahrenheit, Fahrenheit)
+
+
+template<TScale From>
+static void
+_ConvertFrom(TScale to, const float* in, float* out, int32 count,
+	bool differences)
+{
+	switch (to) {
+		case TScale::Kelvin:
+			differences ? LConvertDifferences<From, Kelvin>(in, out, count)
+				: LConvertTemperatures<From, Kelvin>(in, out, count);
+			break;
+		case TScale::Celsius:
+			differences ? LConvertDifferences<From, Celsius>(in, out, count)
+				: LConvertTemperatures<From, Celsius>(in, out, count);
+			break;
+		case TScale::Fahrenheit:
+			differences ? LConvertDifferences<From, Fahrenheit>(in, out, count)
+				: LConvertTemperatures<From, Fahrenheit>(in, out, count);
+			break;
+	}
+}
+
+
+static void
+_Convert(TScale from, TScale to, const float* in, float* out, int32 count,
+	bool differences)
+{
+	switch (from) {
+		case TScale::Kelvin:
+			_ConvertFrom<Kelvin>(to, in, out, count, differences);
+			break;
+		case TScale::Celsius:
+			_ConvertFrom<Celsius>(to, in, out, count, differences);
+			break;
+		case TScale::Fahrenheit:
+			_ConvertFrom<Fahrenheit>(to, in, out, count, differences);
+			break;
+	}
+}
+
+
+void	LConvertTemperatures	(TScale from, TScale to, const float* in,
+	float* out, int32 count)
+{
+	_Convert(from, to, in, out, count, false);
+}
+
+
+void	LConvertDifferences		(TScale from, TScale to, const float* in,
+	float* out, int32 count)
+{
+	_Convert(from, to, in, out, count, true);
+}
+
+
+void	LSubtractBaseline		(const float* values, const float* baseline,
+	float* out, int32 count, TScale scale)
+{
+	bool	exact = _Exact(scale);
+	float	block[TEMPERATURE_LANES] = {},
+			base[TEMPERATURE_LANES] = {},
+			result[TEMPERATURE_LANES];
+
+	auto subtract = [&]() {
+		for (int32 k = 0; k < TEMPERATURE_LANES; ++k) {
+			result[k] = LSelect(_Missing(block[k], exact)
+					| _Missing(base[k], exact),
+				TEMPERATURE_MISSING, block[k] - base[k]);
+		}
+	};
+
+	int32 i = 0;
+	for (; i + TEMPERATURE_LANES <= count; i += TEMPERATURE_LANES) {
+		memcpy(block, values + i, sizeof(block));
+		memcpy(base, baseline + i, sizeof(base));
+		subtract();
+		memcpy(out + i, result, sizeof(result));
+	}
+
+	if (i < count) {
+		memcpy(block, values + i, (count - i) * sizeof(float));
+		memcpy(base, baseline + i, (count - i) * sizeof(float));
+		subtract();
+		memcpy(out + i, result, (count - i) * sizeof(float));
+	}
+}
+
+
+void	LAddOffset				(const float* values, float offset,
+	float* out, int32 count, TScale scale)
+{
+	_Affine(values, out, count, 1.0f, offset, scale);
+}
+
+
+bool	LParseScale				(const char* name, TScale& scale)
+{	// the whole name or its first letter, in any case
+	static const struct {
+		const char*	name;
+		TScale		scale;
+	} kScales[] = {
+		{ "k", TScale::Kelvin }, { "kelvin", TScale::Kelvin },
+		{ "c", TScale::Celsius }, { "celsius", TScale::Celsius },
+		{ "f", TScale::Fahrenheit }, { "fahrenheit", TScale::Fahrenheit }
+	};
+
+	if (name == nullptr)
+		return false;
+
+	for (const auto& known : kScales) {
+		if (strcasecmp(name, known.name) == 0) {
+			scale = known.scale;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+const char*	LScaleName			(TScale scale)
+{
+	switch (scale) {
+		case TScale::Kelvin:
+			return "kelvin";
+		case TScale::Fahrenheit:
+			return "fahrenheit";
+		default:
+			return "celsius";
+	}
+}
+
+
 bool operator == (const EMTemperature& t1, const EMTemperature& t2)
 {
 	// convert to float for test due to double rounding errors
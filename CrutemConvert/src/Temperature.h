@@ -9,6 +9,7 @@
 #ifndef EM_TEMPERATURE_H
 #define EM_TEMPERATURE_H
 
+#include "StdTypedefs.h"
 
 //namespace Temperature {
 
@@ -80,6 +81,79 @@ constexpr double 	cTof		(double c)
 }
 
 
+//#pragma mark  Batch conversion
+
+/*
+	The same conversions over whole arrays of floats, with the scales as
+	template parameters: each pair folds into one constant multiply-add,
+
+		to = from * LScaleFactor(From, To) + LScaleOffset(From, To)
+
+	run over blocks of values with no branches, so a column of output is
+	converted in one vectorized pass rather than through an EMTemperature
+	per value.  Differences (anomalies, offsets) take only the factor.
+	Missing values are passed through unchanged.  What is missing depends
+	on the scale the values are in: in Celsius and kelvin anything at or
+	below -99, as in the station data and SERIES_MISSING, but Fahrenheit
+	goes below -99 for real, so there only SERIES_MISSING itself (-99.9) is
+	missing - and that is what a missing value converted to Fahrenheit
+	still holds.  `in` and `out` may be the same array.
+
+		LConvertTemperatures<Celsius, Fahrenheit>(celsius, out, count);
+
+	Where the scale is only known at run time, the overloads taking
+	TScale arguments pick the instantiation once for the whole array.
+*/
+
+constexpr double	LKelvinFactor	(TScale scale)
+{	// kelvin per degree
+	return scale == Fahrenheit ? 1.0 / 1.8 : 1.0;
+}
+
+constexpr double	LKelvinOffset	(TScale scale)
+{	// kelvin at zero degrees
+	return scale == Celsius ? 273.15
+		: (scale == Fahrenheit ? 459.67 / 1.8 : 0.0);
+}
+
+constexpr double	LScaleFactor	(TScale from, TScale to)
+{
+	return LKelvinFactor(from) / LKelvinFactor(to);
+}
+
+constexpr double	LScaleOffset	(TScale from, TScale to)
+{
+	return (LKelvinOffset(from) - LKelvinOffset(to)) / LKelvinFactor(to);
+}
+
+
+template<TScale From, TScale To>
+void	LConvertTemperatures	(const float* in, float* out, int32 count);
+
+template<TScale From, TScale To>
+void	LConvertDifferences		(const float* in, float* out, int32 count);
+
+void	LConvertTemperatures	(TScale from, TScale to, const float* in,
+							float* out, int32 count);
+void	LConvertDifferences		(TScale from, TScale to, const float* in,
+							float* out, int32 count);
+
+// out = values - baseline, missing where either is; scale is the values'
+void	LSubtractBaseline		(const float* values, const float* baseline,
+							float* out, int32 count,
+							TScale scale = Celsius);
+
+// out = values + offset, in the values' scale
+void	LAddOffset				(const float* values, float offset,
+							float* out, int32 count,
+							TScale scale = Celsius);
+
+// "C", "kelvin", "F", ... in any case; false, leaving `scale` alone, for
+// anything else
+bool		LParseScale			(const char* name, TScale& scale);
+const char*	LScaleName			(TScale);
+
+
 //#pragma mark  quasi literals
 
 constexpr EMTemperature _kelvin(long double t)
@@ -25,9 +25,13 @@
 				- Implement ability to output to emsl portable file format.
 */
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
 #include <string>
+#include <unordered_set>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <fstream>
@@ -35,190 +39,35 @@
 #include <unistd.h>
 #include <vector>
 
+#include "Correlation.h"
+#include "Bootstrap.h"
+#include "DailySeries.h"
+#include "GridCube.h"
+#include "GridPyramid.h"
+#include "Homogenize.h"
 #include "IDAvgAccum.h"
+#include "MapRenderer.h"
+#include "Infill.h"
+#include "OutputWriter.h"
+#include "Parallel.h"
 #include "ParseArgs.h"
+#include "PortStream.h"
+#include "QueryServer.h"
+#include "SeriesTable.h"
+#include "SharedDataset.h"
+#include "StationExport.h"
+#include "StationIndex.h"
 #include "StdTypedefs.h"
 #include "StationListFormat.h"
+#include "StationParser.h"
+#include "StationSearch.h"
+#include "Stats.h"
 
 
-LStringList&	Split(const std::string& str, char delim, LStringList& out) {
-	using namespace std;
-	stringstream strstr(str);
-	string token;
-	while (getline(strstr, token, delim)) {
-		if (token.size() > 0)
-			out.push_back(token);
-	}
-
-	return out;
-}
-
-
-std::string	ParseFile(const char* path, LStringList& output)
-{
-	using namespace std;
-	printf("Parsing %s: ", path);
-	fflush(stdout);
-
-	ifstream file(path);
-	if (file.fail()) {
-		printf("failed! FILE ERROR\n");
-		return "file error";
-	}
-
-	output.clear();		// start with an empty list
-	string line;
-	while (getline(file, line)) {
-		if (line != "")
-			output.push_back(line);
-	}
-
-	printf("complete (%li lines)\n", output.size());
-	return "";
-}
-
-
-std::string	ParseStation(const LString& header, const LStringList& data,
-						Station& output, int32& dataIndex)
-{
-	using namespace std;
-	LStringList split;
-	Split(header, ' ', split);
-
-	LString stationID = split[0];
-	for (int32 i = dataIndex; i < data.size(); ++i) {
-		if (data[i].find(stationID.c_str()) != std::string::npos) {
-			dataIndex = i;	// so we don't keep scanning the whole document...
-			/*
-				data holds the lines of the actual data, which begins with
-				the station header.  We have identified that the header is ours
-				and it is data[i].
-				This means the next lines which begin with a year (four char #)
-				is our year data.
-
-				We need to extract, from our header, our start and end year,
-				which is held as a 8 char string in index 6 of our header, except
-				when the station name or nation has spaces!!
-
-				The easy solution is to go from the right..., and back off 4
-			*/
-			int32 pos = split.size() - 4;
-			LString tmp1 = split[pos].c_str(),
-					tmp2;
-
-			tmp2 = tmp1.substr(4, 4);
-			tmp1.resize(4);
-
-			output.STARTYEAR = atoi(tmp1.c_str());
-			output.ENDYEAR = atoi(tmp2.c_str());
-
-			int32 yearCount = output.ENDYEAR - output.STARTYEAR;
-			if (yearCount > 400
-				|| yearCount <= 0)
-				return "Bad year count for station";
-
-			output.ID = atoi(stationID.c_str());
-			output.LAT = atof(split[1].c_str())/10.0;
-			output.LON = -1 * (atof(split[2].c_str())/10.0);
-			output.ELEV = atoi(split[3].c_str());
-
-
-			// strings between 4 and pos are the station name and the nation
-			// The formatting doesn't provide any clues, but it seems most nations
-			// in the list don't contain spaces, so we'll work with that since...
-			// Names don't matter anyway...
-			tmp1 = split[4];
-
-			//output.NAME = split[4];
-			for (int32 j = 5; j < pos -1 ; ++j) {
-				tmp1 += string(" ");
-				tmp1 += split[j].c_str();
-			}
-
-			tmp1.erase(std::remove(tmp1.begin(), tmp1.end(), '-'), tmp1.end());
-			int32 lastIndex = tmp1.size();
-			if (lastIndex > 126)
-				lastIndex = 126;
-
-			for (int32 j = 0; j != lastIndex; ++j)
-				output.NAME[j] = tmp1[j];
-
-			output.NAME[lastIndex] = '\0';
-
-			tmp1 = split[pos-1];
-			tmp1.erase(std::remove(tmp1.begin(), tmp1.end(), '-'), tmp1.end());
-
-			lastIndex = tmp1.size();
-			if (lastIndex > 62)
-				lastIndex = 62;
-
-			for (int32 j = 0; j != lastIndex; ++j)
-				output.COUNTRY[j] = tmp1[j];
-
-			output.COUNTRY[lastIndex] = '\0';
-
-			/*
-				FINALLY!  On to the actual data!
-			*/
-
-			output.DATA = new YearData[yearCount];
-
-			pos = 1;
-			int32 yearIndex = 0;
-			LStringList splitYear;
-			for (int32 year = output.STARTYEAR; year < output.ENDYEAR; ++year) {
-				// data[i] holds the header data
-				// i + pos is the next string for the next year
-				splitYear.clear();
-
-				tmp1.clear();
-				tmp1 = to_string(year);
-				Split(data[i + pos], ' ', splitYear);
-
-				if (tmp1 != splitYear[0].c_str()) {
-					printf("\n\nERROR! %s != %s\n\n",
-						tmp1.c_str(),
-						splitYear[0].c_str());
-						snooze(1300000);	// to make the error stand out!!
-				} else {
-					// Success!
-					// Each year has the following format:
-
-					//   0   1   2   3   4   5   6   7   8   9   10  11  12  13
-					// YEAR JAN FEB MAR APR MAY JUN JUL AUG SEP OCT NOV DEC AVG
-					YearData& yd = output.DATA[yearIndex];
-
-					yd.YEAR = year;
-					yd.JAN = atof(splitYear[1].c_str()) / 10.0;
-					yd.FEB = atof(splitYear[2].c_str()) / 10.0;
-					yd.MAR = atof(splitYear[3].c_str()) / 10.0;
-					yd.APR = atof(splitYear[4].c_str()) / 10.0;
-					yd.MAY = atof(splitYear[5].c_str()) / 10.0;
-					yd.JUN = atof(splitYear[6].c_str()) / 10.0;
-					yd.JUL = atof(splitYear[7].c_str()) / 10.0;
-					yd.AUG = atof(splitYear[8].c_str()) / 10.0;
-					yd.SEP = atof(splitYear[9].c_str()) / 10.0;
-					yd.OCT = atof(splitYear[10].c_str()) / 10.0;
-					yd.NOV = atof(splitYear[11].c_str()) / 10.0;
-					yd.DEC = atof(splitYear[12].c_str()) / 10.0;
-					yd.AVG = 0;
-
-					yd.VALID = true;
-				}
-
-				++yearIndex;
-				++pos;
-			}
-
-			return "";
-		}// found station ID
-	} // end data loop
-
-	// fall-through is failure
-	return "Unable to find data for station";
-}
-
-
+// what -output=port:name streams
+#define	PORT_SERIES_STATIONS	1	// each station's annual means, by ID
+#define	PORT_SERIES_GLOBAL		2
+#define	PORT_SERIES_COUNT		3	// stations in each global mean
 
 
 int main(int argc, char**argv)
@@ -232,6 +81,26 @@ int main(int argc, char**argv)
         if (pa->returnValue != 0)
             return pa->returnValue;
 
+	if (pa->stats) {
+		LStatsEnable();
+		LStatsNote("header", pa->headerFile);
+		LStatsNote("data", pa->dataFile);
+		LStatsNote("threads", ::to_string(LThreadCount()));
+	}
+
+	// connect first, so the consumer can start on the stations as they go
+	EMPortStream port;
+	if (pa->outputTarget == OUTPUT_TO_PORT) {
+		LString name = pa->outputFile.substr(5);
+		if (!port.Connect(name)) {
+			printf("ERROR: unable to connect to \"%s\"\n",
+				EMPortStream::SocketPath(name).c_str());
+			return 3;
+		}
+
+		port.DefineSeries(PORT_SERIES_STATIONS, "station annual mean");
+	}
+
 	/*
 		Parsing data files
 	*/
@@ -274,6 +143,21 @@ int main(int argc, char**argv)
 	bool ignore = false;
 	int8 showStat = 64;
 
+	// implement ignore list, before any station is parsed
+	std::vector<bool> ignored(header.size(), false);
+	{
+		EMPhaseTimer timer("ignore");
+		for (int32 i = 0; i < header.size(); ++i) {
+			for (const auto & s : ignoreEntries) {
+				if (header[i].find(s) != std::string::npos) {
+					ignored[i] = true;
+					break;
+				}
+			}
+		}
+	}
+
+	EMPhaseTimer parseTimer("parse");
 	for (int32 i = 0; i < header.size(); ++i) {
 		ignore = false;
 		stationHeader = header[i];
@@ -283,21 +167,19 @@ int main(int argc, char**argv)
 		else if (station == NULL)
 			error = "NULL entry in StationList";
 		else
-		 {	// implement ignore list:
-
-			for (const auto & s : ignoreEntries) {
-				if (stationHeader.find(s) != std::string::npos) {
-					ignore = true;
-					break;
-				}
-			}
-
+		 {
+			ignore = ignored[i];
 			if (ignore == false)
 				error = ParseStation(stationHeader, data, *station, dataIndex);
 			else
 				error = "";
 		 }
 
+		if (error != "")
+			LStatsAdd(STAT_STATIONS_REJECTED);
+		else
+			LStatsAdd(ignore ? STAT_STATIONS_IGNORED : STAT_STATIONS_PARSED);
+
 		if (error != "") {
 			printf("\r\t\t\t\t\t\t\t\t\t\t\t\t\t");
 			printf("\nERROR! Station %li not found:\n", i);
@@ -317,9 +199,59 @@ int main(int argc, char**argv)
 			station = NULL;
 		}
 	}
+	parseTimer.Stop();
 	printf("\r\t\t\t\t\t\t\t\t\t\t\t\t\r");
 	printf("%li stations in list\n", StationList.size());
 
+	/*
+		Remove breakpoints, then infill short gaps, from correlated
+		neighbours before anything is averaged.
+	*/
+	if (pa->homogenize || pa->infill) {
+		EMPhaseTimer neighbourTimer("neighbours");
+		EMSeriesTable table;
+		table.Build(StationList);
+
+		EMStationIndex index;
+		index.Build(StationList);
+
+		EMCorrelationGraph graph;
+		graph.Build(table, index, INFILL_CUTOFF_KM, INFILL_MIN_OVERLAP,
+			INFILL_MIN_CORRELATION);
+		neighbourTimer.Stop();
+
+		if (pa->homogenize) {
+			EMPhaseTimer timer("homogenize");
+			printf("Homogenizing against neighbours...\n");
+
+			EMHomogenizer homogenizer(table, graph);
+			homogenizer.Run();
+			int32 shifted = homogenizer.Store();
+
+			printf("\tshifted %li months at %li breakpoints in %li of %li "
+				"stations tested (%li passes)\n", shifted,
+				homogenizer.Breakpoints().size(),
+				homogenizer.AdjustedCount(), homogenizer.TestedCount(),
+				homogenizer.PassCount());
+
+			if (pa->infill)
+				table.Build(StationList);	// infill from the shifted data
+		}
+
+		if (pa->infill) {
+			EMPhaseTimer timer("infill");
+			printf("Infilling gaps of up to %li months...\n",
+				(int32)pa->maxInfillSpan);
+
+			EMInfill infill(table, graph);
+			infill.Run(pa->maxInfillSpan);
+			int32 filled = infill.Store();
+
+			printf("\tinfilled %li months in %li gaps (%li neighbour links)\n",
+				filled, infill.GapCount(), graph.EdgeCount() / 2);
+		}
+	}
+
 	double accum[12];
 	int32 missing[12];
 	for (int32 i = 0; i < 12; ++i) {
@@ -345,6 +277,7 @@ int main(int argc, char**argv)
 	float stationComplete = 0;
 	uint64 year2000 = 0;
 
+	EMPhaseTimer aggregateTimer("aggregate");
 	for (int32 i = 0; i < StationList.size(); ++i) {
 		station = StationList[i];
 		totalMissing = 0;
@@ -385,6 +318,9 @@ int main(int argc, char**argv)
 			showStat++;
 
 		} // end for each year
+		LStatsAdd(STAT_VALUES, yearCount * 12);
+		LStatsAdd(STAT_VALUES_MISSING, totalMissing);
+
 		// Calculate 'quality' of station data completeness
 
 			station->QUALITY = 100.0 * (1.0 - ((float)totalMissing) / (yearCount * 12.0));
@@ -397,6 +333,17 @@ int main(int argc, char**argv)
 			missing[j] = 0;
 		}
 
+		if (port.IsConnected()) {
+			std::vector<float> annual(yearCount);
+			for (int32 j = 0; j < yearCount; ++j)
+				annual[j] = station->DATA[j].AVG;
+
+			LConvertTemperatures(Celsius, pa->outputScale, annual.data(),
+				annual.data(), yearCount);
+			port.WriteChunk(PORT_SERIES_STATIONS, station->ID,
+				station->STARTYEAR, annual.data(), yearCount);
+		}
+
 		/*
 			TODO: Insert Station into EMCoordCell
 		*/
@@ -405,22 +352,223 @@ int main(int argc, char**argv)
 
 		stationComplete = 100.0 * ((double)i / (double)StationList.size());
 	}
+	aggregateTimer.Stop();
 	printf("\r\t\t\t\t\t\t\t\t\t\t\t\t\r");
 
+	/*
+		Station search, by index.  Whatever it finds also limits -export.
+	*/
+	std::unordered_set<const Station*> foundStations;
+	if (pa->findStation) {
+		EMPhaseTimer timer("search");
+		EMStationSearch search;
+		search.Build(StationList);
+
+		LStringList queries;
+		if (pa->findStationString.find('@') == 0) {
+			error = ParseFile(pa->findStationString.c_str() + 1, queries);
+			if (error != "")
+				printf("ERROR: \"%s\"\n", error.c_str());
+		} else
+			queries.push_back(pa->findStationString);
+
+		// every match: -export writes what was found, so nothing may drop
+		std::vector<std::vector<int32> > found;
+		search.FindAll(queries, found, pa->findStationFuzzy, INT32_MAX);
+
+		for (size_t q = 0; q < queries.size(); ++q) {
+			printf("Search \"%s\": %li station(s)\n", queries[q].c_str(),
+				(int32)found[q].size());
+			for (int32 index : found[q]) {
+				search.StationAt(index)->PrintToStream();
+				foundStations.insert(search.StationAt(index));
+			}
+		}
+	}
+
+	if (pa->publish) {
+		EMPhaseTimer timer("publish");
+		EMSharedDataset shared;
+		if (shared.Publish(StationList, pa->publishName)) {
+			printf("Published %li stations (%.1f MB) as \"%s\"\n",
+				shared.StationCount(), shared.Size() / 1048576.0,
+				pa->publishName.c_str());
+		} else
+			printf("ERROR: unable to publish \"%s\"\n",
+				pa->publishName.c_str());
+	}
+
+	/*
+		Bin the stations once and aggregate every grid level from it.
+	*/
+	EMGridPyramid pyramid(pa->gridSize);
+	if (pa->useGrid || (pa->bootstrap && pa->bootstrapCells)
+		|| pa->outputTarget == OUTPUT_TO_CUBE || pa->map || pa->serve) {
+		EMPhaseTimer timer("grid");
+		pyramid.Build(StationList);
+
+		printf("Grid levels:\n");
+		for (int32 level = 0; level < pyramid.LevelCount(); ++level) {
+			printf("\t%5.1f x %5.1f degrees: %li of %li cells with data\n",
+				pyramid.LatStep(level), pyramid.LonStep(level),
+				pyramid.OccupiedCount(level), pyramid.CellCount(level));
+		}
+	}
+
+	if (pa->bootstrap) {
+		EMPhaseTimer timer("bootstrap");
+		EMBootstrap bootstrap;
+		if (pa->bootstrapCells)
+			bootstrap.AddCells(pyramid);
+		else
+			bootstrap.AddStations(StationList);
+
+		printf("Bootstrapping %li replicates of %li %s...\n",
+			(int32)pa->bootstrapCount, bootstrap.UnitCount(),
+			pa->bootstrapCells ? "cells" : "stations");
+
+		bootstrap.Run(pa->bootstrapCount);
+		if (bootstrap.WriteCSV(pa->bandsFile, pa->outputScale))
+			printf("\tWrote bands to \"%s\"\n", pa->bandsFile.c_str());
+		else
+			printf("ERROR: unable to write \"%s\"\n", pa->bandsFile.c_str());
+	}
+
+	if (pa->interpolate) {
+		EMPhaseTimer timer("interpolate");
+		EMDailyInterpolator daily(
+			pa->interpolateCubic ? INTERPOLATE_CUBIC : INTERPOLATE_LINEAR,
+			(int32)pa->interpolateDayCount);
+
+		printf("Writing %s daily values every %li day(s)...\n",
+			pa->interpolateCubic ? "cubic" : "linear", daily.Step());
+
+		int64 written = daily.WriteCSV(StationList, pa->dailyFile,
+			pa->outputScale);
+		if (written < 0)
+			printf("ERROR: unable to write \"%s\"\n", pa->dailyFile.c_str());
+		else
+			printf("\tWrote %lli daily values to \"%s\"\n", written,
+				pa->dailyFile.c_str());
+	}
+
+	/*
+		The gridded field, for the cube output and the maps.  Maps are of
+		anomalies unless asked otherwise: absolute values mostly show
+		latitude and the seasons, and any change hides beneath them.  They
+		share the output cube when it holds the same values.
+	*/
+	auto fillCube = [&](EMGridCube& cube) {
+		EMPhaseTimer timer("cube");
+		// anomalies are gridded from each station's own, not the cells'
+		return cube.Values() == CUBE_ANOMALY
+			? cube.Fill(StationList, pa->gridSize) : cube.Fill(pyramid);
+	};
+
+	EMGridCube cube(pa->cubeAnomaly ? CUBE_ANOMALY : CUBE_ABSOLUTE,
+		pa->outputScale);
+	int64 cubeValues = 0;
+	if (pa->outputTarget == OUTPUT_TO_CUBE)
+		cubeValues = fillCube(cube);
+
+	if (pa->map) {
+		EMGridCube mapCube(pa->mapAnomaly ? CUBE_ANOMALY : CUBE_ABSOLUTE,
+			pa->outputScale);
+		const EMGridCube* shown = &cube;
+		if (pa->outputTarget != OUTPUT_TO_CUBE
+			|| cube.Values() != mapCube.Values()) {
+			fillCube(mapCube);
+			shown = &mapCube;
+		}
+
+		EMPhaseTimer timer("map");
+		EMMapRenderer map(pa->mapWidth, pa->mapHeight);
+		map.SetPeriod(pa->mapYearly ? MAP_YEARLY : MAP_MONTHLY);
+
+		printf("Rendering %li %s %li x %li %s maps...\n",
+			map.FrameCount(*shown), pa->mapYearly ? "yearly" : "monthly",
+			map.Width(), map.Height(),
+			shown->Values() == CUBE_ANOMALY ? "anomaly" : "absolute");
+
+		int32 frames = pa->mapVideo ? map.WriteY4M(*shown, pa->mapPath)
+			: map.WritePPM(*shown, pa->mapPath);
+		if (frames < 0)
+			printf("ERROR: unable to write \"%s\"\n", pa->mapPath.c_str());
+		else
+			printf("\tWrote %li frames to \"%s\"\n", frames,
+				pa->mapPath.c_str());
+	}
+
+	if (pa->exportStations) {
+		EMPhaseTimer timer("export");
+		EMStationExport exporter(pa->outputScale);
+		if (pa->findStation || pa->singleCell) {
+			exporter.SetFilter([pa, &foundStations](const Station& station) {
+				if (pa->findStation && foundStations.count(&station) == 0)
+					return false;
+				return !pa->singleCell
+					|| pa->cellRect.Contains(station.LAT, station.LON);
+			});
+		}
+
+		printf("Exporting monthly station series...\n");
+
+		int64 written = pa->exportPerStation
+			? exporter.WriteFiles(StationList, pa->exportPath)
+			: exporter.WriteCSV(StationList, pa->exportPath);
+		if (written < 0)
+			printf("ERROR: unable to write \"%s\"\n", pa->exportPath.c_str());
+		else
+			printf("\tWrote %lli values from %li stations to \"%s\"\n",
+				written, exporter.StationsWritten(), pa->exportPath.c_str());
+	}
+
 	/*
 		Save data to file!
 	*/
 
+	// the annual series, put in the output scale with one pass (Celsius
+	// is written from the doubles, as it always has been)
+	std::vector<uint32>	years,
+						counts;
+	std::vector<double>	averages;
+
+	EMPhaseTimer outputTimer("output");
+	globalAverage.sort();
+	globalAverage.for_each(
+		[&](uint32 year, double average, uint32 count) {
+		years.push_back(year);
+		averages.push_back(average);
+		counts.push_back(count);
+	});
+
+	if (pa->outputScale != Celsius) {
+		std::vector<float> converted(averages.begin(), averages.end());
+		LConvertTemperatures(Celsius, pa->outputScale, converted.data(),
+			converted.data(), converted.size());
+		averages.assign(converted.begin(), converted.end());
+	}
+
 	switch (pa->outputTarget ) {
             case OUTPUT_TO_CSV: {
-				std::ofstream outputStr(pa->outputFile.c_str());
-				outputStr << "YEAR,AVERAGE,STATIONS\n";
-				globalAverage.sort();
-				globalAverage.for_each(
-					[&outputStr](uint32 year, double average, uint32 count) {
-					outputStr << year << "," << average << "," << count << "\n";
-				});
-				cout << "Wrote CSV data to \"" << pa->outputFile << "\"\n";
+				EMOutputWriter output;
+				if (!output.Open(pa->outputFile)) {
+					cerr << "Unable to write \"" << pa->outputFile << "\"\n";
+					break;
+				}
+
+				// an ostream's default six significant digits
+				output.Write("YEAR,AVERAGE,STATIONS\n");
+				for (size_t i = 0; i < years.size(); ++i) {
+					output.WriteInt(years[i]).Write(',')
+						.WriteGeneral(averages[i]).Write(',')
+						.WriteInt(counts[i]).Write('\n');
+				}
+
+				if (output.Close())
+					cout << "Wrote CSV data to \"" << pa->outputFile << "\"\n";
+				else
+					cerr << "Unable to write \"" << pa->outputFile << "\"\n";
 				break;
 			}
 
@@ -428,22 +576,81 @@ int main(int argc, char**argv)
                 cerr << "EMSL output not currently implemented!\n";
                 break;
 
-            case OUTPUT_TO_CONSOLE:
-				cout << "YEAR\tAVG \tCOUNT\n";
-				globalAverage.sort();
-				globalAverage.for_each(
-					[](uint32 year, double average, uint32 count){
-					cout << year << "\t" << setprecision(2) << average << "\t" << count << "\n";
-				});
+            case OUTPUT_TO_CONSOLE: {
+				EMOutputWriter output;
+				output.Attach(stdout);
+				output.Write("YEAR\tAVG \tCOUNT\n");
+				for (size_t i = 0; i < years.size(); ++i) {
+					output.WriteInt(years[i]).Write('\t')
+						.WriteGeneral(averages[i], 2).Write('\t')
+						.WriteInt(counts[i]).Write('\n');
+				}
+				output.Close();
                 break;
+			}
 			
-			case OUTPUT_TO_PORT:
-				cerr << "Output to port currently unimplemented\n";
+			case OUTPUT_TO_CUBE:
+				if (cube.Write(pa->outputFile)) {
+					printf("Wrote %li months of %li x %li cells (%lli values) "
+						"to \"%s\"\n", cube.MonthCount(), cube.Rows(),
+						cube.Columns(), cubeValues, pa->outputFile.c_str());
+				} else
+					cerr << "Unable to write \"" << pa->outputFile << "\"\n";
+				break;
+
+			case OUTPUT_TO_PORT: {
+				// one value per year from the first, NaN for any gaps
+				int32 first = years.empty() ? 0 : years.front(),
+					span = years.empty() ? 0 : years.back() - first + 1;
+				std::vector<float>	global(span, NAN),
+									count(span, NAN);
+				for (size_t i = 0; i < years.size(); ++i) {
+					global[years[i] - first] = averages[i];
+					count[years[i] - first] = counts[i];
+				}
+
+				port.DefineSeries(PORT_SERIES_GLOBAL, "global annual mean");
+				port.WriteChunk(PORT_SERIES_GLOBAL, 0, first, global.data(),
+					span);
+				port.DefineSeries(PORT_SERIES_COUNT, "global annual stations");
+				port.WriteChunk(PORT_SERIES_COUNT, 0, first, count.data(), span);
+
+				if (port.Close())
+					cout << "Streamed results to \"" << pa->outputFile << "\"\n";
+				else
+					cerr << "Lost connection to \"" << pa->outputFile << "\"\n";
                 break;
+			}
 			
 			default:
 				cerr << "Confused by output target: " << pa->outputTarget;
 	}
+	outputTimer.Stop();
+
+	if (pa->stats) {
+		LStatsPrint();
+		if (LStatsWriteJSON(pa->statsFile))
+			printf("Wrote statistics to \"%s\"\n", pa->statsFile.c_str());
+		else
+			printf("ERROR: unable to write \"%s\"\n", pa->statsFile.c_str());
+	}
+
+	if (pa->serve) {
+		EMQueryServer server(StationList, pyramid, pa->outputScale);
+		server.SetGlobalSeries(years, averages, counts);
+
+		printf("Serving queries on \"%s\"...\n",
+			EMPortStream::SocketPath(pa->serveName).c_str());
+		fflush(stdout);
+
+		if (!server.Run(pa->serveName)) {
+			printf("ERROR: unable to listen on \"%s\"\n",
+				EMPortStream::SocketPath(pa->serveName).c_str());
+			return 3;
+		}
+
+		printf("Answered %lli requests\n", server.RequestCount());
+	}
 
 	return 0;
 }
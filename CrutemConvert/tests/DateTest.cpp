@@ -0,0 +1,131 @@
+/*
+	EMDate's epoch days, which DaysFrom(), AddDays() and adding days to a
+	full date go through - and so the daily interpolation and date range
+	averages too.
+*/
+
+#include <stdio.h>
+
+#include "Date.h"
+
+#include "Test.h"
+
+
+#define	TEST_SWEEP_YEARS	10000		// either side of 1970
+
+
+static bool
+_IsNextDay(const EMDate& date, const EMDate& next)
+{	// the calendar's idea of tomorrow, worked out without epoch days
+	if (date.Day() < date.DaysInMonth()) {
+		return next.Year() == date.Year() && next.Month() == date.Month()
+			&& next.Day() == date.Day() + 1;
+	}
+
+	if (date.Month() < 12) {
+		return next.Year() == date.Year() && next.Month() == date.Month() + 1
+			&& next.Day() == 1;
+	}
+
+	return next.Year() == date.Year() + 1 && next.Month() == 1
+		&& next.Day() == 1;
+}
+
+
+TEST(DateEpochAnchors)
+{
+	CHECK(EMDate(1970, 1, 1).EpochDay() == 0);
+	CHECK(EMDate(1969, 12, 31).EpochDay() == -1);
+	CHECK(EMDate(2000, 3, 1).EpochDay() == 11017);
+	CHECK(EMDate(0, 3, 1).EpochDay() == -719468);
+
+	EMDate day = EMDate::FromEpochDay(0);
+	CHECK(day.Year() == 1970 && day.Month() == 1 && day.Day() == 1);
+}
+
+
+TEST(DateRoundTripAndStep)
+{	// every day of TEST_SWEEP_YEARS either side of 1970, in order
+	int64	first = EMDate(1970 - TEST_SWEEP_YEARS, 1, 1).EpochDay(),
+			last = EMDate(1970 + TEST_SWEEP_YEARS, 12, 31).EpochDay();
+	int64	roundTrip = 0,
+			steps = 0;
+
+	EMDate date = EMDate::FromEpochDay(first);
+	CHECK(date.Year() == 1970 - TEST_SWEEP_YEARS && date.Month() == 1
+		&& date.Day() == 1);
+
+	for (int64 day = first; day <= last; ++day) {
+		EMDate next = EMDate::FromEpochDay(day + 1);
+
+		// counted rather than CHECK()ed, so a bug can't print millions
+		if (date.EpochDay() != day)
+			++roundTrip;
+		if (!_IsNextDay(date, next))
+			++steps;
+
+		date = next;
+	}
+
+	if (roundTrip != 0 || steps != 0) {
+		printf("\t%lli round trips and %lli steps wrong\n", roundTrip,
+			steps);
+	}
+	CHECK(roundTrip == 0);
+	CHECK(steps == 0);
+}
+
+
+TEST(DateAddDays)
+{
+	EMDate date(1999, 12, 31);
+	date += 1_day;
+	CHECK(date.Year() == 2000 && date.Month() == 1 && date.Day() == 1);
+
+	date -= 1_day;
+	CHECK(date.Year() == 1999 && date.Month() == 12 && date.Day() == 31);
+
+	date.AddDays(60);
+	CHECK(date.Year() == 2000 && date.Month() == 2 && date.Day() == 29);
+
+	date.AddDays(-146097);		// one whole 400 year era
+	CHECK(date.Year() == 1600 && date.Month() == 2 && date.Day() == 29);
+}
+
+
+TEST(DateDaysFrom)
+{	// Pinned against the year/month/day stepping DaysFrom() replaced.  That
+	// never counted a leap day - its IsLeapYear() checked the wrong "no
+	// year" sentinel, so every year had 365 days and every February 28 -
+	// and its answers were short by the leap days in between.
+	struct {
+		EMDate			from,
+						to;
+		int64			days,
+						old;
+	} pins[] = {
+		{ EMDate(1850, 1, 15),	EMDate(2015, 6, 15),	60416,	60376 },
+		{ EMDate(1970, 1, 1),	EMDate(2000, 1, 1),		10957,	10950 },
+		{ EMDate(1961, 1, 1),	EMDate(1990, 12, 31),	10956,	10949 },
+		{ EMDate(1600, 1, 1),	EMDate(2400, 1, 1),		292194,	292000 },
+		{ EMDate(2000, 2, 28),	EMDate(2000, 3, 1),		2,		1 },
+		// the same either way
+		{ EMDate(1900, 2, 28),	EMDate(1900, 3, 1),		1,		1 },
+		{ EMDate(1999, 12, 31),	EMDate(2000, 1, 1),		1,		1 },
+		{ EMDate(2011, 1, 1),	EMDate(2011, 12, 31),	364,	364 },
+		{ EMDate(2004, 2, 29),	EMDate(2005, 2, 28),	365,	365 },
+		{ EMDate(1970, 1, 1),	EMDate(1970, 1, 1),		0,		0 }
+	};
+
+	for (const auto& pin : pins) {
+		int64 days = pin.from.DaysFrom(pin.to);
+		if (days != pin.days) {
+			printf("\t%lli-%02i-%02i to %lli-%02i-%02i: %lli days, not %lli "
+				"(was %lli)\n", pin.from.Year(), pin.from.Month(),
+				pin.from.Day(), pin.to.Year(), pin.to.Month(), pin.to.Day(),
+				days, pin.days, pin.old);
+		}
+		CHECK(days == pin.days);
+		CHECK(pin.to.DaysFrom(pin.from) == pin.days);
+	}
+}
@@ -0,0 +1,75 @@
+/*
+	EMGridPyramid::CellFor() and Build() at the edges of the map: both
+	poles and both sides of the date line must land in a cell, on every
+	level, and stations there must be binned rather than dropped.
+*/
+
+#include <memory>
+#include <vector>
+
+#include "GridPyramid.h"
+
+#include "Test.h"
+
+
+static Station*
+_Station(float lat, float lon)
+{
+	Station* station = new Station();
+	station->LAT = lat;
+	station->LON = lon;
+	station->STARTYEAR = 1990;
+	station->ENDYEAR = 1991;
+	station->DATA = new YearData[1];
+	station->DATA[0].VALID = true;
+	station->DATA[0].YEAR = 1990;
+	for (int16 m = 1; m <= 12; ++m)
+		station->DATA[0].SetMonthValue(m, 0);
+
+	return station;
+}
+
+
+TEST(GridPyramidEdges)
+{
+	std::vector<std::unique_ptr<Station> > owned;
+	owned.emplace_back(_Station(90, 0));
+	owned.emplace_back(_Station(-90, 0));
+	owned.emplace_back(_Station(-16.1, -180));		// UDU POINT, FIJI
+	owned.emplace_back(_Station(0, 180));
+
+	std::vector<Station*> stations;
+	for (const auto& station : owned)
+		stations.push_back(station.get());
+
+	EMGridPyramid pyramid(5.0);
+	pyramid.Build(stations);
+
+	for (int32 level = 0; level < pyramid.LevelCount(); ++level) {
+		int32	columns = pyramid.Columns(level),
+				last = pyramid.CellCount(level) - 1;
+
+		// the north pole in the top row, the south pole in the bottom
+		CHECK(pyramid.CellFor(level, 90, 0) / columns == 0);
+		CHECK(pyramid.CellFor(level, -90, 0) / columns == last / columns);
+
+		// -180 and +180 are the same meridian, the eastern edge of the
+		// last column
+		CHECK(pyramid.CellFor(level, 0, -180)
+			== pyramid.CellFor(level, 0, 180));
+		CHECK(pyramid.CellFor(level, 0, 180) % columns == columns - 1);
+		CHECK(pyramid.CellFor(level, 90, -180) == columns - 1);
+		CHECK(pyramid.CellFor(level, -90, 180) == last);
+
+		CHECK(pyramid.CellFor(level, 90.5, 0) < 0);
+		CHECK(pyramid.CellFor(level, 0, -180.5) < 0);
+	}
+
+	// all four binned, each alone in its cell
+	CHECK(pyramid.OccupiedCount(0) == 4);
+	for (const auto& station : owned) {
+		int32 cell = pyramid.CellFor(0, station->LAT, station->LON);
+		CHECK(cell >= 0 && pyramid.FineCell(cell) != nullptr
+			&& pyramid.FineCell(cell)->Count() == 1);
+	}
+}
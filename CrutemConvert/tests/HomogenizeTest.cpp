@@ -0,0 +1,152 @@
+/*
+	EMHomogenizer on a made up, well correlated region, with and without
+	one known break.  The break must be found at its station and year, and
+	nothing else may change: at the 95% level the test finds the odd break
+	in pure noise, but a real break must not leak into the neighbours
+	whose references it is part of.
+*/
+
+#include <math.h>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+
+#include "Correlation.h"
+#include "Homogenize.h"
+#include "Infill.h"
+#include "SeriesTable.h"
+#include "StationIndex.h"
+
+#include "Test.h"
+
+
+#define	TEST_STATIONS		30
+#define	TEST_FIRST_YEAR		1900
+#define	TEST_YEARS			101
+#define	TEST_BREAK_STATION	0
+#define	TEST_BREAK_YEAR		1950
+#define	TEST_BREAK_SIZE		2.0
+
+
+static double
+_Noise(uint64_t& state)
+{	// roughly normal, sigma 1: the sum of four uniforms
+	double sum = 0;
+	for (int32 i = 0; i < 4; ++i) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		sum += (state >> 11) * (1.0 / 9007199254740992.0);
+	}
+	return (sum - 2.0) * 1.7320508075688772;
+}
+
+
+static void
+_Region(double breakSize, std::vector<std::unique_ptr<Station> >& owned,
+	std::vector<Station*>& stations)
+{	// a shared regional anomaly plus a little of each station's own
+	uint64_t state = 2015;
+	std::vector<double> regional(TEST_YEARS * 12);
+	for (auto& value : regional)
+		value = _Noise(state);
+
+	for (int32 i = 0; i < TEST_STATIONS; ++i) {
+		Station* station = new Station();
+		owned.push_back(std::unique_ptr<Station>(station));
+		stations.push_back(station);
+
+		station->ID = 200000 + i;
+		station->LAT = 50 + (i % 6) * 0.5;
+		station->LON = 10 + (i / 6) * 0.5;
+		station->STARTYEAR = TEST_FIRST_YEAR;
+		station->ENDYEAR = TEST_FIRST_YEAR + TEST_YEARS;
+		station->DATA = new YearData[TEST_YEARS];
+
+		for (int32 y = 0; y < TEST_YEARS; ++y) {
+			YearData& yd = station->DATA[y];
+			yd.VALID = true;
+			yd.YEAR = TEST_FIRST_YEAR + y;
+
+			for (int16 m = 1; m <= 12; ++m) {
+				double value = 10 - 8 * cos((m - 1) * M_PI / 6)
+					+ regional[y * 12 + m - 1] + 0.3 * _Noise(state);
+				if (i == TEST_BREAK_STATION && yd.YEAR >= TEST_BREAK_YEAR)
+					value += breakSize;
+				yd.SetMonthValue(m, value);
+			}
+		}
+	}
+}
+
+
+static void
+_Homogenize(std::vector<Station*>& stations,
+	std::vector<EMBreakpoint>& breaks)
+{
+	EMSeriesTable table;
+	table.Build(stations);
+
+	EMStationIndex index;
+	index.Build(stations);
+
+	EMCorrelationGraph graph;
+	graph.Build(table, index, INFILL_CUTOFF_KM, INFILL_MIN_OVERLAP,
+		INFILL_MIN_CORRELATION);
+
+	EMHomogenizer homogenizer(table, graph);
+	homogenizer.Run();
+	CHECK(homogenizer.TestedCount() == TEST_STATIONS);
+
+	breaks = homogenizer.Breakpoints();
+	homogenizer.Store();
+}
+
+
+TEST(HomogenizeOneBreak)
+{
+	std::vector<std::unique_ptr<Station> > owned;
+	std::vector<Station*> clean, broken;
+	std::vector<EMBreakpoint> noise, found;
+
+	_Region(0, owned, clean);
+	_Homogenize(clean, noise);
+
+	_Region(TEST_BREAK_SIZE, owned, broken);
+	_Homogenize(broken, found);
+
+	// found must be noise plus the real break, in station order
+	int32 real = 0;
+	size_t n = 0;
+	for (const auto& breakpoint : found) {
+		if (breakpoint.station == TEST_BREAK_STATION
+			&& breakpoint.year == TEST_BREAK_YEAR) {
+			CHECK(fabs(breakpoint.shift - TEST_BREAK_SIZE) < 0.1);
+			++real;
+			continue;
+		}
+
+		bool matched = n < noise.size()
+			&& noise[n].station == breakpoint.station
+			&& noise[n].year == breakpoint.year
+			&& fabs(noise[n].shift - breakpoint.shift) < 0.02;
+		if (!matched) {
+			printf("\tleaked break: station %li, %li, shift %.3f\n",
+				breakpoint.station, breakpoint.year, breakpoint.shift);
+		}
+		CHECK(matched);
+		++n;
+	}
+	CHECK(real == 1);
+	CHECK(n == noise.size());
+
+	// and the station's values put back on the level after the break
+	const Station* station = broken[TEST_BREAK_STATION];
+	double before = 0, after = 0;
+	for (int32 y = 0; y < TEST_YEARS; ++y) {
+		double& side = station->DATA[y].YEAR < TEST_BREAK_YEAR
+			? before : after;
+		side += station->DATA[y].MonthValue(7);
+	}
+	before /= TEST_BREAK_YEAR - TEST_FIRST_YEAR;
+	after /= TEST_FIRST_YEAR + TEST_YEARS - TEST_BREAK_YEAR;
+	CHECK(fabs(after - before) < 0.5);
+}
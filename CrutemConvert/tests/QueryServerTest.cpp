@@ -0,0 +1,73 @@
+/*
+	EMQueryServer's answers for stations and cells in the western
+	hemisphere, and for temperatures below -99 in Fahrenheit: coordinates
+	are never missing, and only the missing marker is null.
+*/
+
+#include <memory>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "GridPyramid.h"
+#include "QueryServer.h"
+
+#include "Test.h"
+
+
+#define	TEST_YEAR		1990
+
+
+static Station*
+_Station(uint32 id, const char* name, float lat, float lon, float value)
+{	// one year, every month the same
+	Station* station = new Station();
+	station->ID = id;
+	strcpy(station->NAME, name);
+	strcpy(station->COUNTRY, "TESTLAND");
+	station->LAT = lat;
+	station->LON = lon;
+	station->STARTYEAR = TEST_YEAR;
+	station->ENDYEAR = TEST_YEAR + 1;
+	station->DATA = new YearData[1];
+	station->DATA[0].VALID = true;
+	station->DATA[0].YEAR = TEST_YEAR;
+	for (int16 m = 1; m <= 12; ++m)
+		station->DATA[0].SetMonthValue(m, value);
+
+	return station;
+}
+
+
+TEST(QueryServerWestern)
+{
+	std::vector<std::unique_ptr<Station> > owned;
+	owned.emplace_back(_Station(100235, "WESTON AIRPORT", 42.5, -122.5, 10));
+	owned.emplace_back(_Station(100236, "POLE CAMP", -80, -150, -80));
+	owned.back()->DATA[0].SetMonthValue(6, SERIES_MISSING);
+
+	std::vector<Station*> stations;
+	for (const auto& station : owned)
+		stations.push_back(station.get());
+
+	EMGridPyramid pyramid(5.0);
+	pyramid.Build(stations);
+
+	EMQueryServer server(stations, pyramid, Fahrenheit);
+
+	std::string cell = server.Answer("cell 40 -120 1990 1990");
+	CHECK(cell.find("\"west\":-125,\"north\":45,\"east\":-120,"
+		"\"south\":40}") != std::string::npos);
+	CHECK(cell.find("null") == std::string::npos);
+
+	std::string station = server.Answer("station airport");
+	CHECK(station.find("\"id\":100235") != std::string::npos);
+	CHECK(station.find("\"lat\":42.5,\"lon\":-122.5") != std::string::npos);
+
+	// -112 F is a temperature; only June, missing, is null
+	std::string cold = server.Answer("cell -80 -150 1990 1990");
+	size_t null = cold.find("null");
+	CHECK(cold.find("\"ok\":true") != std::string::npos);
+	CHECK(null != std::string::npos
+		&& cold.find("null", null + 1) == std::string::npos);
+}
@@ -0,0 +1,115 @@
+/*
+	Station::AverageFor() over whole months, against the month loop it
+	replaced, which averaged the single month AverageFor(EMDate) over the
+	range.  They agree wherever every month was measured.  Elsewhere that
+	loop was wrong: it skipped the first year, counted years not VALID,
+	filled months outside the years from AVERAGES one month off, took a
+	missing month (0 K, which IsValid() accepts) as -273.15 C, and divided
+	0 by 0 for an empty range.
+*/
+
+#include <math.h>
+
+#include "StationListFormat.h"
+
+#include "Test.h"
+
+
+#define	TEST_FIRST_YEAR		1950
+#define	TEST_YEARS			10
+
+
+static void
+_Fill(Station& station)
+{	// 1950 - 1959, 1955 not VALID, March 1957 missing
+	station.STARTYEAR = TEST_FIRST_YEAR;
+	station.ENDYEAR = TEST_FIRST_YEAR + TEST_YEARS;
+	station.DATA = new YearData[TEST_YEARS];
+
+	for (int32 y = 0; y < TEST_YEARS; ++y) {
+		YearData& yd = station.DATA[y];
+		yd.VALID = y != 5;
+		yd.YEAR = TEST_FIRST_YEAR + y;
+		for (int16 m = 1; m <= 12; ++m)
+			yd.SetMonthValue(m, y * 0.5 + m - 6.25);
+	}
+	station.DATA[7].SetMonthValue(3, -99.9);
+
+	for (int32 m = 0; m < 12; ++m)
+		station.AVERAGES[m] = 100 + m;
+}
+
+
+static double
+_MonthLoop(Station& station, int32 fromYear, int32 toYear)
+{	// the old AverageFor(EMDate, EMDate, true), in Celsius
+	double accum = 0.0;
+	float count = 0;
+
+	for (EMDate from = _year(fromYear) << _month(1),
+		to = _year(toYear) << _month(1); from < to; from += 1_month) {
+		EMTemperature temp = station.AverageFor(from, true);
+		if (temp.IsValid()) {
+			accum += temp.toCelsius();
+			count += 1;
+		}
+	}
+
+	return accum / count;
+}
+
+
+static double
+_Range(Station& station, int32 fromYear, int32 toYear)
+{	// in Celsius; no months in range comes back as absolute zero
+	return station.AverageFor(_year(fromYear) << _month(1),
+		_year(toYear) << _month(1), true).toCelsius();
+}
+
+
+static bool
+_Near(double a, double b)
+{
+	return fabs(a - b) < 1e-4;
+}
+
+
+TEST(StationRangeAverage)
+{
+	Station station;
+	_Fill(station);
+	const double none = (0.0_kelvin).toCelsius();
+
+	// every month measured: as before, and as the month index range
+	CHECK(_Near(_Range(station, 1951, 1955), _MonthLoop(station, 1951, 1955)));
+	CHECK(_Near(_Range(station, 1956, 1957), _MonthLoop(station, 1956, 1957)));
+	CHECK(_Near(_Range(station, 1951, 1955), station.AverageFor(
+		EMMonthIndex(1951, 1), EMMonthIndex(1955, 1)).toCelsius()));
+
+	// the first year counts; it used to come from AVERAGES
+	double first = 0;
+	for (int16 m = 1; m <= 12; ++m)
+		first += station.DATA[0].MonthValue(m);
+	CHECK(_Near(_Range(station, 1950, 1951), first / 12));
+	CHECK(!_Near(_Range(station, 1950, 1951), _MonthLoop(station, 1950, 1951)));
+
+	// a missing month is left out, not taken as absolute zero
+	double measured = 0;
+	for (int16 m = 1; m <= 12; ++m)
+		measured += m == 3 ? 0 : station.DATA[7].MonthValue(m);
+	CHECK(_Near(_Range(station, 1957, 1958), measured / 11));
+	CHECK(_Near(_MonthLoop(station, 1957, 1958), (measured + none) / 12));
+
+	// a year not VALID doesn't count, where it used to
+	CHECK(_Range(station, 1955, 1956) == none);
+	CHECK(_MonthLoop(station, 1955, 1956) != none);
+
+	// nor do months outside the station's years
+	CHECK(_Range(station, 1940, 1950) == none);
+	CHECK(_Near(_Range(station, 1940, 1952), _Range(station, 1950, 1952)));
+	CHECK(_Range(station, 1960, 1970) == none);
+
+	// an empty range has no months, rather than 0 / 0
+	CHECK(_Range(station, 1953, 1953) == none);
+	CHECK(isnan(_MonthLoop(station, 1953, 1953)));
+}
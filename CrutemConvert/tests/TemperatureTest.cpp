@@ -0,0 +1,62 @@
+/*
+	The batch conversions' idea of a missing value, which depends on the
+	scale being converted from, and LParseScale()'s idea of a scale name.
+*/
+
+#include <math.h>
+
+#include "SeriesTable.h"
+#include "Temperature.h"
+
+#include "Test.h"
+
+
+TEST(TemperatureMissing)
+{
+	// Celsius: at or below -99 is missing, whatever it is
+	float celsius[] = { -99.9f, -99.0f, -120.0f, -89.2f, 0.0f };
+	float out[5];
+	LConvertTemperatures(Celsius, Fahrenheit, celsius, out, 5);
+	CHECK(out[0] == -99.9f);
+	CHECK(out[1] == -99.0f);
+	CHECK(out[2] == -120.0f);
+	CHECK(fabs(out[3] - -128.56f) < 0.01);
+	CHECK(fabs(out[4] - 32.0f) < 0.01);
+
+	// Fahrenheit: the Antarctic plateau is colder than -99 F, so only the
+	// sentinel is missing
+	float fahrenheit[] = { (float)SERIES_MISSING, -99.0f, -128.56f, 32.0f };
+	LConvertTemperatures(Fahrenheit, Celsius, fahrenheit, out, 4);
+	CHECK(out[0] == (float)SERIES_MISSING);
+	CHECK(fabs(out[1] - -72.78f) < 0.01);
+	CHECK(fabs(out[2] - -89.2f) < 0.01);
+	CHECK(fabs(out[3]) < 0.01);
+
+	// and round trips, missing values included
+	LConvertTemperatures(Celsius, Fahrenheit, celsius, out, 5);
+	LConvertTemperatures(Fahrenheit, Celsius, out, out, 5);
+	CHECK(out[0] == -99.9f && out[3] > -89.21f && out[3] < -89.19f);
+
+	float baseline[] = { -100.0f, -100.0f, (float)SERIES_MISSING, -100.0f };
+	LSubtractBaseline(fahrenheit, baseline, out, 4, Fahrenheit);
+	CHECK(out[0] == -99.9f);
+	CHECK(fabs(out[1] - 1.0f) < 0.01);
+	CHECK(out[2] == -99.9f);
+	CHECK(fabs(out[3] - 132.0f) < 0.01);
+}
+
+
+TEST(TemperatureParseScale)
+{
+	TScale scale = Kelvin;
+	CHECK(LParseScale("C", scale) && scale == Celsius);
+	CHECK(LParseScale("fahrenheit", scale) && scale == Fahrenheit);
+	CHECK(LParseScale("Kelvin", scale) && scale == Kelvin);
+	CHECK(LParseScale("f", scale) && scale == Fahrenheit);
+
+	CHECK(!LParseScale("cheese", scale) && scale == Fahrenheit);
+	CHECK(!LParseScale("kelvins", scale));
+	CHECK(!LParseScale("", scale));
+	CHECK(!LParseScale(nullptr, scale));
+	CHECK(scale == Fahrenheit);
+}
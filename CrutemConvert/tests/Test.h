@@ -0,0 +1,40 @@
+#ifndef EM_TEST_H
+#define EM_TEST_H
+
+#include "StdTypedefs.h"
+
+/*
+	Just enough of a test harness for crucon-tests.  Each TEST() registers
+	itself, and CHECK() reports a failure without stopping the test:
+
+		TEST(DateRoundTrip)
+		{
+			CHECK(EMDate::FromEpochDay(0).Year() == 1970);
+		}
+
+	crucon-tests runs them all, or only those whose names contain its
+	argument, and exits with 1 if any check failed.
+*/
+
+typedef void (*LTestFunc)();
+
+
+class	EMTestCase {
+public:
+								EMTestCase(const char* name, LTestFunc);
+};
+
+
+bool	LTestCheck		(bool passed, const char* expression,
+							const char* file, int line);
+
+#define	TEST(name)														\
+	static void name();													\
+	static EMTestCase name##Case(#name, name);							\
+	static void name()
+
+#define	CHECK(expression)												\
+	LTestCheck((expression), #expression, __FILE__, __LINE__)
+
+
+#endif // EM_TEST_H
@@ -0,0 +1,75 @@
+/*
+	crucon-tests
+		Regression tests for the parts of crucon whose results other code
+		depends on:
+
+			crucon-tests [name]
+
+		Runs every test, or those whose names contain name.  The exit code
+		is 1 if any check failed.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "Test.h"
+
+
+struct _Test {
+	const char*			name;
+	LTestFunc			func;
+};
+
+
+static std::vector<_Test>&
+_Tests()
+{	// built up by the EMTestCase statics, before main()
+	static std::vector<_Test> tests;
+	return tests;
+}
+
+
+static int32 sFailures = 0;
+
+
+EMTestCase	::	EMTestCase(const char* name, LTestFunc func)
+{
+	_Test test = { name, func };
+	_Tests().push_back(test);
+}
+
+
+bool	LTestCheck(bool passed, const char* expression, const char* file,
+			int line)
+{
+	if (!passed) {
+		printf("\t%s:%i: CHECK(%s) failed\n", file, line, expression);
+		++sFailures;
+	}
+	return passed;
+}
+
+
+int main(int argc, char** argv)
+{
+	const char* filter = argc > 1 ? argv[1] : "";
+	int32 run = 0, failed = 0;
+
+	for (const auto& test : _Tests()) {
+		if (strstr(test.name, filter) == NULL)
+			continue;
+
+		int32 before = sFailures;
+		test.func();
+		++run;
+
+		bool passed = sFailures == before;
+		if (!passed)
+			++failed;
+		printf("%s %s\n", passed ? "PASS" : "FAIL", test.name);
+	}
+
+	printf("%li of %li tests passed\n", run - failed, run);
+	return failed > 0 ? 1 : 0;
+}